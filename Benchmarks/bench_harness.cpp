@@ -0,0 +1,422 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            bench_harness.cpp
+// @brief           Implementation of the microbenchmark harness
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // sort
+#include <chrono>                       // steady_clock
+#include <cmath>                        // sqrt
+#include <cstdio>                       // printf
+#include <cstdlib>                      // malloc, free
+#include <cstring>                      // strncmp
+#include <ctime>                        // gmtime
+#include <fstream>                      // ofstream
+#include <iostream>                     // cerr
+#include <new>                          // operator new
+//
+#include "bench_harness.h"              // Harness header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+// Allocation accounting
+//
+// Every allocation made by the benchmark process goes through these, so the
+// library's own allocations are counted without any change to the library.
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    thread_local Bench::AllocCounters tAllocs;
+    Bench::AllocHook gAllocHook = nullptr;
+
+    inline void* CountedAlloc(std::size_t size)
+    {
+        tAllocs.count++;
+        tAllocs.bytes += size;
+        if (gAllocHook != nullptr) { gAllocHook(size); }
+        void* p = std::malloc(size == 0 ? 1 : size);
+        if (p == nullptr) { throw std::bad_alloc(); }
+        return p;
+    }
+
+    inline void* CountedAlignedAlloc(std::size_t size, std::align_val_t align)
+    {
+        tAllocs.count++;
+        tAllocs.bytes += size;
+        if (gAllocHook != nullptr) { gAllocHook(size); }
+        std::size_t a = static_cast<std::size_t>(align);
+#ifdef _WIN32
+        void* p = _aligned_malloc(size == 0 ? 1 : size, a);
+#else
+        std::size_t rounded = ((size == 0 ? 1 : size) + a - 1) / a * a;
+        void* p = std::aligned_alloc(a, rounded);
+#endif
+        if (p == nullptr) { throw std::bad_alloc(); }
+        return p;
+    }
+
+    inline void AlignedFree(void* p)
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+};
+
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { AlignedFree(p); }
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    AllocCounters ThreadAllocs()
+    {
+        return tAllocs;
+    }
+
+    void SetAllocHook(AllocHook hook)
+    {
+        gAllocHook = hook;
+    }
+
+    /// @brief Per-op share of each site between two running totals, largest first
+    static std::vector<AllocSite> SiteDelta(const std::vector<AllocSite>& before,
+        const std::vector<AllocSite>& after, uint64_t iterations)
+    {
+        std::vector<AllocSite> delta;
+        for (const AllocSite& a : after)
+        {
+            AllocSite d = a;
+            for (const AllocSite& b : before)
+            {
+                if (b.name == a.name)
+                {
+                    d.allocs -= b.allocs;
+                    d.bytes -= b.bytes;
+                    break;
+                }
+            }
+
+            if (d.allocs > 0)
+            {
+                d.allocs /= static_cast<double>(iterations);
+                d.bytes /= static_cast<double>(iterations);
+                delta.push_back(d);
+            }
+        }
+
+        std::sort(delta.begin(), delta.end(), [](const AllocSite& x, const AllocSite& y) { return x.bytes > y.bytes; });
+        return delta;
+    }
+
+    /// @brief Time 'iterations' runs of the body in nanoseconds
+    static double TimeBody(const Body& body, uint64_t iterations)
+    {
+        Clock::time_point start = Clock::now();
+        body(iterations);
+        Clock::time_point end = Clock::now();
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    /// @brief Percentile of a sorted vector, nearest rank
+    static double Percentile(const std::vector<double>& sorted, double pct)
+    {
+        if (sorted.empty()) { return 0; }
+        size_t rank = static_cast<size_t>(std::ceil(pct / 100.0 * sorted.size()));
+        if (rank == 0) { rank = 1; }
+        if (rank > sorted.size()) { rank = sorted.size(); }
+        return sorted[rank - 1];
+    }
+
+    /// @brief Escape a string for JSON output
+    static std::string JsonEscape(const std::string& in)
+    {
+        std::string out;
+        out.reserve(in.size() + 2);
+        for (char c : in)
+        {
+            switch (c)
+            {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        return out;
+    }
+
+    void Harness::Add(const std::string& name, uint64_t inputBytes, Body body)
+    {
+        Case c;
+        c.name = name;
+        c.inputBytes = inputBytes;
+        c.body = body;
+        mCases.push_back(c);
+    }
+
+    void Harness::AddOption(const std::string& key, const std::string& help, std::string* value)
+    {
+        mOptions.push_back({ key, help, value });
+    }
+
+    bool Harness::ParseArgs(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            std::string key = arg.substr(0, eq);
+            std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+                 if (key == "--filter")      mConfig.filter = value;
+            else if (key == "--json")        mConfig.jsonPath = value;
+            else if (key == "--samples")     mConfig.samples = static_cast<unsigned>(std::max(1, std::atoi(value.c_str())));
+            else if (key == "--min-time-ms") mConfig.minTimeMs = std::max(0.1, std::atof(value.c_str()));
+            else if (key == "--latency-ops") mConfig.latencyOps = static_cast<uint64_t>(std::max(0LL, std::atoll(value.c_str())));
+            else if (key == "--list")        mConfig.list = true;
+            else
+            {
+                bool found = false;
+                for (const Option& o : mOptions)
+                {
+                    if (o.key == key)
+                    {
+                        *o.value = value;
+                        found = true;
+                    }
+                }
+
+                if (!found)
+                {
+                    std::cerr << "Usage: " << argv[0] << " [--filter=substr] [--json=path] [--samples=N]"
+                        " [--min-time-ms=N] [--latency-ops=N] [--list]\n";
+                    for (const Option& o : mOptions)
+                    {
+                        std::cerr << "    " << o.key << "=...  " << o.help << "\n";
+                    }
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    Result Harness::Measure(const Case& c)
+    {
+        Result r;
+        r.name = c.name;
+        r.inputBytes = c.inputBytes;
+
+        // Warm up caches and any lazily built state; one op is enough for a
+        // case that is a whole export
+        const double targetNs = mConfig.minTimeMs * 1e6;
+        if (TimeBody(c.body, 1) < targetNs)
+        {
+            c.body(15);
+        }
+
+        // Calibrate: grow the batch until it is long enough to time, then scale to target
+        uint64_t iterations = 1;
+        double elapsed = TimeBody(c.body, iterations);
+        while (elapsed < targetNs / 10 && iterations < (1ULL << 40))
+        {
+            iterations *= 4;
+            elapsed = TimeBody(c.body, iterations);
+        }
+        double perOp = elapsed / static_cast<double>(iterations);
+        iterations = std::max<uint64_t>(1, static_cast<uint64_t>(targetNs / std::max(perOp, 0.01)));
+        r.iterations = iterations;
+
+        // Timed batches
+        for (unsigned s = 0; s < mConfig.samples; s++)
+        {
+            r.samples.push_back(TimeBody(c.body, iterations) / static_cast<double>(iterations));
+        }
+
+        std::vector<double> sorted = r.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double v : sorted) { sum += v; }
+        r.nsPerOp = sum / sorted.size();
+        r.nsMin = sorted.front();
+        r.nsMax = sorted.back();
+        r.nsMedian = Percentile(sorted, 50);
+        double var = 0;
+        for (double v : sorted) { var += (v - r.nsPerOp) * (v - r.nsPerOp); }
+        r.nsStdDev = sorted.size() > 1 ? std::sqrt(var / (sorted.size() - 1)) : 0;
+        r.opsPerSec = r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0;
+        r.mbPerSec = r.nsPerOp > 0 ? (static_cast<double>(c.inputBytes) / r.nsPerOp) * 1e3 : 0;
+
+        // Allocation pass, outside of the timed batches
+        uint64_t allocIterations = std::min<uint64_t>(iterations, 1000);
+        std::vector<AllocSite> sitesBefore;
+        if (mAllocSites) { sitesBefore = mAllocSites(); }
+        AllocCounters before = ThreadAllocs();
+        c.body(allocIterations);
+        AllocCounters after = ThreadAllocs();
+        r.allocsPerOp = static_cast<double>(after.count - before.count) / allocIterations;
+        r.bytesPerOp = static_cast<double>(after.bytes - before.bytes) / allocIterations;
+        if (mAllocSites) { r.allocSites = SiteDelta(sitesBefore, mAllocSites(), allocIterations); }
+
+        // Latency pass, each op timed on its own. Slow ops stop it once it has
+        // taken as long as the timed batches, after at least 10 ops.
+        if (mConfig.latencyOps > 0)
+        {
+            const double budgetNs = targetNs * mConfig.samples;
+            double spent = 0;
+            std::vector<double> lat;
+            lat.reserve(mConfig.latencyOps);
+            for (uint64_t i = 0; i < mConfig.latencyOps && (i < 10 || spent < budgetNs); i++)
+            {
+                lat.push_back(TimeBody(c.body, 1));
+                spent += lat.back();
+            }
+            std::sort(lat.begin(), lat.end());
+            r.latP50 = Percentile(lat, 50);
+            r.latP90 = Percentile(lat, 90);
+            r.latP99 = Percentile(lat, 99);
+            r.latP999 = Percentile(lat, 99.9);
+            r.latMax = lat.back();
+        }
+
+        return r;
+    }
+
+    void Harness::PrintResult(const Result& r) const
+    {
+        std::printf("%-44s %12.1f %8.1f%% %10.2f %10.1f %9.2f %10.0f %10.0f\n",
+            r.name.c_str(), r.nsPerOp, r.nsPerOp > 0 ? 100.0 * r.nsStdDev / r.nsPerOp : 0.0,
+            r.mbPerSec, r.bytesPerOp, r.allocsPerOp, r.latP50, r.latP99);
+        for (const AllocSite& site : r.allocSites)
+        {
+            std::printf("  %-42s %12s %9s %10s %10.1f %9.2f\n", site.name.c_str(), "", "", "", site.bytes, site.allocs);
+        }
+        std::fflush(stdout);
+    }
+
+    bool Harness::WriteJSON(const std::string& suite, const std::string& version) const
+    {
+        std::ofstream out(mConfig.jsonPath);
+        if (!out)
+        {
+            std::cerr << "ERROR: Could not open " << mConfig.jsonPath << " for writing\n";
+            return false;
+        }
+
+        char stamp[32] = "";
+        std::time_t now = std::time(nullptr);
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        out.precision(17);
+        out << "{\n";
+        out << "  \"suite\": \"" << JsonEscape(suite) << "\",\n";
+        out << "  \"version\": \"" << JsonEscape(version) << "\",\n";
+        out << "  \"timestamp\": \"" << stamp << "\",\n";
+        out << "  \"config\": {\"samples\": " << mConfig.samples << ", \"min_time_ms\": " << mConfig.minTimeMs
+            << ", \"latency_ops\": " << mConfig.latencyOps << "},\n";
+        out << "  \"benchmarks\": [";
+        for (size_t i = 0; i < mResults.size(); i++)
+        {
+            const Result& r = mResults[i];
+            out << (i ? ",\n" : "\n");
+            out << "    {\"name\": \"" << JsonEscape(r.name) << "\""
+                << ", \"iterations\": " << r.iterations
+                << ", \"input_bytes\": " << r.inputBytes
+                << ", \"ns_per_op\": " << r.nsPerOp
+                << ", \"ns_min\": " << r.nsMin
+                << ", \"ns_median\": " << r.nsMedian
+                << ", \"ns_max\": " << r.nsMax
+                << ", \"ns_stddev\": " << r.nsStdDev
+                << ", \"ops_per_sec\": " << r.opsPerSec
+                << ", \"mb_per_sec\": " << r.mbPerSec
+                << ", \"bytes_per_op\": " << r.bytesPerOp
+                << ", \"allocs_per_op\": " << r.allocsPerOp;
+            if (!r.allocSites.empty())
+            {
+                out << ", \"alloc_sites\": [";
+                for (size_t s = 0; s < r.allocSites.size(); s++)
+                {
+                    const AllocSite& site = r.allocSites[s];
+                    out << (s ? ", " : "") << "{\"site\": \"" << JsonEscape(site.name) << "\""
+                        << ", \"bytes_per_op\": " << site.bytes << ", \"allocs_per_op\": " << site.allocs << "}";
+                }
+                out << "]";
+            }
+            out << ", \"latency_ns\": {\"p50\": " << r.latP50 << ", \"p90\": " << r.latP90
+                << ", \"p99\": " << r.latP99 << ", \"p999\": " << r.latP999 << ", \"max\": " << r.latMax << "}"
+                << ", \"samples_ns_per_op\": [";
+            for (size_t s = 0; s < r.samples.size(); s++)
+            {
+                out << (s ? ", " : "") << r.samples[s];
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    int Harness::Run(const std::string& suite, const std::string& version)
+    {
+        if (mConfig.list)
+        {
+            for (const Case& c : mCases) { std::printf("%s\n", c.name.c_str()); }
+            return 0;
+        }
+
+        std::printf("%s - %s\n", suite.c_str(), version.c_str());
+        std::printf("%-44s %12s %9s %10s %10s %9s %10s %10s\n",
+            "Benchmark", "ns/op", "+/-", "MB/s", "B/op", "allocs/op", "p50 ns", "p99 ns");
+
+        mResults.clear();
+        for (const Case& c : mCases)
+        {
+            if (!mConfig.filter.empty() && c.name.find(mConfig.filter) == std::string::npos)
+            {
+                continue;
+            }
+            mResults.push_back(Measure(c));
+            PrintResult(mResults.back());
+        }
+
+        if (!mConfig.jsonPath.empty() && !WriteJSON(suite, version))
+        {
+            return 1;
+        }
+
+        return 0;
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            bench_harness.h
+// @brief           A small self-contained microbenchmark harness reporting
+//                  ns/op, allocated bytes/op and allocations/op with JSON output
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint64_t
+#include <functional>                       // function
+#include <string>                           // string
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Bench
+{
+    /// @brief Running totals of heap allocations made by the calling thread.
+    ///        Maintained by the replacement operator new in bench_harness.cpp.
+    struct AllocCounters
+    {
+        uint64_t count = 0;         /// Number of allocations
+        uint64_t bytes = 0;         /// Number of bytes requested
+    };
+
+    /// @brief Get the allocation totals of the calling thread
+    AllocCounters ThreadAllocs();
+
+    /// @brief Called by the replacement operator new with the size of every
+    ///        allocation, e.g. to forward it to a profiler. Must not allocate.
+    using AllocHook = void (*)(std::size_t bytes);
+
+    /// @brief Install an allocation hook, nullptr to remove. Set before Run().
+    void SetAllocHook(AllocHook hook);
+
+    /// @brief Allocations charged to one named site, e.g. a library phase
+    struct AllocSite
+    {
+        std::string name;
+        double      allocs = 0;     /// Allocations (running total, or per op in a Result)
+        double      bytes = 0;      /// Bytes requested (running total, or per op in a Result)
+    };
+
+    /// @brief Returns running per-site totals. The harness diffs two calls made
+    ///        around the allocation pass to get each site's share per op.
+    using AllocSiteSource = std::function<std::vector<AllocSite>()>;
+
+    /// @brief Keep the compiler from optimizing away a value
+    template <typename T>
+    inline void DoNotOptimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    /// @brief Benchmark body. Must run the measured operation 'iterations' times.
+    using Body = std::function<void(uint64_t iterations)>;
+
+    /// @brief A registered benchmark
+    struct Case
+    {
+        std::string name;               /// Unique name, "Group/Variant"
+        uint64_t    inputBytes = 0;     /// Bytes of input consumed by one op, for throughput
+        Body        body;               /// Measured body
+    };
+
+    /// @brief Measurement result of one case
+    struct Result
+    {
+        std::string         name;
+        uint64_t            iterations = 0;     /// Iterations per sample
+        uint64_t            inputBytes = 0;     /// Input bytes per op
+        double              nsPerOp = 0;        /// Mean ns/op across samples
+        double              nsMin = 0;          /// Fastest sample ns/op
+        double              nsMedian = 0;       /// Median sample ns/op
+        double              nsMax = 0;          /// Slowest sample ns/op
+        double              nsStdDev = 0;       /// Sample standard deviation of ns/op
+        double              opsPerSec = 0;      /// 1e9 / nsPerOp
+        double              mbPerSec = 0;       /// Input throughput in MB/s (1e6 bytes)
+        double              bytesPerOp = 0;     /// Heap bytes requested per op
+        double              allocsPerOp = 0;    /// Heap allocations per op
+        std::vector<AllocSite> allocSites;      /// Per-site allocations per op, largest first
+        double              latP50 = 0;         /// Single-op latency percentiles (ns)
+        double              latP90 = 0;
+        double              latP99 = 0;
+        double              latP999 = 0;
+        double              latMax = 0;
+        std::vector<double> samples;            /// Per-sample ns/op
+    };
+
+    /// @brief Run configuration
+    struct Config
+    {
+        unsigned        samples = 15;           /// Number of timed batches per case
+        double          minTimeMs = 20;         /// Target duration of one batch
+        uint64_t        latencyOps = 5000;      /// Individually timed ops for percentiles, fewer for slow ops
+        std::string     filter;                 /// Substring filter on case names
+        std::string     jsonPath;               /// Write JSON results here if not empty
+        bool            list = false;           /// List cases and exit
+    };
+
+    class Harness
+    {
+    public:
+
+        /// @brief Register a benchmark case
+        /// @param name       - [in] - unique case name
+        /// @param inputBytes - [in] - bytes of input per op (0 if not meaningful)
+        /// @param body       - [in] - measured body
+        void Add(const std::string& name, uint64_t inputBytes, Body body);
+
+        /// @brief Register an extra "--key=value" command line option
+        /// @param key   - [in]  - option name including the leading dashes
+        /// @param help  - [in]  - one line description for the usage text
+        /// @param value - [out] - receives the option value
+        void AddOption(const std::string& key, const std::string& help, std::string* value);
+
+        /// @brief Break each case's allocations down by site (see AllocSiteSource)
+        void SetAllocSiteSource(AllocSiteSource source) { mAllocSites = std::move(source); }
+
+        /// @brief Parse command line options into the configuration
+        /// @return false if the arguments were bad or help was requested
+        bool ParseArgs(int argc, char** argv);
+
+        /// @brief Run every case matching the filter, print a table and write JSON
+        /// @return 0 on success, non-zero on error
+        int Run(const std::string& suite, const std::string& version);
+
+        /// @brief Access the results of the last Run()
+        const std::vector<Result>& Results() const { return mResults; }
+
+    private:
+        Result Measure(const Case& c);
+        void PrintResult(const Result& r) const;
+        bool WriteJSON(const std::string& suite, const std::string& version) const;
+
+        struct Option
+        {
+            std::string     key;
+            std::string     help;
+            std::string*    value;
+        };
+
+        Config              mConfig;
+        std::vector<Case>   mCases;
+        std::vector<Option> mOptions;
+        std::vector<Result> mResults;
+        AllocSiteSource     mAllocSites;
+    };
+};
@@ -0,0 +1,983 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_benchmark.cpp
+// @brief           Microbenchmarks for every COT_Utility entry point
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <array>                        // array
+#include <cmath>                        // cos, sin
+#include <cstdlib>                      // strtoull, strtod
+#include <deque>                        // deque
+#include <iomanip>                      // setw, setfill
+#include <memory>                       // shared_ptr
+#include <sstream>                      // stringstream
+#include <string>                       // string
+#include <unordered_map>                // unordered_map
+#include <utility>                      // pair
+#include <iostream>                     // cerr
+#include <vector>                       // vector
+//
+#include "bench_harness.h"              // Harness
+#include "cot_alloc_profile.h"          // Allocation phases
+#include "cot_chat.h"                   // ChatStore
+#include "cot_corpus.h"                 // Synthetic corpus
+#include "cot_format.h"                 // Timestamp writers
+#include "cot_geofence.h"               // Geofences
+#include "cot_json.h"                   // JsonWriter, JsonStream
+#include "cot_kml.h"                    // KmlStream
+#include "cot_metrics.h"                // Metrics registry
+#include "cot_peek.h"                   // Header peek
+#include "cot_shape.h"                  // Vertex extractor, Simplifier
+#include "cot_template.h"               // COTTemplate
+#include "cot_trace.h"                  // Trace rings
+#include "cot_utility.h"                // COT_Utility
+#include "cot_utility_access.h"         // Private sub-parsers
+#include "cot_validate.h"               // Validation tiers
+#include "cot_view.h"                   // COTView
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief Representative WinTAK position report (same content as Examples.cpp)
+    const char* kMessage =
+        "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>"
+        "<event version=\"2.0\" uid=\"S-1-5-21-2515255310-331139352-785488330-3297\" type=\"a-f-G-E-V-A\" time=\"2022-12-22T18:06:59.36Z\" start=\"2022-12-22T18:06:59.36Z\" stale=\"2022-12-22T18:08:14.36Z\" how=\"h-e\">"
+        "<point lat=\"31.5990919461411\" lon=\"-81.7768698985248\" hae=\"9999999\" ce=\"9999999\" le=\"9999999\"/>"
+        "<detail>"
+        "<takv version=\"4.1.0.231\" platform=\"WinTAK-CIV\" os=\"Microsoft Windows 10 Pro\" device=\"Dell Inc. XPS 15 9510\"/>"
+        "<contact callsign=\"ASEIRS\" endpoint=\"tcpsrcreply:4242:srctcp\" xmppUsername=\"\"/>"
+        "<precisionlocation altsrc=\"???\" geopointsrc=\"USER\"/>"
+        "<uid Droid=\"ASEIRS\"/><__group name=\"Blue\" role=\"HQ\"/><status battery=\"100\"/>"
+        "<track course=\"0.00000000\" speed=\"0.00000000\"/></detail></event>";
+
+    /// @brief pugixml allocates with malloc by default; route it through operator new
+    ///        so its document pages show up in the allocation counts.
+    void* PugiAllocate(size_t size) { return ::operator new(size); }
+    void PugiDeallocate(void* ptr) { ::operator delete(ptr); }
+
+    /// @brief Transport garbage seen ahead of the XML declaration on some links
+    const char* kGarbage = "\x01\x7f\x13\x22(\x10'BE\x05\x06\x07";
+
+    void RegisterEntryPoints(Bench::Harness& h, COT_Utility& c)
+    {
+        std::string message = kMessage;
+        std::string prefixed = std::string(kGarbage) + kMessage;
+
+        // Per-case state lives in the (mutable) lambda captures so that setup is not
+        // measured. ParseCOT(std::string&) strips the prefix in place, so each op
+        // restores the buffer first; assign() reuses the capacity and does not allocate.
+        h.Add("ParseCOT/string", prefixed.size(), [&c, prefixed, buffer = std::string(), cot = COTSchema()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                buffer.assign(prefixed);
+                Bench::DoNotOptimize(c.ParseCOT(buffer, cot));
+            }
+        });
+
+        h.Add("ParseCOT/char*", prefixed.size(), [&c, prefixed, cot = COTSchema()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(c.ParseCOT(prefixed.c_str(), cot));
+            }
+        });
+
+        h.Add("ParseBufferToCOT", prefixed.size(), [&c, prefixed](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                COTSchema cot = c.ParseBufferToCOT(prefixed.c_str());
+                Bench::DoNotOptimize(cot);
+            }
+        });
+
+        COTSchema parsed = c.ParseBufferToCOT(kMessage);
+
+        h.Add("GenerateXMLCOTMessage", 0, [&c, parsed](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                std::string out = c.GenerateXMLCOTMessage(parsed);
+                Bench::DoNotOptimize(out);
+            }
+        });
+
+        h.Add("UpdateReceivedCOTMessage", message.size(), [&c, message, parsed, modified = std::string()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(c.UpdateReceivedCOTMessage(message, parsed, modified, true));
+            }
+        });
+
+        h.Add("AcknowledgeReceivedCOTMessage", message.size(), [&c, message, response = std::string()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(c.AcknowledgeReceivedCOTMessage(message, response));
+            }
+        });
+
+        h.Add("VerifyXML", message.size(), [&c, message](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(c.VerifyXML(message));
+            }
+        });
+    }
+
+    void RegisterSubParsers(Bench::Harness& h, COT_Utility& c)
+    {
+        h.Add("Sub/ParseTimeAttribute", 23, [&c, time = std::string("2022-12-22T18:06:59.36Z"), dt = DateTime()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(COT_UtilityAccess::ParseTimeAttribute(c, time, dt));
+            }
+        });
+
+        h.Add("Sub/ParseDateStamp", 10, [&c, date = std::string("2022-12-22"), dt = DateTime()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(COT_UtilityAccess::ParseDateStamp(c, date, dt));
+            }
+        });
+
+        h.Add("Sub/ParseTimeStamp", 12, [&c, time = std::string("18:06:59.36Z"), dt = DateTime()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(COT_UtilityAccess::ParseTimeStamp(c, time, dt));
+            }
+        });
+
+        h.Add("Sub/ParseTypeAttribute", 11, [&c, type = std::string("a-f-G-E-V-A")](uint64_t n) mutable
+        {
+            Point::Type ind;
+            Location::Type loc;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(COT_UtilityAccess::ParseTypeAttribute(c, type, ind, loc));
+            }
+        });
+
+        h.Add("Sub/ParseHowAttribute", 3, [&c, how = std::string("h-e")](uint64_t n) mutable
+        {
+            How::Entry::Type entry;
+            How::Data::Type data;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(COT_UtilityAccess::ParseHowAttribute(c, how, entry, data));
+            }
+        });
+
+        // Every affiliation in turn, so the lookups are not one predicted branch
+        h.Add("Sub/Enums/TypeToString", 1, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Point::TypeToString.at(static_cast<Point::Type>(i % Point::TypeToString.size())));
+            }
+        });
+
+        h.Add("Sub/Enums/CodeToType", 1, [codes = std::array<std::string, 11>{ "p", "u", "a", "f", "n", "s", "h", "j", "k", "o", "x" }](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Point::CodeToType(codes[i % codes.size()]));
+            }
+        });
+
+        h.Add("Sub/Enums/StringToType", 8, [names = std::array<std::string, 6>{ "Space", "Air", "Ground", "Sea Surface", "Sea Subsurface", "Other" }](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Location::StringToType(names[i % names.size()]));
+            }
+        });
+    }
+
+    /// @brief A u-d-f drawing of 'vertices' points along a wandering path, the
+    ///        points written to full precision as ATAK sends them
+    std::string MakeShapeMessage(size_t vertices)
+    {
+        std::string out =
+            "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>"
+            "<event version=\"2.0\" uid=\"0b5c5f9e-shape\" type=\"u-d-f\" time=\"2022-12-22T18:06:59.36Z\" start=\"2022-12-22T18:06:59.36Z\" stale=\"2022-12-23T18:06:59.36Z\" how=\"h-e\">"
+            "<point lat=\"31.5990919461411\" lon=\"-81.7768698985248\" hae=\"9999999\" ce=\"9999999\" le=\"9999999\"/>"
+            "<detail><contact callsign=\"Route 1\"/>";
+
+        Corpus::Random random(7);
+        double lat = 31.5990919461411, lon = -81.7768698985248, heading = 0;
+        for (size_t i = 0; i < vertices; i++)
+        {
+            heading += random.Uniform(-0.3, 0.3);
+            lat += 1e-4 * std::cos(heading);
+            lon += 1e-4 * std::sin(heading);
+            out += "<link point=\"";
+            Format::AppendFixed(out, lat, 9);
+            out += ',';
+            Format::AppendFixed(out, lon, 9);
+            out += ",0.0\"/>";
+        }
+        out += "<strokeColor value=\"-1\"/><strokeWeight value=\"3.0\"/></detail></event>";
+        return out;
+    }
+
+    /// @brief Large drawings: the full parse, the parse without vertices, the raw
+    ///        vertex extractor and simplification for display
+    void RegisterShapes(Bench::Harness& h, COT_Utility& c)
+    {
+        for (size_t vertices : { 100, 1000, 10000 })
+        {
+            const std::string message = MakeShapeMessage(vertices);
+            const std::string suffix = "/n=" + std::to_string(vertices);
+
+            h.Add("Shape/ParseCOT" + suffix, message.size(), [&c, message, buffer = std::string(), cot = COTSchema()](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    buffer.assign(message);
+                    Bench::DoNotOptimize(c.ParseCOT(buffer, cot));
+                }
+            });
+
+            h.Add("Shape/ParseCOT/noShape" + suffix, message.size(), [&c, message, buffer = std::string(), cot = COTSchema()](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    buffer.assign(message);
+                    Bench::DoNotOptimize(c.ParseCOT(buffer, cot, ParseOptions::All & ~ParseOptions::Shape));
+                }
+            });
+
+            h.Add("Shape/Extract" + suffix, message.size(), [message, shape = Shape()](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    Bench::DoNotOptimize(Vertices::Extract(message, shape));
+                }
+            });
+
+            Shape shape;
+            Vertices::Extract(message, shape);
+            h.Add("Shape/Simplify/5m" + suffix, 0, [shape, simplifier = Vertices::Simplifier(), out = Shape()](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    Bench::DoNotOptimize(simplifier.Run(shape, 5.0, out));
+                }
+            });
+        }
+    }
+
+    /// @brief A GeoChat message as ATAK sends it, message 'i' of 'rooms' rooms
+    ///        and 'senders' senders, one second apart
+    std::string MakeChatMessage(size_t i, size_t rooms, size_t senders)
+    {
+        const std::string room = "Room " + std::to_string(i % rooms);
+        const std::string uid = "ANDROID-" + std::to_string(1000 + i % senders);
+        const std::string callsign = "CALLSIGN-" + std::to_string(i % senders);
+        const std::string stamp = DateTime(2022, 12, 22, 18, static_cast<int>(i / 60 % 60), static_cast<double>(i % 60)).ToCOTTimestamp();
+        return "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>"
+            "<event version=\"2.0\" uid=\"GeoChat." + uid + "." + room + "." + std::to_string(i) + "\" type=\"b-t-f\" time=\"" + stamp +
+            "\" start=\"" + stamp + "\" stale=\"" + stamp + "\" how=\"h-g-i-g-o\">"
+            "<point lat=\"31.5990919461411\" lon=\"-81.7768698985248\" hae=\"9999999\" ce=\"9999999\" le=\"9999999\"/><detail>"
+            "<__chat parent=\"RootContactGroup\" groupOwner=\"false\" messageId=\"" + std::to_string(i) + "\" chatroom=\"" + room + "\" id=\"" + room +
+            "\" senderCallsign=\"" + callsign + "\"><chatgrp uid0=\"" + uid + "\" uid1=\"" + room + "\" id=\"" + room + "\"/></__chat>"
+            "<link uid=\"" + uid + "\" type=\"a-f-G-U-C\" relation=\"p-p\"/>"
+            "<remarks source=\"BAO.F.ATAK." + uid + "\" to=\"" + room + "\" time=\"" + stamp + "\">moving to the checkpoint, message " +
+            std::to_string(i) + "</remarks></detail></event>";
+    }
+
+    /// @brief GeoChat history: storing parsed messages, paging a room and a
+    ///        sender, against reparsing the room's raw messages for each page
+    void RegisterChat(Bench::Harness& h, COT_Utility& c)
+    {
+        const size_t rooms = 8, senders = 64, count = 4000, page = 50;
+
+        auto raw = std::make_shared<std::vector<std::string>>();
+        auto parsed = std::make_shared<std::vector<COTSchema>>();
+        for (size_t i = 0; i < count; i++)
+        {
+            raw->push_back(MakeChatMessage(i, rooms, senders));
+            std::string buffer = raw->back();
+            parsed->emplace_back();
+            c.ParseCOT(buffer, parsed->back());
+        }
+
+        auto store = std::make_shared<ChatStore>();
+        for (const COTSchema& cot : *parsed) { store->Add(cot); }
+
+        h.Add("Chat/Add", 0, [parsed, store = std::make_shared<ChatStore>(), i = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t k = 0; k < n; k++, i++)
+            {
+                if (i == parsed->size())
+                {
+                    store->Clear();
+                    i = 0;
+                }
+                Bench::DoNotOptimize(store->Add((*parsed)[i]));
+            }
+        });
+
+        h.Add("Chat/History/page=50", 0, [store, out = std::vector<ChatStore::Message>()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                out.clear();
+                ChatStore::Cursor cursor = ChatStore::Cursor::Latest();
+                Bench::DoNotOptimize(store->History("Room 3", cursor, page, out));
+            }
+        });
+
+        h.Add("Chat/BySender/page=50", 0, [store, out = std::vector<ChatStore::Message>()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                out.clear();
+                ChatStore::Cursor cursor = ChatStore::Cursor::Latest();
+                Bench::DoNotOptimize(store->BySender("ANDROID-1003", cursor, page, out));
+            }
+        });
+
+        // What a page costs when only the raw messages of the room are kept
+        std::vector<std::string> room;
+        for (size_t i = 3; i < count; i += rooms) { room.push_back((*raw)[i]); }
+        h.Add("Chat/History/reparse", 0, [&c, room, buffer = std::string(), cot = COTSchema(), out = std::vector<std::string>()](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                out.clear();
+                for (size_t k = room.size(); k-- > 0 && out.size() < page;)
+                {
+                    buffer.assign(room[k]);
+                    if (c.ParseCOT(buffer, cot) == 1)
+                    {
+                        out.push_back(cot.detail.remarks.text);
+                    }
+                }
+                Bench::DoNotOptimize(out.size());
+            }
+        });
+    }
+
+    /// @brief Geofences: 10000 tracks moving through 1000 and 10000 polygon and
+    ///        circle fences of 200 m to 2 km over a 2 by 2 degree area, with the
+    ///        grid and with every fence in one cell
+    void RegisterGeofences(Bench::Harness& h)
+    {
+        const size_t tracks = 10000, points = 1 << 16;
+        auto uids = std::make_shared<std::vector<std::string>>();
+        for (size_t i = 0; i < tracks; i++) { uids->push_back("ANDROID-" + std::to_string(100000 + i)); }
+
+        // Tracks wander a few hundred metres per report
+        Corpus::Random random(11);
+        auto reports = std::make_shared<std::vector<std::pair<uint32_t, Point::Data>>>();
+        std::vector<Point::Data> at(tracks);
+        for (Point::Data& p : at) { p = Point::Data(30 + random.Uniform(0, 2), -80 + random.Uniform(0, 2)); }
+        for (size_t i = 0; i < points; i++)
+        {
+            const uint32_t track = static_cast<uint32_t>(random.Range(0, tracks - 1));
+            at[track].latitude += random.Uniform(-0.003, 0.003);
+            at[track].longitude += random.Uniform(-0.003, 0.003);
+            reports->emplace_back(track, at[track]);
+        }
+
+        for (size_t count : { 1000, 10000 })
+        {
+            for (double cell : { 0.05, 360.0 })
+            {
+                auto fences = std::make_shared<Geofences>(cell);
+                Corpus::Random shapes(13);
+                std::vector<double> lat, lon;
+                for (size_t i = 0; i < count; i++)
+                {
+                    const double y = 30 + shapes.Uniform(0, 2), x = -80 + shapes.Uniform(0, 2);
+                    const double radius = shapes.Uniform(200, 2000);
+                    if (shapes.Chance(0.3))
+                    {
+                        fences->AddCircle("zone", y, x, radius);
+                        continue;
+                    }
+
+                    const size_t vertices = static_cast<size_t>(shapes.Range(8, 32));
+                    lat.clear();
+                    lon.clear();
+                    for (size_t k = 0; k < vertices; k++)
+                    {
+                        const double angle = 6.283185307179586 * k / vertices;
+                        const double r = radius * shapes.Uniform(0.5, 1.0);
+                        lat.push_back(y + r / 110574.0 * std::sin(angle));
+                        lon.push_back(x + r / (111320.0 * std::cos(y * 3.14159265358979323846 / 180.0)) * std::cos(angle));
+                    }
+                    fences->AddPolygon("zone", lat.data(), lon.data(), vertices);
+                }
+
+                const std::string name = std::string("Geofence/Update") + (cell < 360 ? "" : "/nogrid") + "/fences=" + std::to_string(count);
+                h.Add(name, 0, [fences, uids, reports, out = std::vector<Geofences::Crossing>(), i = size_t(0)](uint64_t n) mutable
+                {
+                    for (uint64_t k = 0; k < n; k++, i++)
+                    {
+                        const auto& report = (*reports)[i & (points - 1)];
+                        out.clear();
+                        Bench::DoNotOptimize(fences->Update((*uids)[report.first], report.second, out));
+                    }
+                });
+            }
+        }
+    }
+
+    /// @brief Reading the point, track and status reals, against the strtod that
+    ///        pugi::xml_attribute::as_double calls
+    void RegisterReals(Bench::Harness& h)
+    {
+        const std::vector<std::string> texts = { "31.5990919461411", "-81.7768698985248", "9999999", "9999999.0",
+            "0.00000000", "263.1234567", "4.25", "100", "12.0", "-0.5" };
+        size_t bytes = 0;
+        for (const std::string& t : texts) { bytes += t.size(); }
+        bytes /= texts.size();
+
+        h.Add("Real/strtod", bytes, [texts](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(std::strtod(texts[i % texts.size()].c_str(), nullptr));
+            }
+        });
+
+        h.Add("Real/ReadReal", bytes, [texts](uint64_t n)
+        {
+            double value;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Format::ReadReal(texts[i % texts.size()].c_str(), value));
+                Bench::DoNotOptimize(value);
+            }
+        });
+    }
+
+    /// @brief Timestamp output, against the stringstream formatting it replaced
+    void RegisterTimestamps(Bench::Harness& h)
+    {
+        const DateTime stamp(2022, 12, 22, 18, 6, 59.36);
+
+        h.Add("Timestamp/stringstream", 23, [stamp](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                std::stringstream timestamp;
+                timestamp << std::setfill('0') << std::setw(4) << stamp.year << "-"
+                    << std::setfill('0') << std::setw(2) << stamp.month << "-"
+                    << std::setfill('0') << std::setw(2) << stamp.day << "T"
+                    << std::setfill('0') << std::setw(2) << stamp.hour << ":"
+                    << std::setfill('0') << std::setw(2) << stamp.minute << ":"
+                    << std::setfill('0') << std::setw(5) << std::fixed << std::setprecision(2) << stamp.second << "Z";
+                Bench::DoNotOptimize(timestamp.str());
+            }
+        });
+
+        h.Add("Timestamp/ToCOTTimestamp", 23, [stamp](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(stamp.ToCOTTimestamp());
+            }
+        });
+
+        h.Add("Timestamp/WriteTimestamp", 23, [civil = stamp.ToCivil()](uint64_t n) mutable
+        {
+            char buffer[Format::MaxTimestamp];
+            for (uint64_t i = 0; i < n; i++)
+            {
+                civil.second = static_cast<double>(i % 6000) / 100.0;
+                Bench::DoNotOptimize(Format::WriteTimestamp(buffer, civil));
+            }
+        });
+
+        h.Add("Timestamp/TimestampWriter", 23, [civil = stamp.ToCivil()](uint64_t n) mutable
+        {
+            Format::TimestampWriter writer;
+            char buffer[Format::MaxTimestamp];
+            for (uint64_t i = 0; i < n; i++)
+            {
+                civil.second = static_cast<double>(i % 6000) / 100.0;
+                Bench::DoNotOptimize(writer.Write(buffer, civil));
+            }
+        });
+
+        h.Add("Timestamp/TimestampWriter/epoch", 24, [](uint64_t n)
+        {
+            Format::TimestampWriter writer(3);
+            char buffer[Format::MaxTimestamp];
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(writer.Write(buffer, 1671732419 + static_cast<int64_t>(i >> 10), static_cast<uint32_t>(i * 1000003 % 1000000000)));
+            }
+        });
+
+        h.Add("Timestamp/DateTime::NowPlus", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(DateTime::NowPlus(75));
+            }
+        });
+    }
+
+    /// @brief Cost of the metrics primitives the library calls on every operation.
+    ///        Compare against the ParseCOT ns/op to judge the instrumentation overhead.
+    void RegisterMetrics(Bench::Harness& h)
+    {
+        h.Add("Metrics/Add", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Metrics::Add(Metrics::Counter::ParseCalls);
+            }
+        });
+
+        h.Add("Metrics/Record", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Metrics::Record(Metrics::Op::Parse, 1000 + (i & 0xffff));
+            }
+        });
+
+        h.Add("Metrics/ScopedTimer", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Metrics::ScopedTimer timer(Metrics::Op::Parse);
+            }
+        });
+
+        h.Add("Metrics/ScopedTimer/disabled", 0, [](uint64_t n)
+        {
+            Metrics::SetEnabled(false);
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Metrics::ScopedTimer timer(Metrics::Op::Parse);
+            }
+            Metrics::SetEnabled(true);
+        });
+
+        h.Add("Metrics/Take", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Metrics::Snapshot snap = Metrics::Take();
+                Bench::DoNotOptimize(snap);
+            }
+        });
+    }
+
+    /// @brief Cost of one trace span, compiled in or switched off at runtime
+    void RegisterTrace(Bench::Harness& h)
+    {
+        h.Add("Trace/ScopedSpan", 0, [](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Trace::ScopedSpan span("bench");
+            }
+        });
+
+        h.Add("Trace/ScopedSpan/disabled", 0, [](uint64_t n)
+        {
+            Trace::SetEnabled(false);
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Trace::ScopedSpan span("bench");
+            }
+            Trace::SetEnabled(true);
+        });
+    }
+
+    /// @brief Benchmarks that cycle through a corpus of mixed traffic rather than
+    ///        one fixed message. Input bytes are the corpus mean message size.
+    void RegisterCorpus(Bench::Harness& h, COT_Utility& c, const std::vector<std::string>& corpus)
+    {
+        if (corpus.empty())
+        {
+            return;
+        }
+
+        uint64_t total = 0;
+        for (const std::string& m : corpus) { total += m.size(); }
+        const uint64_t mean = total / corpus.size();
+
+        h.Add("Corpus/ParseCOT", mean, [&c, &corpus, buffer = std::string(), cot = COTSchema(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                buffer.assign(corpus[next]);
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(c.ParseCOT(buffer, cot));
+            }
+        });
+
+        // Selective parses, against Corpus/ParseCOT (every part)
+        const std::pair<const char*, uint32_t> masks[] =
+        {
+            { "Corpus/ParseCOT/MapDisplay", ParseOptions::MapDisplay },
+            { "Corpus/ParseCOT/Routing",    ParseOptions::Routing },
+            { "Corpus/ParseCOT/Point",      ParseOptions::Point },
+            { "Corpus/ParseCOT/Detail",     ParseOptions::Detail },
+            { "Corpus/ParseCOT/none",       0 }
+        };
+        for (const auto& mask : masks)
+        {
+            h.Add(mask.first, mean, [&c, &corpus, options = mask.second, buffer = std::string(), cot = COTSchema(), next = size_t(0)](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    buffer.assign(corpus[next]);
+                    next = (next + 1 == corpus.size()) ? 0 : next + 1;
+                    Bench::DoNotOptimize(c.ParseCOT(buffer, cot, options));
+                }
+            });
+        }
+
+        // Header filtered parses: the peek alone, then at the corpus' own drop rate
+        h.Add("Corpus/PeekHeader", mean, [&corpus, header = Peek::Header(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Peek::PeekHeader(corpus[next], header));
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+            }
+        });
+
+        const std::pair<const char*, Peek::Filter> filters[] =
+        {
+            { "Corpus/ParseCOT/filter=all",     [](const Peek::Header&) { return true; } },
+            { "Corpus/ParseCOT/filter=a-f",     [](const Peek::Header& hd) { return hd.TypeStartsWith("a-f"); } },
+            { "Corpus/ParseCOT/filter=none",    [](const Peek::Header&) { return false; } }
+        };
+        for (const auto& filter : filters)
+        {
+            h.Add(filter.first, mean, [&c, &corpus, accept = filter.second, buffer = std::string(), cot = COTSchema(), next = size_t(0)](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    buffer.assign(corpus[next]);
+                    next = (next + 1 == corpus.size()) ? 0 : next + 1;
+                    Bench::DoNotOptimize(c.ParseCOT(buffer, cot, accept));
+                }
+            });
+        }
+
+        // Zero-copy view: the scan alone, a routing check on it, then the owning
+        // schema built from it, against Corpus/ParseCOT
+        h.Add("Corpus/COTView/Parse", mean, [&corpus, view = COTView(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(view.Parse(corpus[next]));
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+            }
+        });
+        h.Add("Corpus/COTView/Parse/trusted", mean, [&corpus, view = COTView(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(view.Parse(corpus[next], false) > 0 && view.event.TypeStartsWith("a-f"));
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+            }
+        });
+        h.Add("Corpus/COTView/Materialize", mean, [&corpus, view = COTView(), cot = COTSchema(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                if (view.Parse(corpus[next]) > 0)
+                {
+                    view.Materialize(cot);
+                }
+                Bench::DoNotOptimize(cot);
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+            }
+        });
+
+        // Validation tiers: each check alone, then ParseCOT running them
+        h.Add("Validate/WellFormed", mean, [&corpus, issue = Validate::Issue(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Validate::CheckWellFormed(corpus[next], issue));
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+            }
+        });
+
+        auto documents = std::make_shared<std::deque<pugi::xml_document>>();
+        for (const std::string& m : corpus)
+        {
+            documents->emplace_back().load_string(m.c_str());
+        }
+        h.Add("Validate/Strict", mean, [documents, issue = Validate::Issue(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(Validate::CheckStrict((*documents)[next], issue));
+                next = (next + 1 == documents->size()) ? 0 : next + 1;
+            }
+        });
+
+        const std::pair<const char*, uint32_t> tiers[] =
+        {
+            { "Corpus/ParseCOT/validate=Trusted",    Validate::Trusted },
+            { "Corpus/ParseCOT/validate=Legacy",     Validate::Legacy },
+            { "Corpus/ParseCOT/validate=WellFormed", Validate::WellFormed },
+            { "Corpus/ParseCOT/validate=Untrusted",  Validate::Untrusted }
+        };
+        for (const auto& tier : tiers)
+        {
+            COT_Utility tiered;
+            tiered.SetValidation(tier.second);
+            h.Add(tier.first, mean, [tiered, &corpus, buffer = std::string(), cot = COTSchema(), next = size_t(0)](uint64_t n) mutable
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    buffer.assign(corpus[next]);
+                    next = (next + 1 == corpus.size()) ? 0 : next + 1;
+                    Bench::DoNotOptimize(tiered.ParseCOT(buffer, cot));
+                }
+            });
+        }
+
+        h.Add("Corpus/VerifyXML", mean, [&c, &corpus, buffer = std::string(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                buffer.assign(corpus[next]);
+                next = (next + 1 == corpus.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(c.VerifyXML(buffer));
+            }
+        });
+
+        std::vector<COTSchema> parsed;
+        for (const std::string& m : corpus)
+        {
+            std::string buffer = m;
+            COTSchema cot;
+            if (c.ParseCOT(buffer, cot) > 0) { parsed.push_back(cot); }
+        }
+
+        h.Add("Validate/Semantic", 0, [parsed, issue = Validate::Issue(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                Bench::DoNotOptimize(Validate::CheckSemantic(parsed[next], issue));
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+            }
+        });
+
+        h.Add("Corpus/GenerateXMLCOTMessage", 0, [&c, parsed, next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                std::string out = c.GenerateXMLCOTMessage(parsed[next]);
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(out);
+            }
+        });
+
+        // One template per entity, compiled from its first report
+        std::vector<COTTemplate> templates;
+        std::vector<size_t> templateOf;
+        std::unordered_map<std::string, size_t> entities;
+        for (const COTSchema& cot : parsed)
+        {
+            auto it = entities.find(cot.event.uid);
+            if (it == entities.end())
+            {
+                it = entities.emplace(cot.event.uid, templates.size()).first;
+                templates.emplace_back(cot);
+            }
+            templateOf.push_back(it->second);
+        }
+
+        h.Add("Corpus/COTTemplate", 0, [parsed, templates, templateOf, out = std::string(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                templates[templateOf[next]].Render(parsed[next], out);
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(out);
+            }
+        });
+
+        h.Add("Corpus/COTTemplate/compile", 0, [parsed, next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                COTTemplate t(parsed[next]);
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(t);
+            }
+        });
+
+        // JSON export: one message into a reused string, then a 100k track
+        // FeatureCollection streamed through a 64 KiB buffer. Bytes are output.
+        h.Add("Corpus/Json/Object", 0, [parsed, writer = JsonWriter(), out = std::string(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                out.clear();
+                writer.AppendObject(out, parsed[next]);
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(out);
+            }
+        });
+
+        h.Add("Corpus/Json/Feature", 0, [parsed, writer = JsonWriter(), out = std::string(), next = size_t(0)](uint64_t n) mutable
+        {
+            for (uint64_t i = 0; i < n && !parsed.empty(); i++)
+            {
+                out.clear();
+                writer.AppendFeature(out, parsed[next]);
+                next = (next + 1 == parsed.size()) ? 0 : next + 1;
+                Bench::DoNotOptimize(out);
+            }
+        });
+
+        const size_t tracks = 100000;
+        auto exportTracks = [parsed, tracks]()
+        {
+            uint64_t bytes = 0;
+            JsonStream stream(JsonStream::Layout::FeatureCollection, [&bytes](const char*, size_t size) { bytes += size; });
+            for (size_t i = 0; i < tracks && !parsed.empty(); i++)
+            {
+                stream.Add(parsed[i % parsed.size()]);
+            }
+            stream.Finish();
+            return bytes;
+        };
+        h.Add("Corpus/Json/FeatureCollection/100k", exportTracks(), [exportTracks](uint64_t n)
+        {
+            for (uint64_t i = 0; i < n; i++)
+            {
+                Bench::DoNotOptimize(exportTracks());
+            }
+        });
+
+        // KML export of the same 100k tracks as text, stored KMZ and deflated
+        // KMZ. Bytes are the KML text, so MB/s compares the three.
+        const std::pair<const char*, KmlStream::Container> containers[] =
+        {
+            { "Corpus/Kml/100k",            KmlStream::Container::Kml },
+            { "Corpus/Kmz/Stored/100k",     KmlStream::Container::KmzStored },
+            { "Corpus/Kmz/Deflate/100k",    KmlStream::Container::KmzDeflate }
+        };
+        uint64_t kmlBytes = 0;
+        for (const auto& container : containers)
+        {
+            auto exportKml = [parsed, tracks, container = container.second]()
+            {
+                uint64_t bytes = 0;
+                KmlStream stream([&bytes](const char*, size_t size) { bytes += size; }, container);
+                for (size_t i = 0; i < tracks && !parsed.empty(); i++)
+                {
+                    stream.Add(parsed[i % parsed.size()]);
+                }
+                stream.Finish();
+                return bytes;
+            };
+            kmlBytes = (kmlBytes == 0) ? exportKml() : kmlBytes;
+            h.Add(container.first, kmlBytes, [exportKml](uint64_t n)
+            {
+                for (uint64_t i = 0; i < n; i++)
+                {
+                    Bench::DoNotOptimize(exportKml());
+                }
+            });
+        }
+    }
+};
+
+int main(int argc, char** argv)
+{
+    pugi::set_memory_management_functions(PugiAllocate, PugiDeallocate);
+
+    Bench::Harness harness;
+#ifdef COT_ENABLE_ALLOC_PROFILE
+    // Break allocations down by library phase
+    Bench::SetAllocHook(AllocProfile::OnAllocate);
+    harness.SetAllocSiteSource([]()
+    {
+        std::vector<Bench::AllocSite> sites;
+        for (const AllocProfile::Site& s : AllocProfile::Take())
+        {
+            Bench::AllocSite site;
+            site.name = s.name;
+            site.allocs = static_cast<double>(s.allocs);
+            site.bytes = static_cast<double>(s.bytes);
+            sites.push_back(site);
+        }
+        return sites;
+    });
+#endif
+    std::string corpusPath;
+    std::string corpusSeed = "1";
+    std::string tracePath;
+    harness.AddOption("--corpus", "framed corpus file from cot_corpus_gen (default: generated)", &corpusPath);
+    harness.AddOption("--corpus-seed", "seed of the generated corpus (default 1)", &corpusSeed);
+    harness.AddOption("--trace", "write the last spans of each thread as Chrome trace JSON", &tracePath);
+    if (!harness.ParseArgs(argc, argv))
+    {
+        return 2;
+    }
+
+    // Mixed traffic: generated in process unless a corpus file is given
+    static std::vector<std::string> corpus;
+    if (!corpusPath.empty())
+    {
+        if (!Corpus::ReadFramed(corpusPath, corpus))
+        {
+            std::cerr << "ERROR: Could not read corpus " << corpusPath << "\n";
+            return 1;
+        }
+    }
+    else
+    {
+        Corpus::Config config;
+        config.seed = std::strtoull(corpusSeed.c_str(), nullptr, 10);
+        config.garbageRate = 0.2;
+        Corpus::Generator generator(config);
+        for (Corpus::Message& m : generator.Generate(2000)) { corpus.push_back(std::move(m.xml)); }
+    }
+
+    COT_Utility c;
+    RegisterEntryPoints(harness, c);
+    RegisterSubParsers(harness, c);
+    RegisterCorpus(harness, c, corpus);
+    RegisterShapes(harness, c);
+    RegisterChat(harness, c);
+    RegisterGeofences(harness);
+    RegisterReals(harness);
+    RegisterTimestamps(harness);
+    RegisterMetrics(harness);
+    RegisterTrace(harness);
+
+    const int result = harness.Run("COT_Utility", c.GetVersion());
+
+    if (!tracePath.empty() && !Trace::WriteChromeTrace(tracePath))
+    {
+        std::cerr << "ERROR: Could not write trace " << tracePath << "\n";
+        return 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,163 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_alloc_profile.cpp
+// @brief           Implementation of the COT Utility allocation profiler
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // sort
+#include <atomic>                       // atomic
+#include <cstring>                      // strcmp
+//
+#include "cot_alloc_profile.h"          // Profiler header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace AllocProfile
+{
+    namespace
+    {
+        const char* const kOther = "(other)";
+
+        /// @brief Single writer table of per-phase totals, keyed by name pointer.
+        ///        Lives in static storage so OnAllocate() never allocates, and
+        ///        outlives its thread so Take() can still read it.
+        struct Table
+        {
+            std::atomic<const char*>    key[MaxSites];
+            std::atomic<uint64_t>       allocs[MaxSites];
+            std::atomic<uint64_t>       bytes[MaxSites];
+        };
+
+        Table gTables[MaxThreads];
+        std::atomic<unsigned> gNextTable(0);
+
+        thread_local const char* tPhase = nullptr;
+
+        Table* ThreadTable()
+        {
+            thread_local Table* table = nullptr;
+            thread_local bool claimed = false;
+            if (!claimed)
+            {
+                claimed = true;
+                const unsigned index = gNextTable.fetch_add(1, std::memory_order_relaxed);
+                if (index < MaxThreads)
+                {
+                    table = &gTables[index];
+                }
+            }
+            return table;
+        }
+
+        /// @brief Slot for a phase, claiming an empty one on first use
+        unsigned Slot(Table& table, const char* name)
+        {
+            unsigned i = static_cast<unsigned>((reinterpret_cast<uintptr_t>(name) >> 3) * 0x9E3779B1u) % (MaxSites - 1);
+            for (unsigned probe = 0; probe < MaxSites - 1; probe++)
+            {
+                const char* key = table.key[i].load(std::memory_order_relaxed);
+                if (key == name)
+                {
+                    return i;
+                }
+                if (key == nullptr)
+                {
+                    table.key[i].store(name, std::memory_order_release);
+                    return i;
+                }
+                i = (i + 1) % (MaxSites - 1);
+            }
+
+            // Table full: the last slot is reserved for everything else
+            table.key[MaxSites - 1].store(kOther, std::memory_order_release);
+            return MaxSites - 1;
+        }
+    };
+
+    void OnAllocate(std::size_t bytes)
+    {
+        const char* phase = tPhase;
+        if (phase == nullptr)
+        {
+            return;
+        }
+
+        Table* table = ThreadTable();
+        if (table == nullptr)
+        {
+            return;
+        }
+
+        // Single writer: plain load + store is enough, readers only need untorn values
+        const unsigned slot = Slot(*table, phase);
+        table->allocs[slot].store(table->allocs[slot].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        table->bytes[slot].store(table->bytes[slot].load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    }
+
+    const char* Enter(const char* name)
+    {
+        const char* previous = tPhase;
+        tPhase = name;
+        return previous;
+    }
+
+    void Leave(const char* previous)
+    {
+        tPhase = previous;
+    }
+
+    std::vector<Site> Take()
+    {
+        // Collected with no phase active so this function's own allocations are not charged
+        const char* saved = Enter(nullptr);
+
+        std::vector<Site> sites;
+        const unsigned tables = std::min(gNextTable.load(std::memory_order_relaxed), MaxThreads);
+        for (unsigned t = 0; t < tables; t++)
+        {
+            const Table& table = gTables[t];
+            for (unsigned i = 0; i < MaxSites; i++)
+            {
+                const char* key = table.key[i].load(std::memory_order_acquire);
+                if (key == nullptr)
+                {
+                    continue;
+                }
+
+                // The same literal may have different addresses in different translation units
+                auto it = std::find_if(sites.begin(), sites.end(),
+                    [key](const Site& s) { return s.name == key || std::strcmp(s.name, key) == 0; });
+                if (it == sites.end())
+                {
+                    sites.push_back(Site{ key, 0, 0 });
+                    it = sites.end() - 1;
+                }
+                it->allocs += table.allocs[i].load(std::memory_order_relaxed);
+                it->bytes += table.bytes[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        std::sort(sites.begin(), sites.end(), [](const Site& a, const Site& b) { return a.bytes > b.bytes; });
+
+        Leave(saved);
+        return sites;
+    }
+
+    void Reset()
+    {
+        for (Table& table : gTables)
+        {
+            for (unsigned i = 0; i < MaxSites; i++)
+            {
+                table.allocs[i].store(0, std::memory_order_relaxed);
+                table.bytes[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
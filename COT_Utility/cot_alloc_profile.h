@@ -0,0 +1,92 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_alloc_profile.h
+// @brief           Optional attribution of heap allocations to the phases of the
+//                  COT Utility operations.
+//
+//                  The library marks its phases with the macros at the bottom of
+//                  this file, which compile to nothing unless
+//                  COT_ENABLE_ALLOC_PROFILE is defined. The library never hooks
+//                  the allocator itself: an application or benchmark that
+//                  replaces operator new calls AllocProfile::OnAllocate() from
+//                  it, and each allocation is charged to the innermost phase
+//                  active on that thread.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint64_t
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace AllocProfile
+{
+    /// @brief Allocation totals of one phase, summed over all threads
+    struct Site
+    {
+        const char* name;           /// Phase name
+        uint64_t    allocs;         /// Number of allocations
+        uint64_t    bytes;          /// Number of bytes requested
+    };
+
+    /// @brief Distinct phases tracked per thread; extras are charged to "(other)"
+    static const unsigned MaxSites = 64;
+
+    /// @brief Most threads that can be tracked. Later threads are not tracked.
+    static const unsigned MaxThreads = 64;
+
+    /// @brief Charge an allocation to the calling thread's current phase. Does
+    ///        nothing outside a phase. Never allocates, so it is safe to call
+    ///        from a replacement operator new.
+    void OnAllocate(std::size_t bytes);
+
+    /// @brief Make 'name' the calling thread's current phase
+    /// @return the phase that was current before
+    const char* Enter(const char* name);
+
+    /// @brief Restore the phase returned by Enter()
+    void Leave(const char* previous);
+
+    /// @brief Running totals of every phase, largest byte count first.
+    ///        Safe while writers run.
+    std::vector<Site> Take();
+
+    /// @brief Zero every total. Not atomic with respect to writers.
+    void Reset();
+
+    /// @brief Makes 'name' the current phase for the lifetime of the scope.
+    ///        Next() switches to another phase, for sequential phases that
+    ///        share one scope.
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(const char* name) : mPrevious(Enter(name)) {}
+        ~ScopedPhase() { Leave(mPrevious); }
+
+        void Next(const char* name) { Enter(name); }
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        const char* mPrevious;
+    };
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+// Instrumentation macros used inside the library
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COT_ENABLE_ALLOC_PROFILE
+#define COT_ALLOC_SCOPE(var, name)  AllocProfile::ScopedPhase cotAlloc_##var(name)
+#define COT_ALLOC_NEXT(var, name)   cotAlloc_##var.Next(name)
+#else
+#define COT_ALLOC_SCOPE(var, name)  do { } while (0)
+#define COT_ALLOC_NEXT(var, name)   do { } while (0)
+#endif
@@ -0,0 +1,295 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_chat.cpp
+// @brief           Implementation of the GeoChat history store
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // lower_bound, upper_bound
+#include <cmath>                        // isfinite
+#include <iterator>                     // prev
+#include <limits>                       // numeric_limits
+//
+#include "cot_chat.h"                   // ChatStore header
+#include "cot_format.h"                 // EpochSeconds
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief Arena slack allowed before a room is compacted
+    const size_t kCompactSlack = 4096;
+
+    /// @brief First non-empty text
+    const std::string& FirstOf(const std::string& a, const std::string& b, const std::string& c)
+    {
+        return !a.empty() ? a : (!b.empty() ? b : c);
+    }
+};
+
+ChatStore::Cursor ChatStore::Cursor::Latest()
+{
+    return Cursor{ std::numeric_limits<double>::infinity(), 0, false };
+}
+
+ChatStore::Cursor ChatStore::Cursor::Before(double epochSeconds)
+{
+    return Cursor{ epochSeconds, 0, false };
+}
+
+ChatStore::ChatStore(const Limits& limits)
+    : mLimits(limits), mNextId(1), mSize(0)
+{
+    mLimits.rooms = std::max<size_t>(mLimits.rooms, 1);
+    mLimits.messagesPerRoom = std::max<size_t>(mLimits.messagesPerRoom, 1);
+}
+
+bool ChatStore::Add(const COTSchema& cot)
+{
+    const Detail& d = cot.detail;
+    if (!d.chat.Valid())
+    {
+        return false;
+    }
+
+    const double time = cot.event.time.IsValid() ? Format::EpochSeconds(cot.event.time.ToCivil()) : 0;
+    return Add(d.chat.chatroom.empty() ? d.remarks.to : d.chat.chatroom,
+        FirstOf(d.chat.chatGroup.uid0, d.link.uid, cot.event.uid),
+        d.chat.senderCallsign, d.chat.messageId, d.remarks.text, time);
+}
+
+bool ChatStore::Add(std::string_view room, std::string_view senderUid, std::string_view senderCallsign,
+    std::string_view messageId, std::string_view body, double time)
+{
+    if (room.empty())
+    {
+        return false;
+    }
+
+    Room& r = Touch(room);
+
+    auto s = mSenders.find(senderUid);
+    if (s == mSenders.end())
+    {
+        std::unique_ptr<Sender> sender(new Sender());
+        sender->uid.assign(senderUid.data(), senderUid.size());
+        const std::string_view key = sender->uid;
+        s = mSenders.emplace(key, std::move(sender)).first;
+    }
+
+    // NaN would break the ordering every index search relies on, and +inf
+    // would hide the message from Cursor::Latest()
+    Entry e;
+    e.key = Key{ std::isfinite(time) ? time : 0, mNextId++ };
+    e.sender = s->second.get();
+    e.offset = r.arena.size();
+    e.callsignLength = static_cast<uint32_t>(senderCallsign.size());
+    e.messageIdLength = static_cast<uint32_t>(messageId.size());
+    e.bodyLength = static_cast<uint32_t>(body.size());
+    r.arena.append(senderCallsign.data(), senderCallsign.size());
+    r.arena.append(messageId.data(), messageId.size());
+    r.arena.append(body.data(), body.size());
+    r.liveBytes += e.Bytes();
+
+    // Nearly always the newest, so the inserts land at the end
+    const auto at = std::upper_bound(r.entries.begin(), r.entries.end(), e.key, [](const Key& k, const Entry& x) { return k < x.key; });
+    r.entries.insert(at, e);
+    std::deque<SenderKey>& keys = e.sender->keys;
+    const SenderKey sk{ e.key, &r };
+    keys.insert(std::upper_bound(keys.begin(), keys.end(), sk), sk);
+    mSize++;
+
+    while (r.entries.size() > 1 && (r.entries.size() > mLimits.messagesPerRoom || r.liveBytes > mLimits.bytesPerRoom))
+    {
+        EvictOldest(r);
+    }
+    if (r.arena.size() > 2 * r.liveBytes + kCompactSlack)
+    {
+        Compact(r);
+    }
+    return true;
+}
+
+size_t ChatStore::History(std::string_view room, Cursor& cursor, size_t limit, std::vector<Message>& out)
+{
+    Room* r = Find(room);
+    if (r == nullptr || cursor.done)
+    {
+        cursor.done = true;
+        return 0;
+    }
+
+    // Everything before 'end' is older than the cursor
+    const Key from{ cursor.time, cursor.id };
+    size_t end = std::lower_bound(r->entries.begin(), r->entries.end(), from, [](const Entry& x, const Key& k) { return x.key < k; }) - r->entries.begin();
+
+    size_t n = 0;
+    for (; end > 0 && n < limit; n++)
+    {
+        const Entry& e = r->entries[--end];
+        out.push_back(View(*r, e));
+        cursor.time = e.key.time;
+        cursor.id = e.key.id;
+    }
+    cursor.done = (end == 0);
+    return n;
+}
+
+size_t ChatStore::BySender(std::string_view senderUid, Cursor& cursor, size_t limit, std::vector<Message>& out)
+{
+    auto s = mSenders.find(senderUid);
+    if (s == mSenders.end() || cursor.done)
+    {
+        cursor.done = true;
+        return 0;
+    }
+
+    const std::deque<SenderKey>& keys = s->second->keys;
+    const SenderKey from{ Key{ cursor.time, cursor.id }, nullptr };
+    size_t end = std::lower_bound(keys.begin(), keys.end(), from) - keys.begin();
+
+    size_t n = 0;
+    for (; end > 0 && n < limit; n++)
+    {
+        const SenderKey& k = keys[--end];
+        const auto e = std::lower_bound(k.room->entries.begin(), k.room->entries.end(), k.key, [](const Entry& x, const Key& key) { return x.key < key; });
+        out.push_back(View(*k.room, *e));
+        cursor.time = k.key.time;
+        cursor.id = k.key.id;
+    }
+    cursor.done = (end == 0);
+    return n;
+}
+
+size_t ChatStore::Between(std::string_view room, double from, double to, std::vector<Message>& out)
+{
+    Room* r = Find(room);
+    if (r == nullptr)
+    {
+        return 0;
+    }
+
+    const auto less = [](const Entry& x, const Key& k) { return x.key < k; };
+    auto it = std::lower_bound(r->entries.begin(), r->entries.end(), Key{ from, 0 }, less);
+    const auto end = std::lower_bound(it, r->entries.end(), Key{ to, 0 }, less);
+    size_t n = 0;
+    for (; it != end; ++it, n++)
+    {
+        out.push_back(View(*r, *it));
+    }
+    return n;
+}
+
+std::vector<std::string_view> ChatStore::Rooms() const
+{
+    std::vector<std::string_view> names;
+    names.reserve(mRooms.size());
+    for (const Room& r : mRooms) { names.push_back(r.name); }
+    return names;
+}
+
+size_t ChatStore::Size() const
+{
+    return mSize;
+}
+
+size_t ChatStore::ArenaBytes() const
+{
+    size_t bytes = 0;
+    for (const Room& r : mRooms) { bytes += r.arena.size(); }
+    return bytes;
+}
+
+void ChatStore::Clear()
+{
+    mRoomIndex.clear();
+    mRooms.clear();
+    mSenders.clear();
+    mSize = 0;
+}
+
+ChatStore::Room& ChatStore::Touch(std::string_view name)
+{
+    auto it = mRoomIndex.find(name);
+    if (it != mRoomIndex.end())
+    {
+        mRooms.splice(mRooms.begin(), mRooms, it->second);
+        return mRooms.front();
+    }
+
+    mRooms.emplace_front();
+    mRooms.front().name.assign(name.data(), name.size());
+    mRoomIndex.emplace(mRooms.front().name, mRooms.begin());
+    if (mRooms.size() > mLimits.rooms)
+    {
+        DropRoom(std::prev(mRooms.end()));
+    }
+    return mRooms.front();
+}
+
+ChatStore::Room* ChatStore::Find(std::string_view name)
+{
+    auto it = mRoomIndex.find(name);
+    if (it == mRoomIndex.end())
+    {
+        return nullptr;
+    }
+    mRooms.splice(mRooms.begin(), mRooms, it->second);
+    return &mRooms.front();
+}
+
+void ChatStore::Unindex(const Entry& entry, Room& room)
+{
+    Sender* sender = entry.sender;
+    std::deque<SenderKey>& keys = sender->keys;
+    const auto it = std::lower_bound(keys.begin(), keys.end(), SenderKey{ entry.key, &room });
+    if (it != keys.end() && it->room == &room)
+    {
+        keys.erase(it);
+    }
+    if (keys.empty())
+    {
+        mSenders.erase(mSenders.find(sender->uid));
+    }
+    room.liveBytes -= entry.Bytes();
+    mSize--;
+}
+
+void ChatStore::EvictOldest(Room& room)
+{
+    Unindex(room.entries.front(), room);
+    room.entries.pop_front();
+}
+
+void ChatStore::DropRoom(RoomList::iterator room)
+{
+    for (const Entry& e : room->entries) { Unindex(e, *room); }
+    mRoomIndex.erase(room->name);
+    mRooms.erase(room);
+}
+
+void ChatStore::Compact(Room& room)
+{
+    std::string arena;
+    arena.reserve(room.liveBytes);
+    for (Entry& e : room.entries)
+    {
+        arena.append(room.arena, e.offset, e.Bytes());
+        e.offset = arena.size() - e.Bytes();
+    }
+    room.arena.swap(arena);
+}
+
+ChatStore::Message ChatStore::View(const Room& room, const Entry& e)
+{
+    const char* text = room.arena.data() + e.offset;
+    return Message{ e.key.id, e.key.time, room.name, e.sender->uid,
+        std::string_view(text, e.callsignLength),
+        std::string_view(text + e.callsignLength, e.messageIdLength),
+        std::string_view(text + e.callsignLength + e.messageIdLength, e.bodyLength) };
+}
@@ -0,0 +1,187 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_chat.h
+// @brief           GeoChat history store, fed by parsed b-t-f messages.
+//
+//                  Each room keeps its messages ordered by time, with the text
+//                  (body, callsign, message id) packed into one arena per room.
+//                  Messages are found by room, by sender uid and by time, and
+//                  paged newest first with a cursor that stays valid while
+//                  messages are added or evicted. Nothing is reparsed.
+//
+//                  Memory is bounded: a room drops its oldest messages past its
+//                  message or byte limit, and past the room limit the least
+//                  recently used room is dropped whole.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint32_t, uint64_t
+#include <deque>                            // deque
+#include <list>                             // list
+#include <memory>                           // unique_ptr
+#include <string>                           // string
+#include <string_view>                      // string_view
+#include <unordered_map>                    // unordered_map
+#include <vector>                           // vector
+//
+#include "cot_info.h"                       // COTSchema
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+class ChatStore
+{
+public:
+
+    /// @brief Memory bounds
+    struct Limits
+    {
+        size_t rooms;               /// Rooms kept, least recently used dropped first
+        size_t messagesPerRoom;     /// Messages kept per room, oldest dropped first
+        size_t bytesPerRoom;        /// Text bytes kept per room, oldest dropped first
+
+        /// @brief Constructor - Initializes Everything
+        Limits(size_t rooms = 256, size_t messagesPerRoom = 1000, size_t bytesPerRoom = 256 * 1024)
+            : rooms(rooms), messagesPerRoom(messagesPerRoom), bytesPerRoom(bytesPerRoom) {}
+    };
+
+    /// @brief A stored message. The views point into the store and are valid
+    ///        until the next Add().
+    struct Message
+    {
+        uint64_t            id;             /// Arrival number, unique in the store
+        double              time;           /// Seconds since the Unix epoch
+        std::string_view    room;
+        std::string_view    senderUid;
+        std::string_view    senderCallsign;
+        std::string_view    messageId;
+        std::string_view    body;
+    };
+
+    /// @brief Position in a newest first listing. Start from Latest() or
+    ///        Before(time); each page moves it past the messages returned.
+    struct Cursor
+    {
+        double      time;           /// Only messages before (time, id) follow
+        uint64_t    id;
+        bool        done;           /// No older messages were left
+
+        static Cursor Latest();
+        static Cursor Before(double epochSeconds);
+    };
+
+    /// @brief Constructor - Initializes Everything
+    explicit ChatStore(const Limits& limits = Limits());
+
+    /// @brief Store a parsed GeoChat message. The room is the __chat chatroom
+    ///        (or the remarks 'to'), the sender the chatgrp uid0 (or the link
+    ///        uid, then the event uid), the body the remarks text and the time
+    ///        the event time.
+    /// @return false if the schema holds no chat
+    bool Add(const COTSchema& cot);
+
+    /// @brief Overloaded - Store a message from its parts. A time that is not
+    ///        finite (NaN or infinite) is stored as 0, as an invalid event time is.
+    /// @return false if the room is empty
+    bool Add(std::string_view room, std::string_view senderUid, std::string_view senderCallsign,
+        std::string_view messageId, std::string_view body, double time);
+
+    /// @brief Up to 'limit' messages of a room older than the cursor, newest first
+    /// @return number of messages appended to 'out'
+    size_t History(std::string_view room, Cursor& cursor, size_t limit, std::vector<Message>& out);
+
+    /// @brief Up to 'limit' messages from one sender, in any room, older than
+    ///        the cursor, newest first
+    /// @return number of messages appended to 'out'
+    size_t BySender(std::string_view senderUid, Cursor& cursor, size_t limit, std::vector<Message>& out);
+
+    /// @brief Messages of a room with from <= time < to, oldest first
+    /// @return number of messages appended to 'out'
+    size_t Between(std::string_view room, double from, double to, std::vector<Message>& out);
+
+    /// @brief Names of the stored rooms, most recently used first
+    std::vector<std::string_view> Rooms() const;
+
+    /// @brief Number of stored messages
+    size_t Size() const;
+
+    /// @brief Bytes held by the room arenas, live and not yet compacted
+    size_t ArenaBytes() const;
+
+    /// @brief Drop everything
+    void Clear();
+
+private:
+    struct Room;
+    struct Sender;
+
+    /// @brief Sort key of a message: by time, then arrival
+    struct Key
+    {
+        double      time;
+        uint64_t    id;
+
+        bool operator<(const Key& other) const
+        {
+            return time < other.time || (time == other.time && id < other.id);
+        }
+    };
+
+    /// @brief A message in its room. The text is arena offsets.
+    struct Entry
+    {
+        Key                 key;
+        Sender*             sender;
+        size_t              offset;         /// Callsign, message id then body
+        uint32_t            callsignLength;
+        uint32_t            messageIdLength;
+        uint32_t            bodyLength;
+
+        size_t Bytes() const { return static_cast<size_t>(callsignLength) + messageIdLength + bodyLength; }
+    };
+
+    /// @brief A message in its sender's index
+    struct SenderKey
+    {
+        Key     key;
+        Room*   room;
+
+        bool operator<(const SenderKey& other) const { return key < other.key; }
+    };
+
+    struct Room
+    {
+        std::string             name;
+        std::deque<Entry>       entries;        /// Sorted by Key
+        std::string             arena;
+        size_t                  liveBytes = 0;  /// Arena bytes still referenced
+    };
+
+    struct Sender
+    {
+        std::string             uid;
+        std::deque<SenderKey>   keys;           /// Sorted by Key
+    };
+
+    using RoomList = std::list<Room>;
+
+    Room& Touch(std::string_view name);
+    Room* Find(std::string_view name);
+    void Unindex(const Entry& entry, Room& room);
+    void EvictOldest(Room& room);
+    void DropRoom(RoomList::iterator room);
+    void Compact(Room& room);
+    static Message View(const Room& room, const Entry& entry);
+
+    Limits                                                                  mLimits;
+    uint64_t                                                                mNextId;
+    size_t                                                                  mSize;
+    RoomList                                                                mRooms;     /// Most recently used first
+    std::unordered_map<std::string_view, RoomList::iterator>                mRoomIndex; /// Keys view Room::name
+    std::unordered_map<std::string_view, std::unique_ptr<Sender>>           mSenders;   /// Keys view Sender::uid
+};
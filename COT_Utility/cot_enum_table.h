@@ -0,0 +1,128 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_enum_table.h
+// @brief           Compile-time text tables for the COT enums.
+//
+//                  A Table holds one string per enum value, indexed by the
+//                  value, so value -> text is an array read. Text -> value goes
+//                  through a perfect hash found by the compiler: every string
+//                  has its own slot, so a lookup is one hash and one compare.
+//                  Tables are constexpr, so they cost nothing at startup and
+//                  are not copied into each translation unit.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <array>                            // array
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint8_t, uint32_t
+#include <stdexcept>                        // out_of_range
+#include <string_view>                      // string_view
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Enums
+{
+    /// @brief Text of each value of E, whose values run from 0 to E::Error
+    template <class E, size_t N>
+    class Table
+    {
+    public:
+        static_assert(static_cast<size_t>(E::Error) + 1 == N, "one string per enum value, Error last");
+        static_assert(N < 0xFF, "slots hold a uint8_t index");
+
+        /// @brief Constructor - Finds the hash seed. An empty string has no
+        ///        text -> value lookup.
+        constexpr explicit Table(const std::array<std::string_view, N>& text)
+            : mText(text), mSeed(0), mSlots{}
+        {
+            for (uint32_t seed = 1; seed < kMaxSeed && mSeed == 0; seed++)
+            {
+                if (Place(seed))
+                {
+                    mSeed = seed;
+                }
+            }
+        }
+
+        /// @brief Text of a value
+        /// @throw std::out_of_range for a value outside the enum, as map::at()
+        constexpr const char* at(E value) const
+        {
+            return static_cast<size_t>(value) < N ? mText[static_cast<size_t>(value)].data() :
+                throw std::out_of_range("Enums::Table::at");
+        }
+
+        /// @brief Value whose text this is
+        /// @return 'missing' if no value has it
+        constexpr E Find(std::string_view text, E missing) const
+        {
+            const uint8_t index = mSlots[Hash(text, mSeed)];
+            return index != kEmpty && mText[index] == text ? static_cast<E>(index) : missing;
+        }
+
+        /// @brief Number of values
+        constexpr size_t size() const
+        {
+            return N;
+        }
+
+        /// @brief A seed was found; checked by a static_assert next to each table
+        constexpr bool Valid() const
+        {
+            return mSeed != 0;
+        }
+
+    private:
+        static constexpr size_t Slots()
+        {
+            size_t slots = 4;
+            while (slots < 2 * N) { slots *= 2; }
+            return slots;
+        }
+
+        static constexpr size_t kSlots = Slots();
+        static constexpr uint8_t kEmpty = 0xFF;
+        static constexpr uint32_t kMaxSeed = 4096;
+
+        /// @brief FNV-1a from a seeded basis, folded to a slot
+        static constexpr size_t Hash(std::string_view text, uint32_t seed)
+        {
+            uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+            for (char c : text)
+            {
+                h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+            }
+            return (h ^ (h >> 16)) & (kSlots - 1);
+        }
+
+        /// @brief Put every string in its slot under a seed
+        /// @return false on a collision
+        constexpr bool Place(uint32_t seed)
+        {
+            for (size_t s = 0; s < kSlots; s++) { mSlots[s] = kEmpty; }
+            for (size_t i = 0; i < N; i++)
+            {
+                if (mText[i].empty())
+                {
+                    continue;
+                }
+                const size_t slot = Hash(mText[i], seed);
+                if (mSlots[slot] != kEmpty)
+                {
+                    return false;
+                }
+                mSlots[slot] = static_cast<uint8_t>(i);
+            }
+            return true;
+        }
+
+        std::array<std::string_view, N>     mText;
+        uint32_t                            mSeed;
+        std::array<uint8_t, kSlots>         mSlots;     /// Value index by hash, kEmpty if none
+    };
+};
@@ -0,0 +1,294 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_fields.h
+// @brief           Field descriptor tables for the COT sub-schemas.
+//
+//                  Each sub-schema class lists its XML element name and a
+//                  static constexpr Describe() table of attributes (XML name,
+//                  printed label, member pointer) or nested elements. The
+//                  compare, validity, print and XML emit code below, and the
+//                  parser in cot_utility.cpp, are instantiated from that table,
+//                  so a field is added in one place and every path picks it up.
+//
+//                  A class with no table (repeated or flattened elements such
+//                  as shape vertices) can still be a Child: it provides Valid(),
+//                  ==, << and AppendXML(), and the parser reads it by hand.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cmath>                            // isnan
+#include <cstdio>                           // snprintf
+#include <cstring>                          // strlen
+#include <ostream>                          // ostream
+#include <string>                           // string
+#include <tuple>                            // tuple, apply
+#include <type_traits>                      // decay_t, true_type, void_t
+//
+#include "cot_format.h"                     // AppendEscaped
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Fields
+{
+    /// @brief An XML attribute of a sub-schema element
+    template <class T, class M>
+    struct Field
+    {
+        const char* xml;            /// Attribute name on the wire
+        const char* label;          /// Name printed by operator<<
+        M T::*      member;
+    };
+
+    /// @brief The text content of the element
+    template <class T>
+    struct Content
+    {
+        const char*         label;  /// Name printed by operator<<
+        std::string T::*    member;
+    };
+
+    /// @brief A nested sub-schema element
+    template <class T, class C>
+    struct Child
+    {
+        const char* name;           /// Member name, used for field paths
+        C T::*      member;
+        bool        required;       /// Counts toward the parent's Valid()
+    };
+
+    template <class T, class M>
+    constexpr Field<T, M> Attribute(const char* xml, const char* label, M T::* member)
+    {
+        return Field<T, M>{ xml, label, member };
+    }
+
+    template <class T>
+    constexpr Content<T> Text(const char* label, std::string T::* member)
+    {
+        return Content<T>{ label, member };
+    }
+
+    template <class T, class C>
+    constexpr Child<T, C> Element(const char* name, C T::* member)
+    {
+        return Child<T, C>{ name, member, true };
+    }
+
+    /// @brief A nested element present only on some messages (chat, shapes...).
+    ///        It does not count toward the parent's Valid(), and the parser
+    ///        resets it when a message does not carry it.
+    template <class T, class C>
+    constexpr Child<T, C> Extension(const char* name, C T::* member)
+    {
+        return Child<T, C>{ name, member, false };
+    }
+
+    template <class D> struct IsChild : std::false_type {};
+    template <class T, class C> struct IsChild<Child<T, C>> : std::true_type {};
+
+    template <class D> struct IsContent : std::false_type {};
+    template <class T> struct IsContent<Content<T>> : std::true_type {};
+
+    /// @brief T writes its own XML with AppendXML(std::string&) instead of a table
+    template <class T, class = void> struct WritesItself : std::false_type {};
+    template <class T> struct WritesItself<T, std::void_t<decltype(std::declval<const T&>().AppendXML(std::declval<std::string&>()))>> : std::true_type {};
+
+    /// @brief Call fn with every descriptor in T::Describe(), in table order
+    template <class T, class F>
+    void ForEach(F&& fn)
+    {
+        std::apply([&fn](const auto&... d) { (fn(d), ...); }, T::Describe());
+    }
+
+    /// @brief Number of attributes in T::Describe(), not counting text or
+    ///        nested elements
+    template <class T>
+    constexpr size_t AttributeCount()
+    {
+        return std::apply([](const auto&... d)
+        {
+            return (size_t(0) + ... + size_t(!IsChild<std::decay_t<decltype(d)>>::value && !IsContent<std::decay_t<decltype(d)>>::value));
+        }, T::Describe());
+    }
+
+    /// @brief Width of the printed label column, including the colon
+    static const size_t LabelWidth = 17;
+
+    namespace Impl
+    {
+        /// @brief Accumulates the validity rule: any text field set, every real set,
+        ///        every nested element valid. A class with no text fields needs none.
+        struct Validity
+        {
+            bool hasText = false;
+            bool anyText = false;
+            bool all = true;
+
+            template <class T>
+            void Add(const T& obj, const Field<T, std::string>& f)  { hasText = true; anyText |= !(obj.*f.member).empty(); }
+
+            template <class T>
+            void Add(const T& obj, const Field<T, double>& f)       { all &= !std::isnan(obj.*f.member); }
+
+            template <class T>
+            void Add(const T& obj, const Content<T>& c)             { hasText = true; anyText |= !(obj.*c.member).empty(); }
+
+            template <class T, class C>
+            void Add(const T& obj, const Child<T, C>& c)            { all &= !c.required || (obj.*c.member).Valid(); }
+
+            bool Result() const { return all && (!hasText || anyText); }
+        };
+
+        inline void Label(std::ostream& os, const char* label)
+        {
+            os << "\t" << label << ":";
+            for (size_t n = std::strlen(label) + 1; n < LabelWidth; n++) { os << ' '; }
+        }
+
+        template <class T, class M>
+        void Print(std::ostream& os, const T& obj, const Field<T, M>& f)
+        {
+            Label(os, f.label);
+            os << obj.*f.member << "\n";
+        }
+
+        template <class T>
+        void Print(std::ostream& os, const T& obj, const Content<T>& c)
+        {
+            Label(os, c.label);
+            os << obj.*c.member << "\n";
+        }
+
+        template <class T, class C>
+        void Print(std::ostream& os, const T& obj, const Child<T, C>& c)
+        {
+            os << obj.*c.member;
+        }
+
+        /// @brief Reals as the default ostream formatting ("%g") writes them
+        inline void AppendValue(std::string& out, double value)
+        {
+            char buffer[Format::MaxNumber];
+            const int n = std::snprintf(buffer, sizeof(buffer), "%g", value);
+            out.append(buffer, n > 0 ? static_cast<size_t>(n) : 0);
+        }
+
+        inline void AppendValue(std::string& out, const std::string& value)
+        {
+            Format::AppendEscaped(out, value);
+        }
+    };
+
+    /// @brief Every field equal
+    template <class T>
+    bool Equal(const T& a, const T& b)
+    {
+        bool equal = true;
+        ForEach<T>([&](const auto& d) { equal = equal && (a.*d.member == b.*d.member); });
+        return equal;
+    }
+
+    /// @brief Valid when any text field is set, every real is set (not NaN) and
+    ///        every required nested element is valid
+    template <class T>
+    bool Valid(const T& obj)
+    {
+        Impl::Validity v;
+        ForEach<T>([&](const auto& d) { v.Add(obj, d); });
+        return v.Result();
+    }
+
+    /// @brief Print a title line then one labelled line per field
+    template <class T>
+    std::ostream& Print(std::ostream& os, const char* title, const T& obj, bool valid)
+    {
+        os << title << ": ";  if (!valid) { os << " -NOT VALID- "; }
+        os << "\n";
+        ForEach<T>([&](const auto& d) { Impl::Print(os, obj, d); });
+        os << "\n";
+        return os;
+    }
+
+    /// @brief Append the element as XML: attributes in table order, text escaped,
+    ///        reals as "%g", then any text content and nested elements inside an
+    ///        open and close tag. An element whose class sets Optional is left out
+    ///        unless it is valid. A class without a table appends itself.
+    template <class T>
+    void Emit(std::string& out, const T& obj);
+
+    namespace Impl
+    {
+        template <class T>
+        void EmitElement(std::string& out, const T& obj)
+        {
+            if constexpr (T::Optional)
+            {
+                if (!obj.Valid())
+                {
+                    return;
+                }
+            }
+
+            bool open = false;
+            out += '<';
+            out += T::Element;
+            ForEach<T>([&](const auto& d)
+            {
+                using D = std::decay_t<decltype(d)>;
+                if constexpr (IsChild<D>::value || IsContent<D>::value)
+                {
+                    if (!open)
+                    {
+                        out += '>';
+                        open = true;
+                    }
+                    if constexpr (IsChild<D>::value)
+                    {
+                        Emit(out, obj.*d.member);
+                    }
+                    else
+                    {
+                        Format::AppendEscaped(out, obj.*d.member);
+                    }
+                }
+                else
+                {
+                    out += ' ';
+                    out += d.xml;
+                    out += "=\"";
+                    Impl::AppendValue(out, obj.*d.member);
+                    out += '"';
+                }
+            });
+
+            if (open)
+            {
+                out += "</";
+                out += T::Element;
+                out += '>';
+            }
+            else
+            {
+                out += "/>";
+            }
+        }
+    };
+
+    template <class T>
+    void Emit(std::string& out, const T& obj)
+    {
+        if constexpr (WritesItself<T>::value)
+        {
+            obj.AppendXML(out);
+        }
+        else
+        {
+            Impl::EmitElement(out, obj);
+        }
+    }
+};
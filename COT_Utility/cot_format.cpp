@@ -0,0 +1,524 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_format.cpp
+// @brief           Implementation of the COT Utility text formatting
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // min
+#include <charconv>                     // from_chars
+#include <cmath>                        // isnan, isinf, fabs, floor, fma
+#include <cstdio>                       // snprintf
+#include <cstring>                      // memcpy, strlen
+#include <ctime>                        // clock_gettime, timespec_get
+#include <limits>                       // numeric_limits
+//
+#include "cot_format.h"                 // Format header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Format
+{
+    namespace
+    {
+        const uint64_t kPow10[MaxDecimals + 1] =
+        {
+            1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+            10000000ull, 100000000ull, 1000000000ull
+        };
+
+        /// @brief Two digit pairs "00".."99" so each divide yields two characters
+        const char kDigits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        const char kHex[] = "0123456789abcdef";
+
+        unsigned CountDigits(uint64_t v)
+        {
+            unsigned n = 1;
+            while (v >= 10)
+            {
+                v /= 10;
+                n++;
+            }
+            return n;
+        }
+
+        /// @brief Write exactly 'width' digits of v, right to left
+        void WriteDigits(char* out, uint64_t v, unsigned width)
+        {
+            char* p = out + width;
+            while (width >= 2)
+            {
+                const unsigned pair = static_cast<unsigned>(v % 100) * 2;
+                v /= 100;
+                *--p = kDigits[pair + 1];
+                *--p = kDigits[pair];
+                width -= 2;
+            }
+            if (width)
+            {
+                *--p = static_cast<char>('0' + v % 10);
+            }
+        }
+
+        char* WriteText(char* out, const char* text)
+        {
+            const size_t n = std::strlen(text);
+            std::memcpy(out, text, n);
+            return out + n;
+        }
+
+        /// @brief Seconds as "SS.ff", matching setfill('0') << setw(3 + decimals) << fixed, or "SS" at 0 decimals
+        char* WriteSeconds(char* out, double second, int decimals)
+        {
+            const unsigned width = decimals > 0 ? 3 + static_cast<unsigned>(decimals) : 2;
+
+            if (!(second >= 0 && second < 1.0e6))
+            {
+                // Negative (unset), NaN or absurd: not worth a fast path
+                char text[64];
+                const int n = std::snprintf(text, sizeof(text), "%.*f", decimals, second);
+                const unsigned length = n > 0 ? std::min(static_cast<unsigned>(n), static_cast<unsigned>(sizeof(text) - 1)) : 0;
+                for (unsigned i = length; i < width; i++) { *out++ = '0'; }
+                std::memcpy(out, text, length);
+                return out + length;
+            }
+
+            // Round the exact binary value like printf does, ties to even. The fma
+            // rounds only once, so the sign of each difference is exact even when
+            // the difference itself is not: 59.365 (really 59.36499..) stays .36.
+            const double scale = static_cast<double>(kPow10[decimals]);
+            uint64_t fixed = static_cast<uint64_t>(std::floor(second * scale));
+            if (std::fma(second, scale, -static_cast<double>(fixed)) < 0)
+            {
+                fixed--;
+            }
+            else if (std::fma(second, scale, -static_cast<double>(fixed + 1)) >= 0)
+            {
+                fixed++;
+            }
+            const double half = std::fma(second, scale, -(static_cast<double>(fixed) + 0.5));
+            if (half > 0 || (half == 0 && (fixed & 1)))
+            {
+                fixed++;
+            }
+
+            out = WritePadded(out, fixed / kPow10[decimals], 2);
+            if (decimals > 0)
+            {
+                *out++ = '.';
+                WriteDigits(out, fixed % kPow10[decimals], static_cast<unsigned>(decimals));
+                out += decimals;
+            }
+            return out;
+        }
+
+        /// @brief "YYYY-MM-DDT"
+        char* WriteDate(char* out, unsigned year, unsigned month, unsigned day)
+        {
+            out = WritePadded(out, year, 4);
+            *out++ = '-';
+            out = WritePadded(out, month, 2);
+            *out++ = '-';
+            out = WritePadded(out, day, 2);
+            *out++ = 'T';
+            return out;
+        }
+
+        /// @brief "HH:MM:"
+        char* WriteHourMinute(char* out, unsigned hour, unsigned minute)
+        {
+            out = WritePadded(out, hour, 2);
+            *out++ = ':';
+            out = WritePadded(out, minute, 2);
+            *out++ = ':';
+            return out;
+        }
+
+        int ClampDecimals(int decimals)
+        {
+            return decimals < 0 ? 0 : (decimals > MaxDecimals ? MaxDecimals : decimals);
+        }
+
+        int64_t FloorDiv(int64_t a, int64_t b)
+        {
+            const int64_t q = a / b;
+            return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+        }
+
+        const int64_t kNoDay = std::numeric_limits<int64_t>::min();
+    };
+
+    char* WriteUnsigned(char* out, uint64_t value)
+    {
+        const unsigned width = CountDigits(value);
+        WriteDigits(out, value, width);
+        return out + width;
+    }
+
+    char* WritePadded(char* out, uint64_t value, unsigned width)
+    {
+        const unsigned digits = CountDigits(value);
+        if (digits > width)
+        {
+            width = digits;
+        }
+        WriteDigits(out, value, width);
+        return out + width;
+    }
+
+    char* WriteFixed(char* out, double value, int decimals)
+    {
+        if (std::isnan(value))
+        {
+            return WriteText(out, "nan");
+        }
+        if (std::isinf(value))
+        {
+            return WriteText(out, value < 0 ? "-inf" : "inf");
+        }
+
+        if (decimals < 0) { decimals = 0; }
+        if (decimals > MaxDecimals) { decimals = MaxDecimals; }
+
+        const double scaled = std::fabs(value) * static_cast<double>(kPow10[decimals]) + 0.5;
+        if (scaled >= 9.0e18)
+        {
+            const int n = std::snprintf(out, MaxNumber, "%.*g", 17, value);
+            return out + (n > 0 ? (n < static_cast<int>(MaxNumber) ? n : static_cast<int>(MaxNumber) - 1) : 0);
+        }
+
+        const uint64_t fixed = static_cast<uint64_t>(scaled);
+        const uint64_t whole = fixed / kPow10[decimals];
+        const uint64_t fraction = fixed % kPow10[decimals];
+
+        // No "-0.00"
+        if (value < 0 && fixed != 0)
+        {
+            *out++ = '-';
+        }
+        out = WriteUnsigned(out, whole);
+        if (decimals > 0)
+        {
+            *out++ = '.';
+            WriteDigits(out, fraction, static_cast<unsigned>(decimals));
+            out += decimals;
+        }
+        return out;
+    }
+
+    void AppendFixed(std::string& out, double value, int decimals)
+    {
+        char buffer[MaxNumber];
+        out.append(buffer, WriteFixed(buffer, value, decimals));
+    }
+
+    char* WriteTrimmed(char* out, double value, int decimals)
+    {
+        char* end = WriteFixed(out, value, decimals);
+        const size_t length = static_cast<size_t>(end - out);
+        char* point = static_cast<char*>(std::memchr(out, '.', length));
+        if (point == nullptr)
+        {
+            return end;
+        }
+
+        // Only the mantissa is trimmed; the "%.17g" fallback may end in an exponent
+        char* exponent = static_cast<char*>(std::memchr(out, 'e', length));
+        char* trimmed = (exponent != nullptr) ? exponent : end;
+        while (trimmed[-1] == '0') { trimmed--; }
+        trimmed -= (trimmed - 1 == point);
+        if (exponent != nullptr)
+        {
+            std::memmove(trimmed, exponent, static_cast<size_t>(end - exponent));
+            trimmed += end - exponent;
+        }
+        return trimmed;
+    }
+
+    void AppendEscaped(std::string& out, const std::string& text)
+    {
+        size_t start = 0;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const char* entity = nullptr;
+            switch (text[i])
+            {
+            case '&':   entity = "&amp;";   break;
+            case '<':   entity = "&lt;";    break;
+            case '>':   entity = "&gt;";    break;
+            case '"':   entity = "&quot;";  break;
+            default:                        continue;
+            }
+            out.append(text, start, i - start);
+            out += entity;
+            start = i + 1;
+        }
+        out.append(text, start, std::string::npos);
+    }
+
+    void AppendJsonString(std::string& out, std::string_view text)
+    {
+        const uint64_t ones = 0x0101010101010101ull;
+        const uint64_t high = 0x8080808080808080ull;
+
+        out += '"';
+        const char* p = text.data();
+        const char* end = p + text.size();
+        const char* run = p;
+        while (p < end)
+        {
+            // A word with no control character, quote or backslash is skipped
+            // whole. The tests only hold for bytes below 0x80, so '& ~w' drops
+            // the high bytes, which never need escaping.
+            if (end - p >= 8)
+            {
+                uint64_t w;
+                std::memcpy(&w, p, sizeof(w));
+                const uint64_t quote = w ^ (ones * '"');
+                const uint64_t slash = w ^ (ones * '\\');
+                const uint64_t special = ((w - ones * 0x20) | (quote - ones) | (slash - ones)) & ~w & high;
+                if (special == 0)
+                {
+                    p += 8;
+                    continue;
+                }
+            }
+
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (c >= 0x20 && c != '"' && c != '\\')
+            {
+                p++;
+                continue;
+            }
+
+            out.append(run, p);
+            switch (c)
+            {
+            case '"':   out += "\\\"";   break;
+            case '\\':  out += "\\\\";   break;
+            case '\b':  out += "\\b";    break;
+            case '\f':  out += "\\f";    break;
+            case '\n':  out += "\\n";    break;
+            case '\r':  out += "\\r";    break;
+            case '\t':  out += "\\t";    break;
+            default:
+            {
+                const char escape[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+                out.append(escape, sizeof(escape));
+                break;
+            }
+            }
+            run = ++p;
+        }
+        out.append(run, end);
+        out += '"';
+    }
+
+    const char* ReadReal(const char* text, const char* end, double& value)
+    {
+        value = 0;
+        const char* p = text;
+        while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) { p++; }
+        if (p < end && *p == '+')
+        {
+            // from_chars takes no '+'; strtod takes no second sign after one
+            if (++p < end && *p == '-')
+            {
+                return text;
+            }
+        }
+
+        double v = 0;
+        const std::from_chars_result r = std::from_chars(p, end, v);
+        if (r.ec == std::errc::invalid_argument)
+        {
+            return text;
+        }
+        if (r.ec == std::errc::result_out_of_range)
+        {
+            // Decimal exponent of the first significant digit decides between
+            // overflow and underflow
+            const char* q = p;
+            const bool negative = (*q == '-');
+            q += negative;
+            long magnitude = 0;
+            bool significant = false;
+            for (; q < r.ptr && *q >= '0' && *q <= '9'; q++)
+            {
+                significant = significant || *q != '0';
+                magnitude += significant;
+            }
+            if (q < r.ptr && *q == '.')
+            {
+                for (q++; q < r.ptr && *q >= '0' && *q <= '9' && !significant; q++)
+                {
+                    significant = (*q != '0');
+                    magnitude -= !significant;
+                }
+                while (q < r.ptr && *q >= '0' && *q <= '9') { q++; }
+            }
+            if (q < r.ptr && (*q == 'e' || *q == 'E'))
+            {
+                q++;
+                const bool down = (q < r.ptr && *q == '-');
+                q += (q < r.ptr && (*q == '-' || *q == '+'));
+                long exponent = 0;
+                for (; q < r.ptr && *q >= '0' && *q <= '9'; q++)
+                {
+                    exponent = std::min(exponent * 10 + (*q - '0'), 1000000L);
+                }
+                magnitude += down ? -exponent : exponent;
+            }
+            v = magnitude > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+            v = negative ? -v : v;
+        }
+        value = v;
+        return r.ptr;
+    }
+
+    const char* ReadReal(const char* text, double& value)
+    {
+        if (text == nullptr)
+        {
+            value = 0;
+            return text;
+        }
+        return ReadReal(text, text + std::strlen(text), value);
+    }
+
+    char* WriteTimestamp(char* out, const Civil& t, int decimals)
+    {
+        out = WriteDate(out, t.year, t.month, t.day);
+        out = WriteHourMinute(out, t.hour, t.minute);
+        out = WriteSeconds(out, t.second, ClampDecimals(decimals));
+        *out++ = 'Z';
+        return out;
+    }
+
+    TimestampWriter::TimestampWriter(int decimals)
+        : mDecimals(ClampDecimals(decimals)), mDateKey(0xFFFFFFFFu), mEpochDay(kNoDay), mPrefixLength(0)
+    {
+    }
+
+    char* TimestampWriter::Write(char* out, const Civil& t)
+    {
+        const uint32_t key = (t.year << 9) | ((t.month & 0xF) << 5) | (t.day & 0x1F);
+        if (key != mDateKey || t.month > 12 || t.day > 31 || t.year > 9999)
+        {
+            mPrefixLength = static_cast<unsigned>(WriteDate(mPrefix, t.year, t.month, t.day) - mPrefix);
+            mDateKey = key;
+            mEpochDay = kNoDay;
+        }
+
+        std::memcpy(out, mPrefix, mPrefixLength);
+        out += mPrefixLength;
+        out = WriteHourMinute(out, t.hour, t.minute);
+        out = WriteSeconds(out, t.second, mDecimals);
+        *out++ = 'Z';
+        return out;
+    }
+
+    char* TimestampWriter::Write(char* out, int64_t epochSeconds, uint32_t nanoseconds)
+    {
+        const int64_t day = FloorDiv(epochSeconds, 86400);
+        if (day != mEpochDay)
+        {
+            unsigned year, month, dayOfMonth;
+            CivilFromDays(day, year, month, dayOfMonth);
+            mPrefixLength = static_cast<unsigned>(WriteDate(mPrefix, year, month, dayOfMonth) - mPrefix);
+            mDateKey = (year << 9) | (month << 5) | dayOfMonth;
+            mEpochDay = day;
+        }
+
+        const unsigned secondOfDay = static_cast<unsigned>(epochSeconds - day * 86400);
+        std::memcpy(out, mPrefix, mPrefixLength);
+        out += mPrefixLength;
+        out = WriteHourMinute(out, secondOfDay / 3600, secondOfDay / 60 % 60);
+        out = WritePadded(out, secondOfDay % 60, 2);
+        if (mDecimals > 0)
+        {
+            *out++ = '.';
+            WriteDigits(out, (nanoseconds % 1000000000u) / kPow10[MaxDecimals - mDecimals], static_cast<unsigned>(mDecimals));
+            out += mDecimals;
+        }
+        *out++ = 'Z';
+        return out;
+    }
+
+    void TimestampWriter::Append(std::string& out, const Civil& t)
+    {
+        char buffer[MaxTimestamp];
+        out.append(buffer, Write(buffer, t));
+    }
+
+    void CivilFromDays(int64_t days, unsigned& year, unsigned& month, unsigned& day)
+    {
+        // H. Hinnant's days_from_civil inverse, proleptic Gregorian calendar
+        days += 719468;
+        const int64_t era = FloorDiv(days, 146097);
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<unsigned>(static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0));
+    }
+
+    int64_t DaysFromCivil(unsigned year, unsigned month, unsigned day)
+    {
+        const int64_t y = static_cast<int64_t>(year) - (month <= 2 ? 1 : 0);
+        const int64_t era = FloorDiv(y, 400);
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    double EpochSeconds(const Civil& t)
+    {
+        return static_cast<double>(DaysFromCivil(t.year, t.month, t.day) * 86400 + t.hour * 3600 + t.minute * 60) + t.second;
+    }
+
+    Civil UtcNow(double offsetSeconds)
+    {
+        timespec ts;
+#ifdef _WIN32
+        timespec_get(&ts, TIME_UTC);
+#else
+        clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+        int64_t ns = static_cast<int64_t>(ts.tv_nsec) + static_cast<int64_t>(std::llround(offsetSeconds * 1e9));
+        const int64_t seconds = static_cast<int64_t>(ts.tv_sec) + FloorDiv(ns, 1000000000);
+        ns -= FloorDiv(ns, 1000000000) * 1000000000;
+
+        // Calendar conversion only when the day changes
+        thread_local int64_t cachedDay = kNoDay;
+        thread_local unsigned year = 0, month = 0, day = 0;
+        const int64_t epochDay = FloorDiv(seconds, 86400);
+        if (epochDay != cachedDay)
+        {
+            CivilFromDays(epochDay, year, month, day);
+            cachedDay = epochDay;
+        }
+
+        const unsigned secondOfDay = static_cast<unsigned>(seconds - epochDay * 86400);
+        Civil c;
+        c.year = year;
+        c.month = month;
+        c.day = day;
+        c.hour = secondOfDay / 3600;
+        c.minute = secondOfDay / 60 % 60;
+        c.second = static_cast<double>(secondOfDay % 60) + static_cast<double>(ns) / 1e9;
+        return c;
+    }
+};
@@ -0,0 +1,145 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_format.h
+// @brief           Allocation free text formatting shared by the COT writers.
+//                  Numbers are written straight into a caller buffer with no
+//                  stream, locale or temporary string, and read back the same way.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint64_t
+#include <string>                           // string
+#include <string_view>                      // string_view
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Format
+{
+    /// @brief Longest text any Write function below produces
+    static const size_t MaxNumber = 32;
+
+    /// @brief Most decimal places WriteFixed() writes
+    static const int MaxDecimals = 9;
+
+    /// @brief Write an unsigned integer
+    /// @return one past the last character written
+    char* WriteUnsigned(char* out, uint64_t value);
+
+    /// @brief Write an unsigned integer left padded with zeros to 'width' digits
+    /// @return one past the last character written
+    char* WritePadded(char* out, uint64_t value, unsigned width);
+
+    /// @brief Write a real with a fixed number of decimals, rounded to nearest
+    ///        (like "%.*f", though a value exactly halfway may round the other way).
+    ///        NaN and infinities are written as "nan", "inf" and "-inf", which
+    ///        strtod reads back. Values too large for 64 bit fixed point fall
+    ///        back to snprintf.
+    /// @param out      - [out] - buffer of at least MaxNumber characters
+    /// @param value    - [in]  - value to write
+    /// @param decimals - [in]  - places after the point, clamped to [0, MaxDecimals]
+    /// @return one past the last character written
+    char* WriteFixed(char* out, double value, int decimals);
+
+    /// @brief Append WriteFixed() output to a string
+    void AppendFixed(std::string& out, double value, int decimals);
+
+    /// @brief WriteFixed() without the trailing zeros of the fraction, or its
+    ///        point when the fraction is all zeros: 2.50 is "2.5", 2.00 is "2".
+    ///        A value written with an exponent keeps it: 1.5e+20 stays "1.5e+20".
+    /// @return one past the last character written
+    char* WriteTrimmed(char* out, double value, int decimals);
+
+    /// @brief Append text escaped for use inside a double quoted XML attribute
+    void AppendEscaped(std::string& out, const std::string& text);
+
+    /// @brief Append text as a quoted JSON string: '"', '\\' and control
+    ///        characters escaped, other bytes (UTF-8 included) copied as they
+    ///        are. Runs with nothing to escape are found eight bytes at a time.
+    void AppendJsonString(std::string& out, std::string_view text);
+
+    /// @brief Read a real as strtod does in the "C" locale, whatever the process
+    ///        locale: leading white space, a sign, decimal digits with an optional
+    ///        '.' fraction and exponent, or inf, infinity or nan. Correctly rounded
+    ///        (std::from_chars) with no allocation. Hexadecimal reals are not read.
+    ///        Values out of range read as +-inf or +-0, as strtod gives them.
+    /// @param value - [out] - the real read, 0 when there is none
+    /// @return one past the last character read, or 'text' when there is no number
+    const char* ReadReal(const char* text, const char* end, double& value);
+
+    /// @brief Overloaded - Read from a NUL terminated string
+    const char* ReadReal(const char* text, double& value);
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Timestamps
+    /////////////////////////////////////////////////////////////////////////////
+
+    /// @brief Longest timestamp text. A valid one is at most 30 characters
+    ///        ("YYYY-MM-DDTHH:MM:SS.fffffffffZ"); this also fits out of range fields.
+    static const size_t MaxTimestamp = 128;
+
+    /// @brief Broken down UTC time
+    struct Civil
+    {
+        unsigned    year;
+        unsigned    month;
+        unsigned    day;
+        unsigned    hour;
+        unsigned    minute;
+        double      second;
+    };
+
+    /// @brief Write a CoT timestamp, e.g. "2022-12-22T18:06:59.36Z". The output is
+    ///        the same as DateTime's stream formatting: fields zero padded, seconds
+    ///        correctly rounded to 'decimals' places.
+    /// @param out      - [out] - buffer of at least MaxTimestamp characters
+    /// @param decimals - [in]  - fractional second digits, clamped to [0, MaxDecimals]
+    /// @return one past the last character written
+    char* WriteTimestamp(char* out, const Civil& t, int decimals = 2);
+
+    /// @brief Writes timestamps, keeping the "YYYY-MM-DDT" text of the last day
+    ///        written so consecutive stamps on one day only format the time.
+    ///        Not thread safe; use one per thread or per message.
+    class TimestampWriter
+    {
+    public:
+        explicit TimestampWriter(int decimals = 2);
+
+        /// @brief Write a broken down time, see WriteTimestamp()
+        char* Write(char* out, const Civil& t);
+
+        /// @brief Write a time given as seconds and nanoseconds since the Unix
+        ///        epoch. The fraction is truncated, never rounded into the next
+        ///        second. The calendar date is only worked out when the day changes.
+        char* Write(char* out, int64_t epochSeconds, uint32_t nanoseconds);
+
+        /// @brief Append a broken down time to a string
+        void Append(std::string& out, const Civil& t);
+
+    private:
+        int         mDecimals;
+        uint32_t    mDateKey;       /// year/month/day packed, of mPrefix
+        int64_t     mEpochDay;      /// Days since epoch of mPrefix, or INT64_MIN
+        char        mPrefix[3 * 10 + 3];    /// Widest fields: three 10 digit unsigned, "--" and 'T'
+        unsigned    mPrefixLength;
+    };
+
+    /// @brief Year, month and day of a count of days since 1970-01-01
+    void CivilFromDays(int64_t days, unsigned& year, unsigned& month, unsigned& day);
+
+    /// @brief Days since 1970-01-01 of a calendar date, the inverse of CivilFromDays()
+    int64_t DaysFromCivil(unsigned year, unsigned month, unsigned day);
+
+    /// @brief Seconds since the Unix epoch of a broken down UTC time
+    double EpochSeconds(const Civil& t);
+
+    /// @brief Current UTC time plus an offset, from clock_gettime(CLOCK_REALTIME)
+    ///        (timespec_get on Windows). The calendar date is cached per thread and
+    ///        only recomputed when the day changes.
+    Civil UtcNow(double offsetSeconds = 0);
+};
@@ -0,0 +1,361 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_geofence.cpp
+// @brief           Implementation of the geofence grid and track crossings
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // min, max, lower_bound, inplace_merge
+#include <cmath>                        // cos, floor, ceil, isfinite
+//
+#include "cot_geofence.h"               // Geofences header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief Metres per degree, as the shape Simplifier uses
+    const double kMetersPerLat = 110574.0;
+    const double kMetersPerLon = 111320.0;
+
+    /// @brief A fence spanning more cells is tested against every point instead
+    const uint64_t kMaxCells = 1024;
+
+    /// @brief Smallest cell, about 11 cm. The grid is then 3.6e8 by 1.8e8 cells,
+    ///        so cell numbers still fit a uint64_t.
+    const double kMinCellDegrees = 1e-6;
+};
+
+Geofences::Geofences(double cellDegrees)
+    : mCellDegrees(std::isfinite(cellDegrees) && cellDegrees > 0 ? std::min(std::max(cellDegrees, kMinCellDegrees), 180.0) : 0.05), mLive(0)
+{
+    mColumns = static_cast<uint64_t>(std::ceil(360.0 / mCellDegrees));
+    mRows = static_cast<uint64_t>(std::ceil(180.0 / mCellDegrees));
+}
+
+uint32_t Geofences::AddPolygon(std::string_view name, const double* latitude, const double* longitude, size_t count)
+{
+    if (latitude == nullptr || longitude == nullptr || count < 3 || mLat.size() + count > None)
+    {
+        return None;
+    }
+
+    Fence fence{};
+    fence.kind = Kind::Polygon;
+    fence.minLat = fence.maxLat = latitude[0];
+    fence.minLon = fence.maxLon = longitude[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!std::isfinite(latitude[i]) || !std::isfinite(longitude[i]))
+        {
+            return None;
+        }
+        fence.minLat = std::min(fence.minLat, latitude[i]);
+        fence.maxLat = std::max(fence.maxLat, latitude[i]);
+        fence.minLon = std::min(fence.minLon, longitude[i]);
+        fence.maxLon = std::max(fence.maxLon, longitude[i]);
+    }
+
+    fence.first = static_cast<uint32_t>(mLat.size());
+    fence.count = static_cast<uint32_t>(count);
+    mLat.insert(mLat.end(), latitude, latitude + count);
+    mLon.insert(mLon.end(), longitude, longitude + count);
+    fence.name.assign(name.data(), name.size());
+    return Insert(fence);
+}
+
+uint32_t Geofences::AddPolygon(std::string_view name, const Shape& shape)
+{
+    if (shape.latitude.size() != shape.longitude.size())
+    {
+        return None;
+    }
+    return AddPolygon(name, shape.latitude.data(), shape.longitude.data(), shape.latitude.size());
+}
+
+uint32_t Geofences::AddCircle(std::string_view name, double latitude, double longitude, double radiusMeters)
+{
+    if (!std::isfinite(latitude) || !std::isfinite(longitude) || !std::isfinite(radiusMeters) || radiusMeters <= 0)
+    {
+        return None;
+    }
+
+    Fence fence{};
+    fence.kind = Kind::Circle;
+    fence.lat = latitude;
+    fence.lon = longitude;
+    fence.radius2 = radiusMeters * radiusMeters;
+    fence.metersPerLon = kMetersPerLon * std::cos(latitude * 3.14159265358979323846 / 180.0);
+
+    const double dLat = radiusMeters / kMetersPerLat;
+    const double dLon = fence.metersPerLon > 1 ? radiusMeters / fence.metersPerLon : 360.0;
+    fence.minLat = latitude - dLat;
+    fence.maxLat = latitude + dLat;
+    fence.minLon = longitude - dLon;
+    fence.maxLon = longitude + dLon;
+    fence.name.assign(name.data(), name.size());
+    return Insert(fence);
+}
+
+bool Geofences::Remove(uint32_t fence)
+{
+    if (fence >= mFences.size() || mFences[fence].kind == Kind::Removed)
+    {
+        return false;
+    }
+
+    Fence& f = mFences[fence];
+    const auto drop = [fence](std::vector<uint32_t>& ids)
+    {
+        const auto it = std::lower_bound(ids.begin(), ids.end(), fence);
+        if (it != ids.end() && *it == fence)
+        {
+            ids.erase(it);
+        }
+    };
+
+    uint64_t x0, y0, x1, y1;
+    if (!Cells(f, x0, y0, x1, y1))
+    {
+        drop(mLarge);
+    }
+    else
+    {
+        for (uint64_t y = y0; y <= y1; y++)
+        {
+            for (uint64_t x = x0; x <= x1; x++)
+            {
+                const auto cell = mCells.find(y * mColumns + x);
+                if (cell == mCells.end())
+                {
+                    continue;
+                }
+                drop(cell->second);
+                if (cell->second.empty())
+                {
+                    mCells.erase(cell);
+                }
+            }
+        }
+    }
+
+    f.kind = Kind::Removed;
+    f.name.clear();
+    f.name.shrink_to_fit();
+    mLive--;
+    return true;
+}
+
+std::string_view Geofences::Name(uint32_t fence) const
+{
+    return fence < mFences.size() ? std::string_view(mFences[fence].name) : std::string_view();
+}
+
+size_t Geofences::Contains(double latitude, double longitude, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    if (!std::isfinite(latitude) || !std::isfinite(longitude))
+    {
+        return 0;
+    }
+
+    const auto cell = mCells.find(Row(latitude) * mColumns + Column(longitude));
+    if (cell != mCells.end())
+    {
+        for (uint32_t id : cell->second)
+        {
+            if (Inside(mFences[id], latitude, longitude)) { out.push_back(id); }
+        }
+    }
+    if (!mLarge.empty())
+    {
+        const size_t fromCell = out.size();
+        for (uint32_t id : mLarge)
+        {
+            if (Inside(mFences[id], latitude, longitude)) { out.push_back(id); }
+        }
+        if (fromCell > 0 && fromCell < out.size())
+        {
+            std::inplace_merge(out.begin(), out.begin() + fromCell, out.end());
+        }
+    }
+    return out.size();
+}
+
+size_t Geofences::Update(std::string_view uid, const Point::Data& point, std::vector<Crossing>& out)
+{
+    if (!std::isfinite(point.latitude) || !std::isfinite(point.longitude))
+    {
+        return 0;
+    }
+
+    Contains(point.latitude, point.longitude, mScratch);
+    auto it = mTracks.find(uid);
+    if (it == mTracks.end())
+    {
+        // Outside everything and was before: the common case, nothing kept
+        if (mScratch.empty())
+        {
+            return 0;
+        }
+        std::unique_ptr<Track> track(new Track());
+        track->uid.assign(uid.data(), uid.size());
+        const std::string_view key = track->uid;
+        it = mTracks.emplace(key, std::move(track)).first;
+    }
+
+    // Both lists ascend; walk them together
+    const std::vector<uint32_t>& before = it->second->inside;
+    const size_t start = out.size();
+    size_t a = 0, b = 0;
+    while (a < before.size() || b < mScratch.size())
+    {
+        if (b == mScratch.size() || (a < before.size() && before[a] < mScratch[b]))
+        {
+            out.push_back(Crossing{ before[a++], false });
+        }
+        else if (a == before.size() || mScratch[b] < before[a])
+        {
+            out.push_back(Crossing{ mScratch[b++], true });
+        }
+        else
+        {
+            a++;
+            b++;
+        }
+    }
+
+    if (mScratch.empty())
+    {
+        mTracks.erase(it);
+    }
+    else
+    {
+        it->second->inside.swap(mScratch);
+    }
+    return out.size() - start;
+}
+
+size_t Geofences::Update(const COTSchema& cot, std::vector<Crossing>& out)
+{
+    return Update(cot.event.uid, cot.point, out);
+}
+
+size_t Geofences::Forget(std::string_view uid, std::vector<Crossing>& out)
+{
+    const auto it = mTracks.find(uid);
+    if (it == mTracks.end())
+    {
+        return 0;
+    }
+
+    const std::vector<uint32_t>& inside = it->second->inside;
+    for (uint32_t id : inside) { out.push_back(Crossing{ id, false }); }
+    const size_t n = inside.size();
+    mTracks.erase(it);
+    return n;
+}
+
+size_t Geofences::Size() const
+{
+    return mLive;
+}
+
+size_t Geofences::Tracks() const
+{
+    return mTracks.size();
+}
+
+void Geofences::Clear()
+{
+    mFences.clear();
+    mLive = 0;
+    mLat.clear();
+    mLon.clear();
+    mCells.clear();
+    mLarge.clear();
+    mTracks.clear();
+}
+
+uint32_t Geofences::Insert(Fence& fence)
+{
+    if (mFences.size() >= None)
+    {
+        return None;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(mFences.size());
+    mFences.push_back(std::move(fence));
+    mLive++;
+
+    // Ids only grow, so appending keeps every list ascending
+    uint64_t x0, y0, x1, y1;
+    if (!Cells(mFences.back(), x0, y0, x1, y1))
+    {
+        mLarge.push_back(id);
+        return id;
+    }
+    for (uint64_t y = y0; y <= y1; y++)
+    {
+        for (uint64_t x = x0; x <= x1; x++)
+        {
+            mCells[y * mColumns + x].push_back(id);
+        }
+    }
+    return id;
+}
+
+bool Geofences::Cells(const Fence& fence, uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1) const
+{
+    x0 = Column(fence.minLon);
+    x1 = Column(fence.maxLon);
+    y0 = Row(fence.minLat);
+    y1 = Row(fence.maxLat);
+    return (x1 - x0 + 1) * (y1 - y0 + 1) <= kMaxCells;
+}
+
+uint64_t Geofences::Column(double longitude) const
+{
+    const double x = std::floor((longitude + 180.0) / mCellDegrees);
+    return x <= 0 ? 0 : std::min(static_cast<uint64_t>(x), mColumns - 1);
+}
+
+uint64_t Geofences::Row(double latitude) const
+{
+    const double y = std::floor((latitude + 90.0) / mCellDegrees);
+    return y <= 0 ? 0 : std::min(static_cast<uint64_t>(y), mRows - 1);
+}
+
+bool Geofences::Inside(const Fence& fence, double latitude, double longitude) const
+{
+    if (latitude < fence.minLat || latitude > fence.maxLat || longitude < fence.minLon || longitude > fence.maxLon)
+    {
+        return false;
+    }
+
+    if (fence.kind == Kind::Circle)
+    {
+        const double dy = (latitude - fence.lat) * kMetersPerLat;
+        const double dx = (longitude - fence.lon) * fence.metersPerLon;
+        return dx * dx + dy * dy <= fence.radius2;
+    }
+
+    // Crossing number: count the edges a ray to the east passes through
+    const double* lat = mLat.data() + fence.first;
+    const double* lon = mLon.data() + fence.first;
+    bool inside = false;
+    for (uint32_t i = 0, j = fence.count - 1; i < fence.count; j = i++)
+    {
+        if ((lat[i] > latitude) != (lat[j] > latitude) &&
+            longitude < (lon[j] - lon[i]) * (latitude - lat[i]) / (lat[j] - lat[i]) + lon[i])
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
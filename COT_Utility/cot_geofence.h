@@ -0,0 +1,135 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_geofence.h
+// @brief           Geofences: polygons and circles tested against track points.
+//
+//                  The fences are indexed by a uniform latitude/longitude grid,
+//                  so a point is tested only against the fences whose bounding
+//                  box overlaps its cell. Each track remembers the fences it is
+//                  in, and an update reports the fences it entered and left.
+//                  Tracks outside every fence are not kept.
+//
+//                  Polygons and circles are tested on a flat latitude/longitude
+//                  plane; a fence must not cross the antimeridian or a pole.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint32_t, uint64_t
+#include <memory>                           // unique_ptr
+#include <string>                           // string
+#include <string_view>                      // string_view
+#include <unordered_map>                    // unordered_map
+#include <vector>                           // vector
+//
+#include "cot_info.h"                       // COTSchema, Point::Data, Shape
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+class Geofences
+{
+public:
+
+    /// @brief Returned by the Add functions for a fence that was not added
+    static constexpr uint32_t None = 0xFFFFFFFF;
+
+    /// @brief A track entering or leaving a fence
+    struct Crossing
+    {
+        uint32_t    fence;
+        bool        entered;        /// false when the track left the fence
+    };
+
+    /// @brief Constructor - Initializes Everything
+    /// @param cellDegrees - Grid cell size, best about the size of a typical fence;
+    ///                      kept within [1e-6, 180]
+    explicit Geofences(double cellDegrees = 0.05);
+
+    /// @brief Add a polygon. The last vertex joins the first; repeating the
+    ///        first vertex at the end is allowed.
+    /// @return the fence id, or None for fewer than 3 vertices or a vertex
+    ///         that is not a number
+    uint32_t AddPolygon(std::string_view name, const double* latitude, const double* longitude, size_t count);
+
+    /// @brief Overloaded - Add the vertices of a drawn shape as a polygon
+    uint32_t AddPolygon(std::string_view name, const Shape& shape);
+
+    /// @brief Add a circle
+    /// @return the fence id, or None for a centre or radius that is not a
+    ///         positive number
+    uint32_t AddCircle(std::string_view name, double latitude, double longitude, double radiusMeters);
+
+    /// @brief Remove a fence. Tracks in it get their exit on their next update.
+    ///        Ids are not reused; the vertices are freed by Clear().
+    /// @return false if there is no such fence
+    bool Remove(uint32_t fence);
+
+    /// @brief Name of a fence, empty if there is no such fence
+    std::string_view Name(uint32_t fence) const;
+
+    /// @brief Ids of the fences containing a point, ascending
+    /// @return number of ids in 'out', which is replaced
+    size_t Contains(double latitude, double longitude, std::vector<uint32_t>& out) const;
+
+    /// @brief Move a track to a point and append the fences it entered and left
+    ///        to 'out'. A point that is not a number changes nothing.
+    /// @return number of crossings appended
+    size_t Update(std::string_view uid, const Point::Data& point, std::vector<Crossing>& out);
+
+    /// @brief Overloaded - Move the event uid to the event point
+    size_t Update(const COTSchema& cot, std::vector<Crossing>& out);
+
+    /// @brief Drop a track, appending an exit for every fence it was in
+    /// @return number of crossings appended
+    size_t Forget(std::string_view uid, std::vector<Crossing>& out);
+
+    /// @brief Number of fences
+    size_t Size() const;
+
+    /// @brief Number of tracks inside at least one fence
+    size_t Tracks() const;
+
+    /// @brief Drop every fence and track
+    void Clear();
+
+private:
+    enum class Kind : uint8_t { Removed, Polygon, Circle };
+
+    struct Fence
+    {
+        Kind        kind;
+        double      minLat, maxLat, minLon, maxLon;     /// Bounding box
+        uint32_t    first, count;                       /// Polygon vertices in mLat/mLon
+        double      lat, lon, radius2, metersPerLon;    /// Circle
+        std::string name;
+    };
+
+    struct Track
+    {
+        std::string             uid;
+        std::vector<uint32_t>   inside;         /// Ascending fence ids
+    };
+
+    uint32_t Insert(Fence& fence);
+    bool Cells(const Fence& fence, uint64_t& x0, uint64_t& y0, uint64_t& x1, uint64_t& y1) const;
+    uint64_t Column(double longitude) const;
+    uint64_t Row(double latitude) const;
+    bool Inside(const Fence& fence, double latitude, double longitude) const;
+
+    double                                                          mCellDegrees;
+    uint64_t                                                        mColumns;
+    uint64_t                                                        mRows;
+    std::vector<Fence>                                              mFences;    /// Indexed by id
+    size_t                                                          mLive;
+    std::vector<double>                                             mLat;       /// Polygon vertices
+    std::vector<double>                                             mLon;
+    std::unordered_map<uint64_t, std::vector<uint32_t>>             mCells;     /// Fence ids by cell, ascending
+    std::vector<uint32_t>                                           mLarge;     /// Fences spanning too many cells
+    std::unordered_map<std::string_view, std::unique_ptr<Track>>    mTracks;    /// Keys view Track::uid
+    std::vector<uint32_t>                                           mScratch;
+};
@@ -12,8 +12,17 @@
 //          --------------------        ---------------------------------------
 #include <iostream>                     // ostream
 #include <iomanip>                      // setw
-#include <unordered_map>                // maps
 #include <sstream>                      // sstream
+#include <string>                       // string
+#include <string_view>                  // string_view
+#include <cmath>                        // NAN, isnan
+#include <tuple>                        // make_tuple
+#include <vector>                       // vector
+//
+#include "cot_alloc_profile.h"          // Allocation phases
+#include "cot_enum_table.h"             // Enum text tables
+#include "cot_fields.h"                 // Field tables
+#include "cot_format.h"                 // WriteTimestamp, UtcNow
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -30,16 +39,24 @@ namespace Root
         Error
     };
 
-    static const std::unordered_map<Type, std::string> TypeToString
-    {
-        {Type::a, "Atoms"},
-        {Type::b, "Bits"},
-        {Type::t, "Tasking"},
-        {Type::r, "Reply"},
-        {Type::c, "Capability"},
-        {Type::res, "Reservation"},
-        {Type::Error, "Error"}
-    };
+    /// @brief Display name of each Type
+    inline constexpr Enums::Table<Type, 7> TypeToString
+    {{
+        "Atoms", "Bits", "Tasking", "Reply", "Capability", "Reservation", "Error"
+    }};
+
+    /// @brief Code of each Type, the first 'type' field
+    inline constexpr Enums::Table<Type, 7> TypeCodes
+    {{
+        "a", "b", "t", "r", "c", "res", ""
+    }};
+    static_assert(TypeToString.Valid() && TypeCodes.Valid(), "no perfect hash seed");
+
+    /// @brief Type from its display name, Error if none
+    constexpr Type StringToType(std::string_view text) { return TypeToString.Find(text, Type::Error); }
+
+    /// @brief Type from its code, Error if none
+    constexpr Type CodeToType(std::string_view code) { return TypeCodes.Find(code, Type::Error); }
 };
 
 namespace Point
@@ -60,21 +77,25 @@ namespace Point
         Error
     };
 
-    static const std::unordered_map<Type, std::string> TypeToString
-    {
-        {Point::Type::p, "Pending"},
-        {Point::Type::u, "Unknown"},
-        {Point::Type::a, "Assumed Friend"},
-        {Point::Type::f, "Friend"},
-        {Point::Type::n, "Neutral"},
-        {Point::Type::s, "Suspect"},
-        {Point::Type::h, "Hostile"},
-        {Point::Type::j, "Joker"},
-        {Point::Type::k, "Faker"},
-        {Point::Type::o, "None Specified"},
-        {Point::Type::x, "Other"},
-        {Point::Type::Error, "Error"}
-    };
+    /// @brief Display name of each Type
+    inline constexpr Enums::Table<Type, 12> TypeToString
+    {{
+        "Pending", "Unknown", "Assumed Friend", "Friend", "Neutral", "Suspect",
+        "Hostile", "Joker", "Faker", "None Specified", "Other", "Error"
+    }};
+
+    /// @brief Code of each Type, the second 'type' field (affiliation)
+    inline constexpr Enums::Table<Type, 12> TypeCodes
+    {{
+        "p", "u", "a", "f", "n", "s", "h", "j", "k", "o", "x", ""
+    }};
+    static_assert(TypeToString.Valid() && TypeCodes.Valid(), "no perfect hash seed");
+
+    /// @brief Type from its display name, Error if none
+    constexpr Type StringToType(std::string_view text) { return TypeToString.Find(text, Type::Error); }
+
+    /// @brief Type from its code, Error if none
+    constexpr Type CodeToType(std::string_view code) { return TypeCodes.Find(code, Type::Error); }
 
     class Data 
     {
@@ -90,19 +111,27 @@ namespace Point
             : latitude(latitude), longitude(longitude), hae(hae),
             circularError(circularError), linearError(linearError) {}
 
+        /// @brief XML element and field table, see cot_fields.h
+        static constexpr const char* Element = "point";
+        static constexpr bool Optional = false;
+        static constexpr auto Describe()
+        {
+            return std::make_tuple(
+                Fields::Attribute("lat", "Latitude", &Data::latitude),
+                Fields::Attribute("lon", "Longitude", &Data::longitude),
+                Fields::Attribute("hae", "HAE", &Data::hae),
+                Fields::Attribute("ce", "Circular Error", &Data::circularError),
+                Fields::Attribute("le", "Linear Error", &Data::linearError));
+        }
+
         bool IsValid() const 
         {
-            return !std::isnan(latitude) && !std::isnan(longitude) &&
-                !std::isnan(hae) && !std::isnan(circularError) && !std::isnan(linearError);
+            return Fields::Valid(*this);
         }
 
         bool operator==(const Data& other) const 
         {
-            return latitude == other.latitude &&
-                longitude == other.longitude &&
-                hae == other.hae &&
-                circularError == other.circularError &&
-                linearError == other.linearError;
+            return Fields::Equal(*this, other);
         }
 
         bool operator!=(const Data& other) const 
@@ -112,16 +141,7 @@ namespace Point
 
         friend std::ostream& operator<<(std::ostream& os, const Data& point) 
         {
-            os << "Point: ";
-            if (!point.IsValid()) { os << " -NOT VALID- "; }
-            os << "\n"
-                << "\tLatitude:        " << point.latitude << "\n"
-                << "\tLongitude:       " << point.longitude << "\n"
-                << "\tHAE:             " << point.hae << "\n"
-                << "\tCircular Error:  " << point.circularError << "\n"
-                << "\tLinear Error:    " << point.linearError << "\n"
-                << "\n";
-            return os;
+            return Fields::Print(os, "Point", point, point.IsValid());
         }
     };
 
@@ -140,16 +160,24 @@ namespace Location
         Error
     };
 
-    static const std::unordered_map<Type, std::string> TypeToString
-    {
-        {Type::P, "Space"},
-        {Type::A, "Air"},
-        {Type::G, "Ground"},
-        {Type::S, "Sea Surface"},
-        {Type::U, "Sea Subsurface"},
-        {Type::X, "Other"},
-        {Type::Error, "Error"}
-    };
+    /// @brief Display name of each Type
+    inline constexpr Enums::Table<Type, 7> TypeToString
+    {{
+        "Space", "Air", "Ground", "Sea Surface", "Sea Subsurface", "Other", "Error"
+    }};
+
+    /// @brief Code of each Type, the third 'type' field (battle dimension)
+    inline constexpr Enums::Table<Type, 7> TypeCodes
+    {{
+        "P", "A", "G", "S", "U", "X", ""
+    }};
+    static_assert(TypeToString.Valid() && TypeCodes.Valid(), "no perfect hash seed");
+
+    /// @brief Type from its display name, Error if none
+    constexpr Type StringToType(std::string_view text) { return TypeToString.Find(text, Type::Error); }
+
+    /// @brief Type from its code, Error if none
+    constexpr Type CodeToType(std::string_view code) { return TypeCodes.Find(code, Type::Error); }
 };
 
 namespace How
@@ -164,12 +192,24 @@ namespace How
             Error
         };
 
-        static const std::unordered_map<Type, std::string> TypeToString
-        {
-            {Type::h, "Human"},
-            {Type::m, "Machine"},
-            {Type::Error, "Error"}
-        };
+        /// @brief Display name of each Type
+        inline constexpr Enums::Table<Type, 3> TypeToString
+        {{
+            "Human", "Machine", "Error"
+        }};
+
+        /// @brief Code of each Type, the first 'how' field
+        inline constexpr Enums::Table<Type, 3> TypeCodes
+        {{
+            "h", "m", ""
+        }};
+        static_assert(TypeToString.Valid() && TypeCodes.Valid(), "no perfect hash seed");
+
+        /// @brief Type from its display name, Error if none
+        constexpr Type StringToType(std::string_view text) { return TypeToString.Find(text, Type::Error); }
+
+        /// @brief Type from its code, Error if none
+        constexpr Type CodeToType(std::string_view code) { return TypeCodes.Find(code, Type::Error); }
     };
 
     /// @brief Data section of the 'how' data
@@ -192,22 +232,36 @@ namespace How
             Error
         };
 
-        static const std::unordered_map<Type, std::string> TypeToString
+        /// @brief Display name of each Type
+        inline constexpr Enums::Table<Type, 13> TypeToString
+        {{
+            "Estimated", "Calculated", "Transcribed", "Cut and Paste", "Mensurated", "Derived From GPS",
+            "Magnetic", "Simulated", "Fused", "Configured", "Predicted", "Relayed", "Error"
+        }};
+
+        /// @brief Code of each Type after an "h" entry, the second 'how' field
+        inline constexpr Enums::Table<Type, 13> HumanCodes
+        {{
+            "e", "c", "t", "p", "", "", "", "", "", "", "", "", ""
+        }};
+
+        /// @brief Code of each Type after an "m" entry; "c" and "p" mean
+        ///        something else than after "h"
+        inline constexpr Enums::Table<Type, 13> MachineCodes
+        {{
+            "", "", "", "", "i", "g", "m", "s", "f", "c", "p", "r", ""
+        }};
+        static_assert(TypeToString.Valid() && HumanCodes.Valid() && MachineCodes.Valid(), "no perfect hash seed");
+
+        /// @brief Type from its display name, Error if none
+        constexpr Type StringToType(std::string_view text) { return TypeToString.Find(text, Type::Error); }
+
+        /// @brief Type from its code under an entry type, Error if none
+        constexpr Type CodeToType(std::string_view code, Entry::Type entry)
         {
-            {Type::e, "Estimated"},
-            {Type::cal, "Calculated"},
-            {Type::t, "Transcribed"},
-            {Type::paste, "Cut and Paste"},
-            {Type::i, "Mensurated"},
-            {Type::g, "Derived From GPS"},
-            {Type::m, "Magnetic"},
-            {Type::s, "Simulated"},
-            {Type::f, "Fused"},
-            {Type::con, "Configured"},
-            {Type::pred, "Predicted"},
-            {Type::r, "Relayed"},
-            {Type::Error, "Error"}
-        };
+            return entry == Entry::Type::h ? HumanCodes.Find(code, Type::Error) :
+                (entry == Entry::Type::m ? MachineCodes.Find(code, Type::Error) : Type::Error);
+        }
     };
 };
 
@@ -294,16 +348,40 @@ public:
         return Date::IsValid() && Time::IsValid();
     }
 
-    std::string ToCOTTimestamp() const 
+    /// @brief Current UTC time
+    static DateTime Now()
+    {
+        return NowPlus(0);
+    }
+
+    /// @brief Current UTC time plus an offset in seconds, e.g. a stale time
+    static DateTime NowPlus(double seconds)
+    {
+        const Format::Civil c = Format::UtcNow(seconds);
+        return DateTime(c.year, c.month, c.day, c.hour, c.minute, c.second);
+    }
+
+    Format::Civil ToCivil() const
+    {
+        return Format::Civil{ year, month, day, hour, minute, second };
+    }
+
+    /// @brief Timestamp text, e.g. "2022-12-22T18:06:59.36Z"
+    /// @param decimals - [in/opt] - fractional second digits
+    std::string ToCOTTimestamp(int decimals = 2) const 
+    {
+        COT_ALLOC_SCOPE(timestamp, "DateTime::ToCOTTimestamp");
+        char buffer[Format::MaxTimestamp];
+        return std::string(buffer, WriteCOTTimestamp(buffer, decimals));
+    }
+
+    /// @brief Write the timestamp text without allocating
+    /// @param out      - [out] - buffer of at least Format::MaxTimestamp characters
+    /// @param decimals - [in/opt] - fractional second digits
+    /// @return one past the last character written
+    char* WriteCOTTimestamp(char* out, int decimals = 2) const
     {
-        std::stringstream timestamp;
-        timestamp << std::setfill('0') << std::setw(4) << year << "-"
-            << std::setfill('0') << std::setw(2) << month << "-"
-            << std::setfill('0') << std::setw(2) << day << "T"
-            << std::setfill('0') << std::setw(2) << hour << ":"
-            << std::setfill('0') << std::setw(2) << minute << ":"
-            << std::setfill('0') << std::setw(5) << std::fixed << std::setprecision(2) << second << "Z";
-        return timestamp.str();
+        return Format::WriteTimestamp(out, ToCivil(), decimals);
     }
 
     bool operator==(const DateTime& other) const 
@@ -430,39 +508,40 @@ public:
         version(version), device(device), os(os), platform(platform)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "takv";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("version", "Version", &Takv::version),
+            Fields::Attribute("platform", "Platform", &Takv::platform),
+            Fields::Attribute("os", "OS", &Takv::os),
+            Fields::Attribute("device", "Device", &Takv::device));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Takv& takv) const
+    bool operator == (const Takv& other) const
     {
-        return  (version == takv.version) &&
-            (device == takv.device) &&
-            (os == takv.os) &&
-            (platform == takv.platform);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Takv& takv) const
+    bool operator != (const Takv& other) const
     {
-        return !(*this == takv);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !version.empty() || !device.empty() || !os.empty() || !platform.empty();
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Takv& takv)
+    friend std::ostream& operator<<(std::ostream& os, const Takv& value)
     {
-        os << "TAKV: ";  if (!takv.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tVersion:         " << takv.version << "\n"
-            << "\tDevice:          " << takv.device << "\n"
-            << "\tOS:              " << takv.os << "\n"
-            << "\tPlatform:        " << takv.platform << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "TAKV", value, value.Valid());
     }
 };
 
@@ -481,37 +560,39 @@ public:
         endpoint(endpoint), callsign(callsign), xmppUsername(xmppUsername)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "contact";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("callsign", "Callsign", &Contact::callsign),
+            Fields::Attribute("endpoint", "Endpoint", &Contact::endpoint),
+            Fields::Attribute("xmppUsername", "XMP Username", &Contact::xmppUsername));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Contact& contact) const
+    bool operator == (const Contact& other) const
     {
-        return  (endpoint == contact.endpoint) &&
-            (callsign == contact.callsign) &&
-            (xmppUsername == contact.xmppUsername);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Contact& contact) const
+    bool operator != (const Contact& other) const
     {
-        return !(*this == contact);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !endpoint.empty() || !callsign.empty() || !xmppUsername.empty();
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Contact& contact)
+    friend std::ostream& operator<<(std::ostream& os, const Contact& value)
     {
-        os << "Contact: ";  if (!contact.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tEndpoint:        " << contact.endpoint << "\n"
-            << "\tCallsign:        " << contact.callsign << "\n"
-            << "\tXMP Username:    " << contact.xmppUsername << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "Contact", value, value.Valid());
     }
 };
 
@@ -526,33 +607,37 @@ public:
         droid(droid)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "uid";
+    static constexpr bool Optional = false;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("Droid", "Droid", &Uid::droid));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Uid& uid) const
+    bool operator == (const Uid& other) const
     {
-        return  (droid == uid.droid);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Uid& uid) const
+    bool operator != (const Uid& other) const
     {
-        return !(*this == uid);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !droid.empty();
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Uid& uid)
+    friend std::ostream& operator<<(std::ostream& os, const Uid& value)
     {
-        os << "UID: ";  if (!uid.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tDroid:           " << uid.droid << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "UID", value, value.Valid());
     }
 };
 
@@ -569,35 +654,38 @@ public:
         altsrc(altsrc), geopointsrc(geopointsrc)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "precisionlocation";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("altsrc", "Alt Source", &PrecisionLocation::altsrc),
+            Fields::Attribute("geopointsrc", "Geopoint Source", &PrecisionLocation::geopointsrc));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const PrecisionLocation& preloc) const
+    bool operator == (const PrecisionLocation& other) const
     {
-        return  (altsrc == preloc.altsrc) &&
-            (geopointsrc == preloc.geopointsrc);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const PrecisionLocation& preloc) const
+    bool operator != (const PrecisionLocation& other) const
     {
-        return !(*this == preloc);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !altsrc.empty() || !geopointsrc.empty();
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const PrecisionLocation& preloc)
+    friend std::ostream& operator<<(std::ostream& os, const PrecisionLocation& value)
     {
-        os << "Precision Location: ";  if (!preloc.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tAlt Source:      " << preloc.altsrc << "\n"
-            << "\tGeopoint Source: " << preloc.geopointsrc << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "Precision Location", value, value.Valid());
     }
 };
 
@@ -614,35 +702,38 @@ public:
         role(role), name(name)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "__group";
+    static constexpr bool Optional = false;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("name", "Name", &Group::name),
+            Fields::Attribute("role", "Role", &Group::role));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Group& group) const
+    bool operator == (const Group& other) const
     {
-        return  (role == group.role) &&
-            (name == group.name);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Group& group) const
+    bool operator != (const Group& other) const
     {
-        return !(*this == group);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !role.empty() || !name.empty();
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Group& group)
+    friend std::ostream& operator<<(std::ostream& os, const Group& value)
     {
-        os << "Group: ";  if (!group.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tRole:            " << group.role << "\n"
-            << "\tName:            " << group.name << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "Group", value, value.Valid());
     }
 };
 
@@ -657,33 +748,37 @@ public:
         battery(battery)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "status";
+    static constexpr bool Optional = false;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("battery", "Battery", &Status::battery));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Status& status) const
+    bool operator == (const Status& other) const
     {
-        return  (battery == status.battery);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Status& status) const
+    bool operator != (const Status& other) const
     {
-        return !(*this == status);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !isnan(battery);
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Status& status)
+    friend std::ostream& operator<<(std::ostream& os, const Status& value)
     {
-        os << "Status: ";  if (!status.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tBattery:         " << status.battery << "\n"
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "Status", value, value.Valid());
     }
 };
 
@@ -700,34 +795,445 @@ public:
         course(course), speed(speed)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "track";
+    static constexpr bool Optional = false;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("course", "Course", &Track::course),
+            Fields::Attribute("speed", "Speed", &Track::speed));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Track& track) const
+    bool operator == (const Track& other) const
     {
-        return  (course == track.course) &&
-            (speed == track.speed);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Track& track) const
+    bool operator != (const Track& other) const
     {
-        return !(*this == track);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return !isnan(course) && !isnan(speed);
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Track& track)
+    friend std::ostream& operator<<(std::ostream& os, const Track& value)
     {
-        os << "Track: ";  if (!track.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << "\tCourse:          " << track.course << "\n"
-            << "\tSpeed:           " << track.speed << "\n"
-            << "\n";
+        return Fields::Print(os, "Track", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for Link data. The first <link> with no
+///        'point' attribute, e.g. the sender a chat message or alert refers to.
+class Link
+{
+public:
+    std::string uid;                /// Uid of the linked event
+    std::string type;               /// Type of the linked event
+    std::string relation;           /// Relation to it, e.g. "p-p" (parent)
+    std::string parentCallsign;     /// Callsign of the parent
+    std::string productionTime;     /// When the link was made, as sent
+
+    /// @brief Constructor - Initializes Everything
+    Link(const std::string uid = "",
+        const std::string type = "",
+        const std::string relation = "",
+        const std::string parentCallsign = "",
+        const std::string productionTime = "") :
+        uid(uid), type(type), relation(relation), parentCallsign(parentCallsign), productionTime(productionTime)
+    {}
+
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "link";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("uid", "UID", &Link::uid),
+            Fields::Attribute("type", "Type", &Link::type),
+            Fields::Attribute("relation", "Relation", &Link::relation),
+            Fields::Attribute("parent_callsign", "Parent Callsign", &Link::parentCallsign),
+            Fields::Attribute("production_time", "Production Time", &Link::productionTime));
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const Link& other) const
+    {
+        return Fields::Equal(*this, other);
+    }
 
+    /// @brief Equal comparison operator
+    bool operator != (const Link& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return Fields::Valid(*this);
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const Link& value)
+    {
+        return Fields::Print(os, "Link", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for Remarks data, free text such as a
+///        chat message body
+class Remarks
+{
+public:
+    std::string source;             /// Sender, e.g. "BAO.F.ATAK.<uid>"
+    std::string to;                 /// Recipient or chat room
+    std::string time;               /// Time the remark was made, as sent
+    std::string text;               /// Element text
+
+    /// @brief Constructor - Initializes Everything
+    Remarks(const std::string source = "",
+        const std::string to = "",
+        const std::string time = "",
+        const std::string text = "") :
+        source(source), to(to), time(time), text(text)
+    {}
+
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "remarks";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("source", "Source", &Remarks::source),
+            Fields::Attribute("to", "To", &Remarks::to),
+            Fields::Attribute("time", "Time", &Remarks::time),
+            Fields::Text("Text", &Remarks::text));
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const Remarks& other) const
+    {
+        return Fields::Equal(*this, other);
+    }
+
+    /// @brief Equal comparison operator
+    bool operator != (const Remarks& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return Fields::Valid(*this);
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const Remarks& value)
+    {
+        return Fields::Print(os, "Remarks", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for Emergency data (b-a-o-* alerts)
+class Emergency
+{
+public:
+    std::string type;               /// Alert kind, e.g. "911 Alert", "Ring The Bell"
+    std::string cancel;             /// "true" when the alert is cancelled
+    std::string text;               /// Element text, the callsign in alert
+
+    /// @brief Constructor - Initializes Everything
+    Emergency(const std::string type = "",
+        const std::string cancel = "",
+        const std::string text = "") :
+        type(type), cancel(cancel), text(text)
+    {}
+
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "emergency";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("type", "Type", &Emergency::type),
+            Fields::Attribute("cancel", "Cancel", &Emergency::cancel),
+            Fields::Text("Callsign", &Emergency::text));
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const Emergency& other) const
+    {
+        return Fields::Equal(*this, other);
+    }
+
+    /// @brief Equal comparison operator
+    bool operator != (const Emergency& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return Fields::Valid(*this);
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const Emergency& value)
+    {
+        return Fields::Print(os, "Emergency", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for ChatGroup data, the <chatgrp> in <__chat>
+class ChatGroup
+{
+public:
+    std::string uid0;               /// Sender uid
+    std::string uid1;               /// Recipient uid or room
+    std::string id;                 /// Room id
+
+    /// @brief Constructor - Initializes Everything
+    ChatGroup(const std::string uid0 = "",
+        const std::string uid1 = "",
+        const std::string id = "") :
+        uid0(uid0), uid1(uid1), id(id)
+    {}
+
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "chatgrp";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("uid0", "UID 0", &ChatGroup::uid0),
+            Fields::Attribute("uid1", "UID 1", &ChatGroup::uid1),
+            Fields::Attribute("id", "ID", &ChatGroup::id));
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const ChatGroup& other) const
+    {
+        return Fields::Equal(*this, other);
+    }
+
+    /// @brief Equal comparison operator
+    bool operator != (const ChatGroup& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return Fields::Valid(*this);
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const ChatGroup& value)
+    {
+        return Fields::Print(os, "Chat Group", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for GeoChat data (b-t-f), the <__chat>
+///        element. The message body is in Remarks.
+class Chat
+{
+public:
+    std::string parent;             /// Contact group, e.g. "RootContactGroup"
+    std::string groupOwner;         /// "true" or "false"
+    std::string messageId;          /// Message id
+    std::string chatroom;           /// Room name
+    std::string id;                 /// Room id
+    std::string senderCallsign;     /// Callsign of the sender
+    ChatGroup chatGroup;            /// ChatGroup Sub-Schema
+
+    /// @brief Constructor - Initializes Everything
+    Chat(const std::string parent = "",
+        const std::string groupOwner = "",
+        const std::string messageId = "",
+        const std::string chatroom = "",
+        const std::string id = "",
+        const std::string senderCallsign = "",
+        const ChatGroup chatGroup = ChatGroup()) :
+        parent(parent), groupOwner(groupOwner), messageId(messageId), chatroom(chatroom),
+        id(id), senderCallsign(senderCallsign), chatGroup(chatGroup)
+    {}
+
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "__chat";
+    static constexpr bool Optional = true;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Attribute("parent", "Parent", &Chat::parent),
+            Fields::Attribute("groupOwner", "Group Owner", &Chat::groupOwner),
+            Fields::Attribute("messageId", "Message ID", &Chat::messageId),
+            Fields::Attribute("chatroom", "Chatroom", &Chat::chatroom),
+            Fields::Attribute("id", "ID", &Chat::id),
+            Fields::Attribute("senderCallsign", "Sender Callsign", &Chat::senderCallsign),
+            Fields::Extension("chatGroup", &Chat::chatGroup));
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const Chat& other) const
+    {
+        return Fields::Equal(*this, other);
+    }
+
+    /// @brief Equal comparison operator
+    bool operator != (const Chat& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return Fields::Valid(*this);
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const Chat& value)
+    {
+        return Fields::Print(os, "Chat", value, value.Valid());
+    }
+};
+
+/// @brief A COT Message subschema class for drawn shapes and routes (u-d-*).
+///        The vertices come from the <link point="lat,lon[,hae]"/> children of
+///        <detail> and are kept as parallel arrays, not an object per vertex.
+///        There is no field table; the parser reads it by hand.
+class Shape
+{
+public:
+    std::vector<double> latitude;   /// Vertex latitudes
+    std::vector<double> longitude;  /// Vertex longitudes
+    std::vector<double> hae;        /// Vertex heights, NaN when the point is only "lat,lon"
+    std::string strokeColor;        /// <strokeColor value>, ARGB as a signed integer
+    double strokeWeight;            /// <strokeWeight value>
+    std::string fillColor;          /// <fillColor value>, ARGB as a signed integer
+
+    /// @brief Constructor - Initializes Everything
+    Shape(const std::string strokeColor = "",
+        const double strokeWeight = NAN,
+        const std::string fillColor = "") :
+        strokeColor(strokeColor), strokeWeight(strokeWeight), fillColor(fillColor)
+    {}
+
+    /// @brief Element the vertices are read from
+    static constexpr const char* Element = "link";
+
+    /// @brief Decimal places written for vertices, about 1 cm and 10 cm
+    static constexpr int LatLonDecimals = 7;
+    static constexpr int HaeDecimals = 1;
+
+    /// @brief Number of vertices
+    size_t Size(void) const
+    {
+        return latitude.size();
+    }
+
+    /// @brief Append a vertex
+    void Add(double lat, double lon, double height = NAN)
+    {
+        latitude.push_back(lat);
+        longitude.push_back(lon);
+        hae.push_back(height);
+    }
+
+    /// @brief Remove the vertices and style, keeping the arrays' capacity
+    void Clear(void)
+    {
+        latitude.clear();
+        longitude.clear();
+        hae.clear();
+        strokeColor.clear();
+        strokeWeight = NAN;
+        fillColor.clear();
+    }
+
+    /// @brief Equal comparison operator
+    bool operator == (const Shape& other) const
+    {
+        return latitude == other.latitude && longitude == other.longitude && hae == other.hae &&
+            strokeColor == other.strokeColor && strokeWeight == other.strokeWeight && fillColor == other.fillColor;
+    }
+
+    /// @brief Equal comparison operator
+    bool operator != (const Shape& other) const
+    {
+        return !(*this == other);
+    }
+
+    /// @brief Does class have valid data ? 
+    bool Valid(void) const
+    {
+        return !latitude.empty() && longitude.size() == latitude.size() && hae.size() == latitude.size();
+    }
+
+    /// @brief Append the vertices as <link point> elements, then the style
+    ///        elements that are set. Nothing when there are no vertices.
+    void AppendXML(std::string& out) const
+    {
+        if (!Valid())
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < Size(); i++)
+        {
+            out += "<link point=\"";
+            Format::AppendFixed(out, latitude[i], LatLonDecimals);
+            out += ',';
+            Format::AppendFixed(out, longitude[i], LatLonDecimals);
+            if (!std::isnan(hae[i]))
+            {
+                out += ',';
+                Format::AppendFixed(out, hae[i], HaeDecimals);
+            }
+            out += "\"/>";
+        }
+        if (!strokeColor.empty())
+        {
+            out += "<strokeColor value=\"";
+            Format::AppendEscaped(out, strokeColor);
+            out += "\"/>";
+        }
+        if (!std::isnan(strokeWeight))
+        {
+            out += "<strokeWeight value=\"";
+            Fields::Impl::AppendValue(out, strokeWeight);
+            out += "\"/>";
+        }
+        if (!fillColor.empty())
+        {
+            out += "<fillColor value=\"";
+            Format::AppendEscaped(out, fillColor);
+            out += "\"/>";
+        }
+    }
+
+    /// @brief Print the class
+    friend std::ostream& operator<<(std::ostream& os, const Shape& value)
+    {
+        os << "Shape: ";  if (!value.Valid()) { os << " -NOT VALID- "; }
+        os << "\n";
+        Fields::Impl::Label(os, "Vertices");        os << value.Size() << "\n";
+        Fields::Impl::Label(os, "Stroke Color");    os << value.strokeColor << "\n";
+        Fields::Impl::Label(os, "Stroke Weight");   os << value.strokeWeight << "\n";
+        Fields::Impl::Label(os, "Fill Color");      os << value.fillColor << "\n";
+        os << "\n";
         return os;
     }
 };
@@ -743,6 +1249,11 @@ public:
     Group group;                            /// Group Sub-Schema
     Status status;                          /// Status Sub-Schema
     Track track;                            /// Track Sub-Schema
+    Link link;                              /// Link Sub-Schema, present on some messages
+    Remarks remarks;                        /// Remarks Sub-Schema, present on some messages
+    Emergency emergency;                    /// Emergency Sub-Schema, present on alerts
+    Chat chat;                              /// Chat Sub-Schema, present on GeoChat
+    Shape shape;                            /// Shape Sub-Schema, present on drawings and routes
 
     /// @brief Constructor - Initializes Everything
     Detail(const Takv takv = Takv(),
@@ -751,7 +1262,12 @@ public:
         const PrecisionLocation precisionLocation = PrecisionLocation(),
         const Group group = Group(),
         const Status status = Status(),
-        const Track track = Track()
+        const Track track = Track(),
+        const Link link = Link(),
+        const Remarks remarks = Remarks(),
+        const Emergency emergency = Emergency(),
+        const Chat chat = Chat(),
+        const Shape shape = Shape()
     ) :
         takv(takv),
         contact(contact),
@@ -759,69 +1275,56 @@ public:
         precisionLocation(precisionLocation),
         group(group),
         status(status),
-        track(track)
+        track(track),
+        link(link),
+        remarks(remarks),
+        emergency(emergency),
+        chat(chat),
+        shape(shape)
     {}
 
+    /// @brief XML element and field table, see cot_fields.h
+    static constexpr const char* Element = "detail";
+    static constexpr bool Optional = false;
+    static constexpr auto Describe()
+    {
+        return std::make_tuple(
+            Fields::Element("takv", &Detail::takv),
+            Fields::Element("contact", &Detail::contact),
+            Fields::Element("uid", &Detail::uid),
+            Fields::Element("precisionLocation", &Detail::precisionLocation),
+            Fields::Element("group", &Detail::group),
+            Fields::Element("status", &Detail::status),
+            Fields::Element("track", &Detail::track),
+            Fields::Extension("link", &Detail::link),
+            Fields::Extension("remarks", &Detail::remarks),
+            Fields::Extension("emergency", &Detail::emergency),
+            Fields::Extension("chat", &Detail::chat),
+            Fields::Extension("shape", &Detail::shape));
+    }
+
     /// @brief Equal comparison operator
-    bool operator == (const Detail& detail) const
+    bool operator == (const Detail& other) const
     {
-        return  (takv == detail.takv) &&
-            (contact == detail.contact) &&
-            (uid == detail.uid) &&
-            (precisionLocation == detail.precisionLocation) &&
-            (group == detail.group) &&
-            (status == detail.status) &&
-            (track == detail.track);
+        return Fields::Equal(*this, other);
     }
 
     /// @brief Equal comparison operator
-    bool operator != (const Detail& detail) const
+    bool operator != (const Detail& other) const
     {
-        return !(*this == detail);
+        return !(*this == other);
     }
 
     /// @brief Does class have valid data ? 
     bool Valid(void) const
     {
-        return (takv.Valid() &&
-            contact.Valid() &&
-            uid.Valid() &&
-            precisionLocation.Valid() &&
-            group.Valid() &&
-            status.Valid() &&
-            track.Valid());
+        return Fields::Valid(*this);
     }
 
     /// @brief Print the class
-    friend std::ostream& operator<<(std::ostream& os, const Detail& detail)
+    friend std::ostream& operator<<(std::ostream& os, const Detail& value)
     {
-        /*
-        *  NOTE: This will print only the valid sub-schemas.
-
-            os << "Detail:\n";
-            if (detail.takv.Valid()) { os << detail.takv; }
-            if (detail.contact.Valid()) { os << detail.contact; }
-            if (detail.uid.Valid()) { os << detail.uid; }
-            if (detail.precisionLocation.Valid()) { os << detail.precisionLocation; }
-            if (detail.group.Valid()) { os << detail.group; }
-            if (detail.status.Valid()) { os << detail.status; }
-            if (detail.track.Valid()) { os << detail.track; }
-            os << "\n";
-
-        */
-
-        os << "Detail: ";  if (!detail.Valid()) { os << " -NOT VALID- "; }
-        os << "\n"
-            << detail.takv
-            << detail.contact
-            << detail.uid
-            << detail.precisionLocation
-            << detail.group
-            << detail.status
-            << detail.track
-            << "\n";
-
-        return os;
+        return Fields::Print(os, "Detail", value, value.Valid());
     }
 };
 
@@ -0,0 +1,421 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_json.cpp
+// @brief           Implementation of the JSON and GeoJSON writers
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cmath>                        // isfinite, isnan
+#include <type_traits>                  // decay_t
+#include <utility>                      // move
+//
+#include "cot_fields.h"                 // ForEach, Valid
+#include "cot_json.h"                   // JSON header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief CoT writes this for a height, circular or linear error it does not know
+    const double kUnknown = 9999999;
+
+    /// @brief What the element writers need from the options
+    struct Context
+    {
+        int     decimals;
+        bool    vertices;       /// Write shape vertices; a Feature has them as its geometry
+    };
+
+    /// @brief A real, or null when it is NaN or infinite, which JSON cannot hold
+    void AppendReal(std::string& out, double value, int decimals)
+    {
+        if (!std::isfinite(value))
+        {
+            out += "null";
+            return;
+        }
+        char buffer[Format::MaxNumber];
+        out.append(buffer, Format::WriteTrimmed(buffer, value, decimals));
+    }
+
+    /// @brief A key and its colon. Keys are the table names, which need no escaping.
+    void AppendKey(std::string& out, const char* key)
+    {
+        out += '"';
+        out += key;
+        out += "\":";
+    }
+
+    void AppendValue(std::string& out, const std::string& value, const Context&)
+    {
+        Format::AppendJsonString(out, value);
+    }
+
+    void AppendValue(std::string& out, double value, const Context& context)
+    {
+        AppendReal(out, value, context.decimals);
+    }
+
+    /// @brief [lon, lat] or [lon, lat, hae], GeoJSON's order
+    void AppendPosition(std::string& out, double lat, double lon, double hae, int decimals, int haeDecimals)
+    {
+        out += '[';
+        AppendReal(out, lon, decimals);
+        out += ',';
+        AppendReal(out, lat, decimals);
+        if (std::isfinite(hae) && hae != kUnknown)
+        {
+            out += ',';
+            AppendReal(out, hae, haeDecimals);
+        }
+        out += ']';
+    }
+
+    /// @brief A nested element is written when the XML writer would write it
+    template <class T>
+    bool Present(const T& obj)
+    {
+        if constexpr (T::Optional)
+        {
+            return Fields::Valid(obj);
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    bool Present(const Shape& shape)
+    {
+        return shape.Valid();
+    }
+
+    /// @brief Vertices as [lat, lon] or [lat, lon, hae], the order of a CoT
+    ///        link point, then the style values that are set
+    void AppendElement(std::string& out, const Shape& shape, const Context& context)
+    {
+        char separator = '{';
+        if (context.vertices)
+        {
+            out += "{\"vertices\":[";
+            for (size_t i = 0; i < shape.Size(); i++)
+            {
+                out += (i == 0) ? "[" : ",[";
+                AppendReal(out, shape.latitude[i], Shape::LatLonDecimals);
+                out += ',';
+                AppendReal(out, shape.longitude[i], Shape::LatLonDecimals);
+                if (!std::isnan(shape.hae[i]))
+                {
+                    out += ',';
+                    AppendReal(out, shape.hae[i], Shape::HaeDecimals);
+                }
+                out += ']';
+            }
+            out += ']';
+            separator = ',';
+        }
+        if (!shape.strokeColor.empty())
+        {
+            out += separator;
+            separator = ',';
+            AppendKey(out, "strokeColor");
+            Format::AppendJsonString(out, shape.strokeColor);
+        }
+        if (!std::isnan(shape.strokeWeight))
+        {
+            out += separator;
+            separator = ',';
+            AppendKey(out, "strokeWeight");
+            AppendReal(out, shape.strokeWeight, context.decimals);
+        }
+        if (!shape.fillColor.empty())
+        {
+            out += separator;
+            separator = ',';
+            AppendKey(out, "fillColor");
+            Format::AppendJsonString(out, shape.fillColor);
+        }
+        out += (separator == '{') ? "{}" : "}";
+    }
+
+    /// @brief An element as an object from its field table: attributes by XML
+    ///        name, text content as "text", nested elements by member name
+    template <class T>
+    void AppendElement(std::string& out, const T& obj, const Context& context)
+    {
+        char separator = '{';
+        Fields::ForEach<T>([&](const auto& d)
+        {
+            using D = std::decay_t<decltype(d)>;
+            if constexpr (Fields::IsChild<D>::value)
+            {
+                if (!Present(obj.*d.member))
+                {
+                    return;
+                }
+                out += separator;
+                AppendKey(out, d.name);
+                AppendElement(out, obj.*d.member, context);
+            }
+            else if constexpr (Fields::IsContent<D>::value)
+            {
+                out += separator;
+                AppendKey(out, "text");
+                Format::AppendJsonString(out, obj.*d.member);
+            }
+            else
+            {
+                out += separator;
+                AppendKey(out, d.xml);
+                AppendValue(out, obj.*d.member, context);
+            }
+            separator = ',';
+        });
+        out += (separator == '{') ? "{}" : "}";
+    }
+
+    /// @brief Name of an enum value, or null for Error
+    template <class Table, class E>
+    void AppendName(std::string& out, const Table& names, E value)
+    {
+        if (value == E::Error)
+        {
+            out += "null";
+            return;
+        }
+        out += '"';
+        out += names.at(value);
+        out += '"';
+    }
+};
+
+JsonWriter::JsonWriter(const Options& options)
+    : mOptions(options), mTimes(options.seconds)
+{
+}
+
+void JsonWriter::AppendTime(std::string& out, const DateTime& time)
+{
+    if (!time.IsValid())
+    {
+        out += "null";
+        return;
+    }
+    char buffer[Format::MaxTimestamp + 2];
+    buffer[0] = '"';
+    char* end = mTimes.Write(buffer + 1, time.ToCivil());
+    *end++ = '"';
+    out.append(buffer, end);
+}
+
+void JsonWriter::AppendEvent(std::string& out, const COTSchema& cot)
+{
+    const Event& e = cot.event;
+    out += "\"version\":";
+    AppendReal(out, e.version, mOptions.decimals);
+    out += ",\"type\":";
+    Format::AppendJsonString(out, e.type);
+    out += ",\"uid\":";
+    Format::AppendJsonString(out, e.uid);
+    out += ",\"time\":";
+    AppendTime(out, e.time);
+    out += ",\"start\":";
+    AppendTime(out, e.start);
+    out += ",\"stale\":";
+    AppendTime(out, e.stale);
+    out += ",\"how\":";
+    Format::AppendJsonString(out, e.how);
+    out += ",\"affiliation\":";
+    AppendName(out, Point::TypeToString, e.indicator);
+    out += ",\"dimension\":";
+    AppendName(out, Location::TypeToString, e.location);
+}
+
+void JsonWriter::AppendObject(std::string& out, const COTSchema& cot)
+{
+    const Context context{ mOptions.decimals, true };
+    out += '{';
+    AppendEvent(out, cot);
+    out += ",\"point\":";
+    AppendElement(out, cot.point, context);
+    if (mOptions.detail)
+    {
+        out += ",\"detail\":";
+        AppendElement(out, cot.detail, context);
+    }
+    out += '}';
+}
+
+void JsonWriter::AppendFeature(std::string& out, const COTSchema& cot)
+{
+    const Context context{ mOptions.decimals, false };
+    const Shape& shape = cot.detail.shape;
+
+    out += "{\"type\":\"Feature\",\"id\":";
+    Format::AppendJsonString(out, cot.event.uid);
+    out += ",\"geometry\":";
+    if (shape.Valid())
+    {
+        const size_t last = shape.Size() - 1;
+        const bool closed = shape.Size() >= 4 &&
+            shape.latitude[0] == shape.latitude[last] && shape.longitude[0] == shape.longitude[last];
+        out += closed ? "{\"type\":\"Polygon\",\"coordinates\":[[" : "{\"type\":\"LineString\",\"coordinates\":[";
+        for (size_t i = 0; i < shape.Size(); i++)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            AppendPosition(out, shape.latitude[i], shape.longitude[i], shape.hae[i], Shape::LatLonDecimals, Shape::HaeDecimals);
+        }
+        out += closed ? "]]}" : "]}";
+    }
+    else if (std::isfinite(cot.point.latitude) && std::isfinite(cot.point.longitude))
+    {
+        out += "{\"type\":\"Point\",\"coordinates\":";
+        AppendPosition(out, cot.point.latitude, cot.point.longitude, cot.point.hae, mOptions.decimals, mOptions.decimals);
+        out += '}';
+    }
+    else
+    {
+        out += "null";
+    }
+
+    out += ",\"properties\":{";
+    AppendEvent(out, cot);
+    out += ",\"ce\":";
+    AppendReal(out, cot.point.circularError, mOptions.decimals);
+    out += ",\"le\":";
+    AppendReal(out, cot.point.linearError, mOptions.decimals);
+    if (mOptions.detail)
+    {
+        out += ",\"detail\":";
+        AppendElement(out, cot.detail, context);
+    }
+    out += "}}";
+}
+
+void JsonWriter::AppendArray(std::string& out, const std::vector<COTSchema>& cots)
+{
+    out += '[';
+    for (size_t i = 0; i < cots.size(); i++)
+    {
+        if (i > 0)
+        {
+            out += ',';
+        }
+        AppendObject(out, cots[i]);
+    }
+    out += ']';
+}
+
+void JsonWriter::AppendFeatureCollection(std::string& out, const std::vector<COTSchema>& cots)
+{
+    out += "{\"type\":\"FeatureCollection\",\"features\":[";
+    for (size_t i = 0; i < cots.size(); i++)
+    {
+        if (i > 0)
+        {
+            out += ',';
+        }
+        AppendFeature(out, cots[i]);
+    }
+    out += "]}";
+}
+
+std::string JsonWriter::ToJson(const COTSchema& cot)
+{
+    std::string out;
+    AppendObject(out, cot);
+    return out;
+}
+
+std::string JsonWriter::ToGeoJson(const COTSchema& cot)
+{
+    std::string out;
+    AppendFeature(out, cot);
+    return out;
+}
+
+JsonStream::JsonStream(Layout layout, Sink sink, const JsonWriter::Options& options, size_t flushBytes)
+    : mWriter(options), mLayout(layout), mSink(std::move(sink)), mFlushBytes(flushBytes), mCount(0), mFinished(false)
+{
+    // Room for the largest message past the flush point, so the buffer rarely grows
+    mBuffer.reserve(mFlushBytes + 4096);
+    if (mLayout == Layout::Array)
+    {
+        mBuffer += '[';
+    }
+    else if (mLayout == Layout::FeatureCollection)
+    {
+        mBuffer += "{\"type\":\"FeatureCollection\",\"features\":[";
+    }
+}
+
+void JsonStream::Add(const COTSchema& cot)
+{
+    if (mFinished)
+    {
+        return;
+    }
+
+    if (mLayout == Layout::Lines)
+    {
+        mWriter.AppendObject(mBuffer, cot);
+        mBuffer += '\n';
+    }
+    else
+    {
+        if (mCount > 0)
+        {
+            mBuffer += ',';
+        }
+        if (mLayout == Layout::Array)
+        {
+            mWriter.AppendObject(mBuffer, cot);
+        }
+        else
+        {
+            mWriter.AppendFeature(mBuffer, cot);
+        }
+    }
+    mCount++;
+
+    if (mBuffer.size() >= mFlushBytes)
+    {
+        Flush();
+    }
+}
+
+void JsonStream::Finish()
+{
+    if (mFinished)
+    {
+        return;
+    }
+
+    if (mLayout == Layout::Array)
+    {
+        mBuffer += ']';
+    }
+    else if (mLayout == Layout::FeatureCollection)
+    {
+        mBuffer += "]}";
+    }
+    Flush();
+    mFinished = true;
+}
+
+void JsonStream::Flush()
+{
+    if (!mBuffer.empty())
+    {
+        mSink(mBuffer.data(), mBuffer.size());
+        mBuffer.clear();
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_json.h
+// @brief           JSON and GeoJSON writers for COTSchema.
+//
+//                  Objects are appended straight into a caller string with the
+//                  Format number and timestamp writers, so a reused string
+//                  writes without allocating and nothing is built in between.
+//                  The point and detail fields come from the field tables in
+//                  cot_info.h, keyed by their XML attribute and member names:
+//                      {"version":2,"type":"a-f-G-E-V-A","uid":"...",
+//                       "time":"2022-12-22T18:06:59.36Z",...,"how":"h-e",
+//                       "affiliation":"Friend","dimension":"Ground",
+//                       "point":{"lat":31.5990919,"lon":-81.7768699,...},
+//                       "detail":{"takv":{...},"contact":{...},...}}
+//                  A real that is not set (NaN) or infinite is null, as is an
+//                  invalid time. Optional elements (takv, contact, link, chat...)
+//                  are left out unless valid, as GenerateXMLCOTMessage does.
+//
+//                  A GeoJSON Feature has the point, or the vertices of a drawn
+//                  shape, as its geometry and the other fields as properties.
+//                  JsonStream writes a batch of any size through a bounded
+//                  buffer handed to a sink.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint64_t
+#include <functional>                       // function
+#include <string>                           // string
+#include <vector>                           // vector
+//
+#include "cot_format.h"                     // TimestampWriter
+#include "cot_info.h"                       // COTSchema
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+class JsonWriter
+{
+public:
+
+    /// @brief What is written and how precisely
+    struct Options
+    {
+        int     decimals;           /// Places kept for reals, trailing zeros dropped; about 1 cm at 7
+        int     seconds;            /// Fractional second digits of time, start and stale
+        bool    detail;             /// Write the detail object
+
+        /// @brief Constructor - Initializes Everything
+        Options(int decimals = 7, int seconds = 2, bool detail = true)
+            : decimals(decimals), seconds(seconds), detail(detail) {}
+    };
+
+    /// @brief Constructor - Initializes Everything
+    explicit JsonWriter(const Options& options = Options());
+
+    /// @brief Append one message as a JSON object
+    void AppendObject(std::string& out, const COTSchema& cot);
+
+    /// @brief Append one message as a GeoJSON Feature. The geometry is a Point
+    ///        [lon, lat, hae], without hae when it is unknown (NaN or the CoT
+    ///        9999999), or null when lat/lon are not set. A drawn shape is a
+    ///        LineString of its vertices, or a Polygon when it closes on its
+    ///        first vertex. The Feature id is the uid.
+    void AppendFeature(std::string& out, const COTSchema& cot);
+
+    /// @brief Append a JSON array of objects
+    void AppendArray(std::string& out, const std::vector<COTSchema>& cots);
+
+    /// @brief Append a GeoJSON FeatureCollection
+    void AppendFeatureCollection(std::string& out, const std::vector<COTSchema>& cots);
+
+    /// @brief One message as a new JSON string
+    std::string ToJson(const COTSchema& cot);
+
+    /// @brief One message as a new GeoJSON Feature string
+    std::string ToGeoJson(const COTSchema& cot);
+
+private:
+
+    /// @brief Event fields as object members, without the braces
+    void AppendEvent(std::string& out, const COTSchema& cot);
+
+    /// @brief A timestamp string, or null when it is not valid
+    void AppendTime(std::string& out, const DateTime& time);
+
+    Options                     mOptions;
+    Format::TimestampWriter     mTimes;
+};
+
+/// @brief Writes a batch of messages of any size. Output collects in a buffer
+///        that is passed to the sink whenever it passes 'flushBytes', so memory
+///        stays bounded whatever the batch size. Not thread safe.
+class JsonStream
+{
+public:
+
+    /// @brief How the messages are laid out
+    enum class Layout
+    {
+        Array,              /// One JSON array of objects
+        Lines,              /// One object per line (NDJSON)
+        FeatureCollection   /// One GeoJSON FeatureCollection
+    };
+
+    /// @brief Receives each chunk of output, in order
+    using Sink = std::function<void(const char* data, size_t size)>;
+
+    /// @brief Constructor - Writes the opening text into the buffer
+    /// @param flushBytes - [in/opt] - buffer size that triggers a flush
+    JsonStream(Layout layout, Sink sink, const JsonWriter::Options& options = JsonWriter::Options(), size_t flushBytes = 64 * 1024);
+
+    /// @brief Add a message. Does nothing after Finish().
+    void Add(const COTSchema& cot);
+
+    /// @brief Write the closing text and flush the rest. A second call does
+    ///        nothing.
+    void Finish();
+
+    /// @brief Messages added so far
+    uint64_t Count() const { return mCount; }
+
+private:
+
+    void Flush();
+
+    JsonWriter      mWriter;
+    Layout          mLayout;
+    Sink            mSink;
+    size_t          mFlushBytes;
+    std::string     mBuffer;
+    uint64_t        mCount;
+    bool            mFinished;
+};
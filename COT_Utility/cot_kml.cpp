@@ -0,0 +1,395 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_kml.cpp
+// @brief           Implementation of the KML and KMZ export
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cmath>                        // isfinite
+#include <cstdlib>                      // strtoll
+#include <utility>                      // move
+//
+#include "cot_kml.h"                    // KML header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief CoT writes this for a height it does not know
+    const double kUnknown = 9999999;
+
+    /// @brief Frame colour (KML aabbggrr) of each affiliation, in Point::Type order
+    const char* const kAffiliationColor[] =
+    {
+        "80ffff",       // Pending: unknown yellow
+        "80ffff",       // Unknown
+        "ffe080",       // Assumed friend: friend blue
+        "ffe080",       // Friend
+        "aaffaa",       // Neutral: green
+        "8080ff",       // Suspect: hostile red
+        "8080ff",       // Hostile
+        "8080ff",       // Joker
+        "8080ff",       // Faker
+        "ffffff",       // None specified: white
+        "ffffff"        // Other
+    };
+    static_assert(sizeof(kAffiliationColor) / sizeof(kAffiliationColor[0]) == static_cast<size_t>(Point::Type::Error), "one colour per affiliation");
+
+    /// @brief Google Earth icon of each dimension, in Location::Type order
+    const char* const kDimensionIcon[] =
+    {
+        "star",                 // Space
+        "airports",             // Air
+        "placemark_square",     // Ground
+        "ferry",                // Sea surface
+        "water",                // Sea subsurface
+        "placemark_circle"      // Other
+    };
+    static_assert(sizeof(kDimensionIcon) / sizeof(kDimensionIcon[0]) == static_cast<size_t>(Location::Type::Error), "one icon per dimension");
+
+    bool KnownHeight(double hae)
+    {
+        return std::isfinite(hae) && hae != kUnknown;
+    }
+
+    /// @brief Affiliation and dimension with Error as other
+    Point::Type Affiliation(const Event& e)
+    {
+        return e.indicator == Point::Type::Error ? Point::Type::x : e.indicator;
+    }
+
+    Location::Type Dimension(const Event& e)
+    {
+        return e.location == Location::Type::Error ? Location::Type::X : e.location;
+    }
+
+    /// @brief A shape colour, ARGB written as a signed integer as ATAK does, in
+    ///        KML's aabbggrr
+    /// @return false when the text is not a number
+    bool AppendColor(std::string& out, const std::string& argb)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        char* end = nullptr;
+        const long long value = std::strtoll(argb.c_str(), &end, 10);
+        if (argb.empty() || *end != '\0')
+        {
+            return false;
+        }
+        const uint32_t v = static_cast<uint32_t>(value);
+        const uint32_t abgr = (v & 0xFF00FF00u) | ((v >> 16) & 0xFF) | ((v & 0xFF) << 16);
+        for (int shift = 28; shift >= 0; shift -= 4)
+        {
+            out += kHex[(abgr >> shift) & 0xF];
+        }
+        return true;
+    }
+
+    /// @brief Document opening and the shared styles
+    void AppendDocumentHeader(std::string& out, const std::string& name)
+    {
+        out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+            "<Document><name>";
+        Format::AppendEscaped(out, name);
+        out += "</name>\n";
+
+        for (size_t a = 0; a < static_cast<size_t>(Point::Type::Error); a++)
+        {
+            for (size_t d = 0; d < static_cast<size_t>(Location::Type::Error); d++)
+            {
+                const char* color = kAffiliationColor[a];
+                out += "<Style id=\"";
+                out += KmlStream::StyleId(static_cast<Point::Type>(a), static_cast<Location::Type>(d));
+                out += "\"><IconStyle><color>ff";
+                out += color;
+                out += "</color><Icon><href>http://maps.google.com/mapfiles/kml/shapes/";
+                out += kDimensionIcon[d];
+                out += ".png</href></Icon></IconStyle><LineStyle><color>ff";
+                out += color;
+                out += "</color><width>2</width></LineStyle><PolyStyle><color>80";
+                out += color;
+                out += "</color></PolyStyle></Style>\n";
+            }
+        }
+    }
+};
+
+std::string KmlStream::StyleId(Point::Type affiliation, Location::Type dimension)
+{
+    std::string id = Point::TypeCodes.at(affiliation == Point::Type::Error ? Point::Type::x : affiliation);
+    id += '-';
+    id += Location::TypeCodes.at(dimension == Location::Type::Error ? Location::Type::X : dimension);
+    return id;
+}
+
+KmlStream::KmlStream(Sink sink, Container container, const Options& options, size_t flushBytes)
+    : mOptions(options), mSink(std::move(sink)), mFlushBytes(flushBytes), mTimes(options.seconds), mCount(0), mFinished(false)
+{
+    if (container != Container::Kml)
+    {
+        mZip.reset(new Zip::Writer(mSink, mFlushBytes));
+        mZip->Begin("doc.kml", container == Container::KmzDeflate ? Zip::Writer::Method::Deflate : Zip::Writer::Method::Stored);
+    }
+
+    mBuffer.reserve(mFlushBytes + 4096);
+    AppendDocumentHeader(mBuffer, mOptions.name);
+}
+
+KmlStream::~KmlStream() = default;
+
+void KmlStream::AppendTime(const DateTime& time)
+{
+    if (time.IsValid())
+    {
+        char buffer[Format::MaxTimestamp];
+        mBuffer.append(buffer, mTimes.Write(buffer, time.ToCivil()));
+    }
+}
+
+void KmlStream::AppendCoordinate(double lat, double lon, double hae, char separator)
+{
+    char buffer[Format::MaxNumber];
+    mBuffer.append(buffer, Format::WriteTrimmed(buffer, lon, mOptions.decimals));
+    mBuffer += separator;
+    mBuffer.append(buffer, Format::WriteTrimmed(buffer, lat, mOptions.decimals));
+    if (KnownHeight(hae))
+    {
+        mBuffer += separator;
+        mBuffer.append(buffer, Format::WriteTrimmed(buffer, hae, 2));
+    }
+}
+
+void KmlStream::AppendHeader(const COTSchema& cot, bool stamp)
+{
+    const std::string& callsign = cot.detail.contact.callsign;
+    mBuffer += "<Placemark><name>";
+    Format::AppendEscaped(mBuffer, callsign.empty() ? cot.event.uid : callsign);
+    mBuffer += "</name>";
+    if (stamp && cot.event.time.IsValid())
+    {
+        mBuffer += "<TimeStamp><when>";
+        AppendTime(cot.event.time);
+        mBuffer += "</when></TimeStamp>";
+    }
+    mBuffer += "<styleUrl>#";
+    mBuffer += Point::TypeCodes.at(Affiliation(cot.event));
+    mBuffer += '-';
+    mBuffer += Location::TypeCodes.at(Dimension(cot.event));
+    mBuffer += "</styleUrl>";
+}
+
+void KmlStream::AppendShapeStyle(const Shape& shape)
+{
+    // The shape's own colours over the shared style; nothing when it has none
+    const size_t mark = mBuffer.size();
+    mBuffer += "<Style><LineStyle><color>";
+    bool own = AppendColor(mBuffer, shape.strokeColor);
+    if (!own)
+    {
+        mBuffer += "ffffffff";
+    }
+    mBuffer += "</color>";
+    if (std::isfinite(shape.strokeWeight))
+    {
+        char buffer[Format::MaxNumber];
+        mBuffer += "<width>";
+        mBuffer.append(buffer, Format::WriteTrimmed(buffer, shape.strokeWeight, 2));
+        mBuffer += "</width>";
+    }
+    mBuffer += "</LineStyle>";
+
+    const size_t poly = mBuffer.size();
+    mBuffer += "<PolyStyle><color>";
+    if (AppendColor(mBuffer, shape.fillColor))
+    {
+        mBuffer += "</color></PolyStyle>";
+        own = true;
+    }
+    else
+    {
+        mBuffer.resize(poly);
+    }
+    mBuffer += "</Style>";
+
+    if (!own)
+    {
+        mBuffer.resize(mark);
+    }
+}
+
+void KmlStream::AppendShapeGeometry(const Shape& shape)
+{
+    const size_t last = shape.Size() - 1;
+    const bool closed = shape.Size() >= 4 &&
+        shape.latitude[0] == shape.latitude[last] && shape.longitude[0] == shape.longitude[last];
+    mBuffer += closed ? "<Polygon><outerBoundaryIs><LinearRing><coordinates>" : "<LineString><coordinates>";
+    for (size_t i = 0; i < shape.Size(); i++)
+    {
+        if (i > 0)
+        {
+            mBuffer += ' ';
+        }
+        AppendCoordinate(shape.latitude[i], shape.longitude[i], NAN, ',');
+    }
+    mBuffer += closed ? "</coordinates></LinearRing></outerBoundaryIs></Polygon>" : "</coordinates></LineString>";
+}
+
+bool KmlStream::Add(const COTSchema& cot)
+{
+    const Point::Data& point = cot.point;
+    const bool shape = cot.detail.shape.Valid();
+    if (mFinished || (!shape && !(std::isfinite(point.latitude) && std::isfinite(point.longitude))))
+    {
+        return false;
+    }
+
+    AppendHeader(cot, true);
+    if (shape)
+    {
+        AppendShapeStyle(cot.detail.shape);
+    }
+
+    mBuffer += "<ExtendedData><Data name=\"uid\"><value>";
+    Format::AppendEscaped(mBuffer, cot.event.uid);
+    mBuffer += "</value></Data><Data name=\"type\"><value>";
+    Format::AppendEscaped(mBuffer, cot.event.type);
+    mBuffer += "</value></Data><Data name=\"how\"><value>";
+    Format::AppendEscaped(mBuffer, cot.event.how);
+    mBuffer += "</value></Data>";
+    if (cot.event.stale.IsValid())
+    {
+        mBuffer += "<Data name=\"stale\"><value>";
+        AppendTime(cot.event.stale);
+        mBuffer += "</value></Data>";
+    }
+    const Track& track = cot.detail.track;
+    if (std::isfinite(track.course) && std::isfinite(track.speed))
+    {
+        char buffer[Format::MaxNumber];
+        mBuffer += "<Data name=\"course\"><value>";
+        mBuffer.append(buffer, Format::WriteTrimmed(buffer, track.course, 2));
+        mBuffer += "</value></Data><Data name=\"speed\"><value>";
+        mBuffer.append(buffer, Format::WriteTrimmed(buffer, track.speed, 2));
+        mBuffer += "</value></Data>";
+    }
+    mBuffer += "</ExtendedData>";
+
+    if (shape)
+    {
+        AppendShapeGeometry(cot.detail.shape);
+    }
+    else
+    {
+        mBuffer += KnownHeight(point.hae) ? "<Point><altitudeMode>absolute</altitudeMode><coordinates>" : "<Point><coordinates>";
+        AppendCoordinate(point.latitude, point.longitude, point.hae, ',');
+        mBuffer += "</coordinates></Point>";
+    }
+    mBuffer += "</Placemark>\n";
+    mCount++;
+
+    if (mBuffer.size() >= mFlushBytes)
+    {
+        Flush();
+    }
+    return true;
+}
+
+bool KmlStream::AddTrack(const std::vector<COTSchema>& reports)
+{
+    if (mFinished)
+    {
+        return false;
+    }
+
+    // gx:Track lists every <when> and then every <gx:coord>, so two passes
+    const auto usable = [](const COTSchema& r)
+    {
+        return r.event.time.IsValid() && std::isfinite(r.point.latitude) && std::isfinite(r.point.longitude);
+    };
+    const COTSchema* last = nullptr;
+    bool heights = true;
+    for (const COTSchema& r : reports)
+    {
+        if (usable(r))
+        {
+            last = &r;
+            heights = heights && KnownHeight(r.point.hae);
+        }
+    }
+    if (last == nullptr)
+    {
+        return false;
+    }
+
+    AppendHeader(*last, false);
+    mBuffer += heights ? "<gx:Track><altitudeMode>absolute</altitudeMode>" : "<gx:Track>";
+    for (const COTSchema& r : reports)
+    {
+        if (usable(r))
+        {
+            mBuffer += "<when>";
+            AppendTime(r.event.time);
+            mBuffer += "</when>";
+        }
+        if (mBuffer.size() >= mFlushBytes)
+        {
+            Flush();
+        }
+    }
+    for (const COTSchema& r : reports)
+    {
+        if (usable(r))
+        {
+            mBuffer += "<gx:coord>";
+            AppendCoordinate(r.point.latitude, r.point.longitude, heights ? r.point.hae : NAN, ' ');
+            mBuffer += "</gx:coord>";
+        }
+        if (mBuffer.size() >= mFlushBytes)
+        {
+            Flush();
+        }
+    }
+    mBuffer += "</gx:Track></Placemark>\n";
+    mCount++;
+
+    if (mBuffer.size() >= mFlushBytes)
+    {
+        Flush();
+    }
+    return true;
+}
+
+bool KmlStream::Finish()
+{
+    if (mFinished)
+    {
+        return true;
+    }
+
+    mBuffer += "</Document>\n</kml>\n";
+    Flush();
+    mFinished = true;
+    return mZip ? mZip->Finish() : true;
+}
+
+void KmlStream::Flush()
+{
+    if (mBuffer.empty())
+    {
+        return;
+    }
+    if (mZip)
+    {
+        mZip->Write(mBuffer.data(), mBuffer.size());
+    }
+    else
+    {
+        mSink(mBuffer.data(), mBuffer.size());
+    }
+    mBuffer.clear();
+}
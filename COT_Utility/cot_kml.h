@@ -0,0 +1,125 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_kml.h
+// @brief           KML and KMZ export of tracks and track history.
+//
+//                  KmlStream writes one Placemark per message and one gx:Track
+//                  per track history, into a bounded buffer handed to a sink,
+//                  optionally zipped as a KMZ (doc.kml) on the way. Nothing
+//                  is kept per placemark, so memory stays the same whatever
+//                  the number exported.
+//
+//                  The document opens with a shared Style for every affiliation
+//                  (Point::Type) and battle dimension (Location::Type) pair:
+//                  the colour is the MIL-STD-2525 frame colour of the affiliation
+//                  (friend blue, hostile red, neutral green, unknown yellow) and
+//                  the icon is picked by dimension. Placemarks refer to them as
+//                  "#<affiliation>-<dimension>", e.g. "#f-G". Drawn shapes are
+//                  LineStrings or Polygons in their own stroke and fill colours.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint64_t
+#include <functional>                       // function
+#include <memory>                           // unique_ptr
+#include <string>                           // string
+#include <vector>                           // vector
+//
+#include "cot_format.h"                     // TimestampWriter
+#include "cot_info.h"                       // COTSchema
+#include "cot_zip.h"                        // Zip::Writer
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+class KmlStream
+{
+public:
+
+    /// @brief File written
+    enum class Container
+    {
+        Kml,                /// Plain KML text
+        KmzStored,          /// KMZ, doc.kml stored uncompressed; fastest
+        KmzDeflate          /// KMZ, doc.kml deflated; about a seventh of the size
+    };
+
+    /// @brief Receives each chunk of output, in order
+    using Sink = std::function<void(const char* data, size_t size)>;
+
+    /// @brief What is written and how precisely
+    struct Options
+    {
+        std::string     name;           /// Document name
+        int             decimals;       /// Places kept for coordinates, trailing zeros dropped
+        int             seconds;        /// Fractional second digits of the times
+
+        /// @brief Constructor - Initializes Everything
+        Options(const std::string& name = "CoT", int decimals = 7, int seconds = 2)
+            : name(name), decimals(decimals), seconds(seconds) {}
+    };
+
+    /// @brief Constructor - Writes the document header and styles
+    /// @param flushBytes - [in/opt] - KML text buffered before it goes on
+    explicit KmlStream(Sink sink, Container container = Container::Kml, const Options& options = Options(), size_t flushBytes = 64 * 1024);
+    ~KmlStream();
+
+    /// @brief Add a Placemark at the message's point, named by its callsign
+    ///        (else its uid), timed at its time, styled by its affiliation and
+    ///        dimension. A message with a drawn shape is placed as the shape.
+    ///        Does nothing after Finish().
+    /// @return false when the message has no position
+    bool Add(const COTSchema& cot);
+
+    /// @brief Add one track's reports, oldest first, as a gx:Track Placemark
+    ///        that Google Earth animates on its time slider. It is named and
+    ///        styled by the last report. Reports without a time or position
+    ///        are skipped.
+    /// @return false when no report has both
+    bool AddTrack(const std::vector<COTSchema>& reports);
+
+    /// @brief Close the document, end the archive and flush. A second call
+    ///        does nothing.
+    /// @return false if the KMZ reached 4 GiB, which zip cannot hold without ZIP64
+    bool Finish();
+
+    /// @brief Placemarks written so far, tracks included
+    uint64_t Count() const { return mCount; }
+
+    /// @brief Id of the shared Style of a pair, e.g. "f-G". Error is "x" for
+    ///        the affiliation and "X" for the dimension, as other.
+    static std::string StyleId(Point::Type affiliation, Location::Type dimension);
+
+private:
+
+    /// @brief Name, time stamp and style of a placemark
+    void AppendHeader(const COTSchema& cot, bool stamp);
+
+    /// @brief "lon,lat[,hae]"
+    void AppendCoordinate(double lat, double lon, double hae, char separator);
+
+    /// @brief A timestamp, or nothing when it is not valid
+    void AppendTime(const DateTime& time);
+
+    /// @brief An inline Style with a drawn shape's colours, before the ExtendedData
+    void AppendShapeStyle(const Shape& shape);
+
+    /// @brief LineString, or Polygon when the shape closes on its first vertex
+    void AppendShapeGeometry(const Shape& shape);
+
+    void Flush();
+
+    Options                         mOptions;
+    Sink                            mSink;
+    std::unique_ptr<Zip::Writer>    mZip;       /// Null for plain KML
+    size_t                          mFlushBytes;
+    std::string                     mBuffer;
+    Format::TimestampWriter         mTimes;
+    uint64_t                        mCount;
+    bool                            mFinished;
+};
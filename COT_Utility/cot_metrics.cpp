@@ -0,0 +1,369 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_metrics.cpp
+// @brief           Implementation of the COT Utility metrics registry
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cmath>                        // ceil
+#include <cstdio>                       // snprintf
+#if defined(_MSC_VER)
+#include <intrin.h>                     // _BitScanReverse64
+#endif
+//
+#include "cot_metrics.h"                // Metrics header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Metrics
+{
+    std::atomic<bool> gEnabled(true);
+
+    namespace
+    {
+        const int kCounters = static_cast<int>(Counter::Count);
+        const int kReasons = static_cast<int>(Reason::Count);
+        const int kOps = static_cast<int>(Op::Count);
+
+        /// @brief Number of shards. Threads are spread round-robin; more threads
+        ///        than shards simply share, which the atomics make safe.
+        const unsigned kShards = 16;
+
+        /// @brief One writer shard, cache line aligned to avoid false sharing
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> counters[kCounters];
+            std::atomic<uint64_t> reasons[kReasons];
+            std::atomic<uint64_t> sum[kOps];
+            std::atomic<uint64_t> max[kOps];
+            std::atomic<uint64_t> buckets[kOps][Buckets::Count];
+        };
+
+        Shard gShards[kShards];
+        std::atomic<unsigned> gNextShard(0);
+
+        /// @brief Registered gauges. Slots are claimed with a CAS and read without locks.
+        std::atomic<Gauge*> gGauges[Gauge::MaxGauges];
+
+        Shard& ThreadShard()
+        {
+            thread_local unsigned index = gNextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+            return gShards[index];
+        }
+
+        inline unsigned HighestBit(uint64_t v)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse64(&index, v);
+            return static_cast<unsigned>(index);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#endif
+        }
+    };
+
+    const char* CounterName(Counter c)
+    {
+        switch (c)
+        {
+        case Counter::ParseCalls:       return "parse_calls";
+        case Counter::ParseAccepted:    return "parse_accepted";
+        case Counter::ParseRejected:    return "parse_rejected";
+        case Counter::ParseBytes:       return "parse_bytes";
+        case Counter::ParseFiltered:    return "parse_filtered";
+        case Counter::GenerateCalls:    return "generate_calls";
+        case Counter::GenerateBytes:    return "generate_bytes";
+        case Counter::UpdateCalls:      return "update_calls";
+        case Counter::UpdateModified:   return "update_modified";
+        case Counter::UpdateFailed:     return "update_failed";
+        case Counter::AckCalls:         return "ack_calls";
+        case Counter::AckModified:      return "ack_modified";
+        case Counter::AckFailed:        return "ack_failed";
+        case Counter::VerifyCalls:      return "verify_calls";
+        case Counter::VerifyFailed:     return "verify_failed";
+        default:                        return "unknown";
+        }
+    }
+
+    const char* ReasonName(Reason r)
+    {
+        switch (r)
+        {
+        case Reason::NoXmlDeclaration:  return "no_xml_declaration";
+        case Reason::MalformedXml:      return "malformed_xml";
+        case Reason::EventCount:        return "event_count";
+        case Reason::PointCount:        return "point_count";
+        case Reason::BadType:           return "bad_type";
+        case Reason::BadHow:            return "bad_how";
+        case Reason::BadTime:           return "bad_time";
+        case Reason::BadStart:          return "bad_start";
+        case Reason::BadStale:          return "bad_stale";
+        case Reason::NotWellFormed:     return "not_well_formed";
+        case Reason::NotStrict:         return "not_strict";
+        case Reason::NotSemantic:       return "not_semantic";
+        default:                        return "unknown";
+        }
+    }
+
+    const char* OpName(Op op)
+    {
+        switch (op)
+        {
+        case Op::Parse:         return "parse";
+        case Op::Generate:      return "generate";
+        case Op::Update:        return "update";
+        case Op::Acknowledge:   return "acknowledge";
+        case Op::Verify:        return "verify";
+        default:                return "unknown";
+        }
+    }
+
+    Gauge::Gauge(const char* name, const char* help) : mName(name), mHelp(help), mValue(0), mSlot(-1)
+    {
+        for (unsigned i = 0; i < MaxGauges; i++)
+        {
+            Gauge* expected = nullptr;
+            if (gGauges[i].compare_exchange_strong(expected, this, std::memory_order_release, std::memory_order_relaxed))
+            {
+                mSlot = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+
+    Gauge::~Gauge()
+    {
+        if (mSlot >= 0)
+        {
+            gGauges[mSlot].store(nullptr, std::memory_order_release);
+        }
+    }
+
+    unsigned Buckets::Index(uint64_t value)
+    {
+        if (value < SubCount)
+        {
+            return static_cast<unsigned>(value);
+        }
+
+        const unsigned e = HighestBit(value);
+        if (e >= MaxBits)
+        {
+            return Count - 1;
+        }
+
+        const unsigned sub = static_cast<unsigned>(value >> (e - SubBits)) & (SubCount - 1);
+        return SubCount + (e - SubBits) * SubCount + sub;
+    }
+
+    uint64_t Buckets::UpperBound(unsigned index)
+    {
+        if (index < SubCount)
+        {
+            return index;
+        }
+
+        const unsigned e = (index - SubCount) / SubCount + SubBits;
+        const uint64_t sub = (index - SubCount) % SubCount;
+        const uint64_t width = 1ULL << (e - SubBits);
+        return ((SubCount + sub) << (e - SubBits)) + width - 1;
+    }
+
+    uint64_t HistogramSnapshot::Percentile(double pct) const
+    {
+        if (count == 0 || buckets.empty())
+        {
+            return 0;
+        }
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(pct / 100.0 * static_cast<double>(count)));
+        if (rank == 0) { rank = 1; }
+
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < buckets.size(); i++)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                // Never report more than the largest value actually seen
+                uint64_t bound = Buckets::UpperBound(i);
+                return bound < max ? bound : max;
+            }
+        }
+        return max;
+    }
+
+    void SetEnabled(bool enabled)
+    {
+        gEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void Add(Counter c, uint64_t n)
+    {
+        ThreadShard().counters[static_cast<int>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void Fail(Reason r)
+    {
+        ThreadShard().reasons[static_cast<int>(r)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Record(Op op, uint64_t nanoseconds)
+    {
+        Shard& shard = ThreadShard();
+        const int o = static_cast<int>(op);
+
+        shard.buckets[o][Buckets::Index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum[o].fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        uint64_t seen = shard.max[o].load(std::memory_order_relaxed);
+        while (nanoseconds > seen &&
+            !shard.max[o].compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    Snapshot Take()
+    {
+        Snapshot snap;
+        for (int o = 0; o < kOps; o++)
+        {
+            snap.latency[o].buckets.assign(Buckets::Count, 0);
+        }
+
+        for (const Shard& shard : gShards)
+        {
+            for (int c = 0; c < kCounters; c++)
+            {
+                snap.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+            }
+
+            for (int r = 0; r < kReasons; r++)
+            {
+                snap.reasons[r] += shard.reasons[r].load(std::memory_order_relaxed);
+            }
+
+            for (int o = 0; o < kOps; o++)
+            {
+                HistogramSnapshot& h = snap.latency[o];
+                for (unsigned b = 0; b < Buckets::Count; b++)
+                {
+                    const uint64_t n = shard.buckets[o][b].load(std::memory_order_relaxed);
+                    h.buckets[b] += n;
+                    h.count += n;
+                }
+                h.sum += shard.sum[o].load(std::memory_order_relaxed);
+                const uint64_t m = shard.max[o].load(std::memory_order_relaxed);
+                if (m > h.max) { h.max = m; }
+            }
+        }
+
+        for (const auto& slot : gGauges)
+        {
+            const Gauge* g = slot.load(std::memory_order_acquire);
+            if (g != nullptr)
+            {
+                GaugeSnapshot gs;
+                gs.name = g->Name();
+                gs.help = g->Help();
+                gs.value = g->Value();
+                snap.gauges.push_back(gs);
+            }
+        }
+
+        return snap;
+    }
+
+    void Reset()
+    {
+        for (Shard& shard : gShards)
+        {
+            for (auto& c : shard.counters) { c.store(0, std::memory_order_relaxed); }
+            for (auto& r : shard.reasons) { r.store(0, std::memory_order_relaxed); }
+            for (int o = 0; o < kOps; o++)
+            {
+                shard.sum[o].store(0, std::memory_order_relaxed);
+                shard.max[o].store(0, std::memory_order_relaxed);
+                for (auto& b : shard.buckets[o]) { b.store(0, std::memory_order_relaxed); }
+            }
+        }
+    }
+
+    std::string RenderOpenMetrics(const Snapshot& snap)
+    {
+        // Exported histogram bounds in nanoseconds, 1 us to 1 s
+        static const uint64_t kBounds[] = { 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+            1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000, 250000000, 500000000, 1000000000 };
+
+        std::string out;
+        out.reserve(8192);
+        char line[256];
+
+        for (int c = 0; c < kCounters; c++)
+        {
+            const char* name = CounterName(static_cast<Counter>(c));
+            std::snprintf(line, sizeof(line), "# TYPE cot_%s counter\ncot_%s_total %llu\n",
+                name, name, static_cast<unsigned long long>(snap.counters[c]));
+            out += line;
+        }
+
+        out += "# TYPE cot_parse_failures counter\n";
+        out += "# HELP cot_parse_failures Messages rejected or fields that could not be decoded, by reason.\n";
+        for (int r = 0; r < kReasons; r++)
+        {
+            std::snprintf(line, sizeof(line), "cot_parse_failures_total{reason=\"%s\"} %llu\n",
+                ReasonName(static_cast<Reason>(r)), static_cast<unsigned long long>(snap.reasons[r]));
+            out += line;
+        }
+
+        out += "# TYPE cot_operation_latency_seconds histogram\n";
+        out += "# UNIT cot_operation_latency_seconds seconds\n";
+        out += "# HELP cot_operation_latency_seconds Latency of COT Utility operations.\n";
+        for (int o = 0; o < kOps; o++)
+        {
+            const HistogramSnapshot& h = snap.latency[o];
+            const char* op = OpName(static_cast<Op>(o));
+
+            // A bucket is counted under the first exported bound at or above its upper bound
+            uint64_t cumulative = 0;
+            unsigned b = 0;
+            for (uint64_t bound : kBounds)
+            {
+                while (b < h.buckets.size() && b < Buckets::Count - 1 && Buckets::UpperBound(b) <= bound)
+                {
+                    cumulative += h.buckets[b++];
+                }
+                std::snprintf(line, sizeof(line), "cot_operation_latency_seconds_bucket{op=\"%s\",le=\"%g\"} %llu\n",
+                    op, static_cast<double>(bound) * 1e-9, static_cast<unsigned long long>(cumulative));
+                out += line;
+            }
+            std::snprintf(line, sizeof(line),
+                "cot_operation_latency_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu\n"
+                "cot_operation_latency_seconds_count{op=\"%s\"} %llu\n"
+                "cot_operation_latency_seconds_sum{op=\"%s\"} %.9f\n",
+                op, static_cast<unsigned long long>(h.count),
+                op, static_cast<unsigned long long>(h.count),
+                op, static_cast<double>(h.sum) * 1e-9);
+            out += line;
+        }
+
+        for (const GaugeSnapshot& g : snap.gauges)
+        {
+            out += "# TYPE cot_" + g.name + " gauge\n";
+            if (!g.help.empty())
+            {
+                out += "# HELP cot_" + g.name + " " + g.help + "\n";
+            }
+            out += "cot_" + g.name + " " + std::to_string(g.value) + "\n";
+        }
+
+        out += "# EOF\n";
+        return out;
+    }
+};
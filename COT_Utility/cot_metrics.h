@@ -0,0 +1,246 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_metrics.h
+// @brief           Optional, low overhead counters and latency histograms for the
+//                  COT Utility operations.
+//
+//                  The instrumentation macros at the bottom of this file compile
+//                  to nothing unless COT_ENABLE_METRICS is defined. When compiled
+//                  in, recording can still be switched off at runtime with
+//                  Metrics::SetEnabled(false), which leaves one relaxed load per
+//                  call site.
+//
+//                  Writers update per-thread shards with relaxed atomics; readers
+//                  pull a Snapshot that sums the shards without taking a lock.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <atomic>                           // atomic
+#include <chrono>                           // steady_clock
+#include <cstdint>                          // uint64_t
+#include <string>                           // string
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Metrics
+{
+    /// @brief Monotonic event counters
+    enum class Counter : int
+    {
+        ParseCalls,             /// ParseCOT calls
+        ParseAccepted,          /// ParseCOT calls that returned a good parse
+        ParseRejected,          /// ParseCOT calls that returned an error
+        ParseBytes,             /// Bytes handed to ParseCOT
+        ParseFiltered,          /// ParseCOT calls dropped by a header filter before parsing
+        GenerateCalls,          /// GenerateXMLCOTMessage calls
+        GenerateBytes,          /// Bytes produced by GenerateXMLCOTMessage
+        UpdateCalls,            /// UpdateReceivedCOTMessage calls
+        UpdateModified,         /// UpdateReceivedCOTMessage calls that modified the message
+        UpdateFailed,           /// UpdateReceivedCOTMessage calls that could not parse the message
+        AckCalls,               /// AcknowledgeReceivedCOTMessage calls
+        AckModified,            /// AcknowledgeReceivedCOTMessage calls that added the acknowledgment
+        AckFailed,              /// AcknowledgeReceivedCOTMessage calls that could not parse the message
+        VerifyCalls,            /// VerifyXML calls
+        VerifyFailed,           /// VerifyXML calls that rejected the buffer
+        Count
+    };
+
+    /// @brief Reasons a message was rejected, or a field could not be decoded
+    enum class Reason : int
+    {
+        NoXmlDeclaration,       /// No "<?xml" found in the buffer
+        MalformedXml,           /// The XML parser rejected the buffer
+        EventCount,             /// Not exactly one <event>
+        PointCount,             /// Not exactly one <point>
+        BadType,                /// 'type' attribute could not be decoded
+        BadHow,                 /// 'how' attribute could not be decoded
+        BadTime,                /// 'time' attribute could not be decoded
+        BadStart,               /// 'start' attribute could not be decoded
+        BadStale,               /// 'stale' attribute could not be decoded
+        NotWellFormed,          /// Validate::WellFormed rejected the buffer
+        NotStrict,              /// Validate::Strict rejected the document
+        NotSemantic,            /// Validate::Semantic rejected the values
+        Count
+    };
+
+    /// @brief Operations with a latency histogram
+    enum class Op : int
+    {
+        Parse,
+        Generate,
+        Update,
+        Acknowledge,
+        Verify,
+        Count
+    };
+
+    /// @brief Names used when exporting, indexed by the enums above
+    const char* CounterName(Counter c);
+    const char* ReasonName(Reason r);
+    const char* OpName(Op op);
+
+    /// @brief Log-linear bucket layout shared by all histograms (HDR style).
+    ///        Values below 2^SubBits ns get their own bucket; above that every
+    ///        power of two is split into 2^SubBits buckets, giving a relative
+    ///        error under 1 / 2^SubBits (6.25%). Values above 2^MaxBits ns
+    ///        (about 68 s) land in the last bucket.
+    struct Buckets
+    {
+        static const unsigned SubBits = 4;
+        static const unsigned SubCount = 1u << SubBits;
+        static const unsigned MaxBits = 36;
+        static const unsigned Count = SubCount + (MaxBits - SubBits) * SubCount;
+
+        /// @brief Bucket index for a value in nanoseconds
+        static unsigned Index(uint64_t value);
+
+        /// @brief Largest value that falls into a bucket
+        static uint64_t UpperBound(unsigned index);
+    };
+
+    /// @brief Point-in-time copy of a histogram
+    struct HistogramSnapshot
+    {
+        uint64_t                count = 0;      /// Number of recorded values
+        uint64_t                sum = 0;        /// Sum of recorded values (ns)
+        uint64_t                max = 0;        /// Largest recorded value (ns)
+        std::vector<uint64_t>   buckets;        /// Per-bucket counts, see Buckets
+
+        /// @brief Value at a percentile in [0, 100], reported as the bucket upper bound
+        uint64_t Percentile(double pct) const;
+
+        /// @brief Mean in ns, 0 if empty
+        double Mean() const { return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0; }
+    };
+
+    /// @brief Point-in-time copy of an application gauge
+    struct GaugeSnapshot
+    {
+        std::string name;
+        std::string help;
+        int64_t     value = 0;
+    };
+
+    /// @brief Point-in-time copy of the whole registry
+    struct Snapshot
+    {
+        uint64_t                    counters[static_cast<int>(Counter::Count)] = {};
+        uint64_t                    reasons[static_cast<int>(Reason::Count)] = {};
+        HistogramSnapshot           latency[static_cast<int>(Op::Count)];
+        std::vector<GaugeSnapshot>  gauges;
+
+        uint64_t Get(Counter c) const { return counters[static_cast<int>(c)]; }
+        uint64_t Get(Reason r) const { return reasons[static_cast<int>(r)]; }
+        const HistogramSnapshot& Latency(Op op) const { return latency[static_cast<int>(op)]; }
+    };
+
+    /// @brief An application owned gauge, e.g. track store size or queue depth.
+    ///        Constructing one registers it for export; destroying it removes it.
+    ///        Updates are single relaxed atomic operations. At most MaxGauges
+    ///        may exist at once; extras still work but are not exported.
+    ///        A gauge must not be destroyed while another thread may call Take(),
+    ///        so give it static or application lifetime.
+    class Gauge
+    {
+    public:
+        static const unsigned MaxGauges = 64;
+
+        /// @brief Constructor
+        /// @param name - [in] - metric name, [a-zA-Z_][a-zA-Z0-9_]*, must outlive the gauge
+        /// @param help - [in] - one line description, must outlive the gauge
+        Gauge(const char* name, const char* help);
+
+        /// @brief Deconstructor - unregisters the gauge
+        ~Gauge();
+
+        void Set(int64_t value) { mValue.store(value, std::memory_order_relaxed); }
+        void Add(int64_t delta) { mValue.fetch_add(delta, std::memory_order_relaxed); }
+        int64_t Value() const { return mValue.load(std::memory_order_relaxed); }
+        const char* Name() const { return mName; }
+        const char* Help() const { return mHelp; }
+
+        Gauge(const Gauge&) = delete;
+        Gauge& operator=(const Gauge&) = delete;
+
+    private:
+        const char*             mName;
+        const char*             mHelp;
+        std::atomic<int64_t>    mValue;
+        int                     mSlot;
+    };
+
+    /// @brief Runtime switch, on by default
+    extern std::atomic<bool> gEnabled;
+
+    inline bool Enabled() { return gEnabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enabled);
+
+    /// @brief Add to a counter
+    void Add(Counter c, uint64_t n = 1);
+
+    /// @brief Count a rejection / decode failure reason
+    void Fail(Reason r);
+
+    /// @brief Record an operation latency in nanoseconds
+    void Record(Op op, uint64_t nanoseconds);
+
+    /// @brief Sum all shards into a snapshot. Lock free; safe while writers run.
+    Snapshot Take();
+
+    /// @brief Zero every counter and histogram. Not atomic with respect to writers.
+    void Reset();
+
+    /// @brief Render a snapshot in the OpenMetrics text format (also accepted by
+    ///        Prometheus). Every name is prefixed with "cot_". Latency histograms
+    ///        are folded onto a fixed set of exported 'le' bounds.
+    std::string RenderOpenMetrics(const Snapshot& snap);
+
+    /// @brief Records the lifetime of the scope into an operation histogram
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Op op) : mOp(op), mActive(Enabled())
+        {
+            if (mActive) { mStart = std::chrono::steady_clock::now(); }
+        }
+
+        ~ScopedTimer()
+        {
+            if (mActive)
+            {
+                Record(mOp, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - mStart).count()));
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Op                                      mOp;
+        bool                                    mActive;
+        std::chrono::steady_clock::time_point   mStart;
+    };
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+// Instrumentation macros used inside the library
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COT_ENABLE_METRICS
+#define COT_METRIC_ADD(counter, n)  do { if (Metrics::Enabled()) { Metrics::Add(Metrics::Counter::counter, (n)); } } while (0)
+#define COT_METRIC_INC(counter)     COT_METRIC_ADD(counter, 1)
+#define COT_METRIC_FAIL(reason)     do { if (Metrics::Enabled()) { Metrics::Fail(Metrics::Reason::reason); } } while (0)
+#define COT_METRIC_TIMER(op)        Metrics::ScopedTimer cotMetricTimer_##op(Metrics::Op::op)
+#else
+#define COT_METRIC_ADD(counter, n)  do { } while (0)
+#define COT_METRIC_INC(counter)     do { } while (0)
+#define COT_METRIC_FAIL(reason)     do { } while (0)
+#define COT_METRIC_TIMER(op)        do { } while (0)
+#endif
@@ -0,0 +1,181 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_metrics_http.cpp
+// @brief           Implementation of the OpenMetrics HTTP endpoint
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cerrno>                       // errno
+#include <cstring>                      // strerror
+#include <arpa/inet.h>                  // inet_pton, htons
+#include <netinet/in.h>                 // sockaddr_in
+#include <poll.h>                       // poll
+#include <sys/socket.h>                 // socket, bind, listen, accept
+#include <sys/time.h>                   // timeval
+#include <unistd.h>                     // close
+//
+#include "cot_metrics_http.h"           // Server header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace Metrics
+{
+    HttpServer::HttpServer() : mListen(-1), mPort(0), mRunning(false), mScrapes(0) {}
+
+    HttpServer::~HttpServer()
+    {
+        Stop();
+    }
+
+    bool HttpServer::Start(uint16_t port, const std::string& address)
+    {
+        if (mRunning.load())
+        {
+            mError = "already running";
+            return false;
+        }
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+        {
+            mError = "bad bind address '" + address + "'";
+            return false;
+        }
+
+        mListen = socket(AF_INET, SOCK_STREAM, 0);
+        if (mListen < 0)
+        {
+            mError = std::string("socket: ") + std::strerror(errno);
+            return false;
+        }
+
+        int yes = 1;
+        setsockopt(mListen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        if (bind(mListen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(mListen, 16) < 0)
+        {
+            mError = std::string("bind/listen: ") + std::strerror(errno);
+            close(mListen);
+            mListen = -1;
+            return false;
+        }
+
+        socklen_t len = sizeof(addr);
+        getsockname(mListen, reinterpret_cast<sockaddr*>(&addr), &len);
+        mPort = ntohs(addr.sin_port);
+
+        mRunning.store(true);
+        mThread = std::thread(&HttpServer::Serve, this);
+        return true;
+    }
+
+    void HttpServer::Stop()
+    {
+        if (!mRunning.exchange(false))
+        {
+            return;
+        }
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+
+        close(mListen);
+        mListen = -1;
+        mPort = 0;
+    }
+
+    void HttpServer::Serve()
+    {
+        while (mRunning.load(std::memory_order_relaxed))
+        {
+            // Wake periodically so Stop() does not depend on a connection arriving
+            pollfd pfd = { mListen, POLLIN, 0 };
+            if (poll(&pfd, 1, 200) <= 0 || !(pfd.revents & POLLIN))
+            {
+                continue;
+            }
+
+            int client = accept(mListen, nullptr, nullptr);
+            if (client < 0)
+            {
+                continue;
+            }
+
+            Handle(client);
+            close(client);
+        }
+    }
+
+    void HttpServer::Handle(int client)
+    {
+        // A slow or idle client must not hold the endpoint
+        timeval timeout = { 1, 0 };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+        {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+            {
+                break;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+
+        std::string status;
+        std::string type;
+        std::string body;
+
+        const size_t lineEnd = request.find("\r\n");
+        const std::string line = request.substr(0, lineEnd);
+        if (line.compare(0, 4, "GET ") != 0)
+        {
+            status = "405 Method Not Allowed";
+            type = "text/plain";
+            body = "Only GET is supported\n";
+        }
+        else if (line.compare(4, 9, "/metrics ") != 0 && line.compare(4, 9, "/metrics?") != 0)
+        {
+            status = "404 Not Found";
+            type = "text/plain";
+            body = "Try /metrics\n";
+        }
+        else
+        {
+            status = "200 OK";
+            type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+            body = RenderOpenMetrics(Take());
+            mScrapes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + type +
+            "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+        size_t sent = 0;
+        while (sent < response.size())
+        {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+            {
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_metrics_http.h
+// @brief           A tiny embedded HTTP endpoint serving the metrics registry in
+//                  the OpenMetrics text format for Prometheus scrapes.
+//                  POSIX sockets only.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <atomic>                           // atomic
+#include <cstdint>                          // uint16_t
+#include <string>                           // string
+#include <thread>                           // thread
+//
+#include "cot_metrics.h"                    // Metrics registry
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Metrics
+{
+    /// @brief Serves GET /metrics from a background thread. Every scrape renders a
+    ///        fresh lock-free Snapshot, so ingest threads are never blocked. One
+    ///        connection is handled at a time and closed after the response.
+    class HttpServer
+    {
+    public:
+
+        /// @brief Default Construtor
+        HttpServer();
+
+        /// @brief Default Deconstructor - stops the server
+        ~HttpServer();
+
+        /// @brief Bind, listen and start the serving thread
+        /// @param port    - [in] - TCP port, 0 picks an ephemeral port (see Port())
+        /// @param address - [in] - IPv4 address to bind, loopback by default
+        /// @return true if listening, false on error (see LastError())
+        bool Start(uint16_t port, const std::string& address = "127.0.0.1");
+
+        /// @brief Stop the serving thread and close the socket
+        void Stop();
+
+        /// @brief Port actually bound, 0 if not running
+        uint16_t Port() const { return mPort; }
+
+        /// @brief Description of the last Start() failure
+        const std::string& LastError() const { return mError; }
+
+        /// @brief Number of scrapes served
+        uint64_t Scrapes() const { return mScrapes.load(std::memory_order_relaxed); }
+
+        HttpServer(const HttpServer&) = delete;
+        HttpServer& operator=(const HttpServer&) = delete;
+
+    private:
+        void Serve();
+        void Handle(int client);
+
+        int                     mListen;
+        uint16_t                mPort;
+        std::string             mError;
+        std::atomic<bool>       mRunning;
+        std::atomic<uint64_t>   mScrapes;
+        std::thread             mThread;
+    };
+};
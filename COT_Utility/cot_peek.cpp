@@ -0,0 +1,206 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_peek.cpp
+// @brief           Implementation of the CoT header peek
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // min
+#include <cmath>                        // NAN
+//
+#include "cot_format.h"                 // ReadReal
+#include "cot_peek.h"                   // Peek header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Peek
+{
+    namespace
+    {
+        bool IsSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        /// @brief Position just past "<name" when followed by a space, '>' or '/'
+        size_t FindTag(std::string_view text, std::string_view name, size_t from)
+        {
+            while ((from = text.find(name, from)) != std::string_view::npos)
+            {
+                const size_t end = from + name.size();
+                if (end < text.size() && (IsSpace(text[end]) || text[end] == '>' || text[end] == '/'))
+                {
+                    return end;
+                }
+                from = end;
+            }
+            return std::string_view::npos;
+        }
+
+        /// @brief Walk the attributes of the tag starting at 'pos', calling
+        ///        fn(name, value) for each complete one
+        /// @return position after the tag, or npos if the window ended inside it
+        template <class F>
+        size_t ForEachAttribute(std::string_view text, size_t pos, F&& fn)
+        {
+            while (pos < text.size())
+            {
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size())
+                {
+                    break;
+                }
+                if (text[pos] == '>' || text[pos] == '/')
+                {
+                    return pos + 1;
+                }
+
+                const size_t nameStart = pos;
+                while (pos < text.size() && text[pos] != '=' && text[pos] != '>' && !IsSpace(text[pos])) { pos++; }
+                const std::string_view name = text.substr(nameStart, pos - nameStart);
+
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size() || text[pos] != '=')
+                {
+                    continue;
+                }
+                pos++;
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size() || (text[pos] != '"' && text[pos] != '\''))
+                {
+                    continue;
+                }
+
+                const char quote = text[pos++];
+                const size_t close = text.find(quote, pos);
+                if (close == std::string_view::npos)
+                {
+                    break;
+                }
+                fn(name, text.substr(pos, close - pos));
+                pos = close + 1;
+            }
+            return std::string_view::npos;
+        }
+
+        bool ReadReal(std::string_view text, double& value)
+        {
+            double v = 0;
+            if (Format::ReadReal(text.data(), text.data() + text.size(), v) == text.data())
+            {
+                return false;
+            }
+            value = v;
+            return true;
+        }
+
+        bool ReadDigits(std::string_view text, size_t pos, size_t count, unsigned& value)
+        {
+            if (pos + count > text.size())
+            {
+                return false;
+            }
+            value = 0;
+            for (size_t i = pos; i < pos + count; i++)
+            {
+                if (text[i] < '0' || text[i] > '9')
+                {
+                    return false;
+                }
+                value = value * 10 + static_cast<unsigned>(text[i] - '0');
+            }
+            return true;
+        }
+    };
+
+    Header::Header()
+        : latitude(NAN), longitude(NAN), event(false), point(false), truncated(false)
+    {
+    }
+
+    bool PeekHeader(const char* data, size_t size, Header& out, size_t window)
+    {
+        out = Header();
+        if (data == nullptr)
+        {
+            return false;
+        }
+
+        const std::string_view text(data, std::min(size, window));
+        size_t pos = FindTag(text, "<event", 0);
+        if (pos == std::string_view::npos)
+        {
+            return false;
+        }
+        out.event = true;
+
+        // Not finding something is only an answer when the window held the whole buffer
+        const bool cut = size > window;
+        pos = ForEachAttribute(text, pos, [&out](std::string_view name, std::string_view value)
+        {
+                 if (name == "uid")     out.uid = value;
+            else if (name == "type")    out.type = value;
+            else if (name == "time")    out.time = value;
+            else if (name == "stale")   out.stale = value;
+        });
+        if (pos == std::string_view::npos || (pos = FindTag(text, "<point", pos)) == std::string_view::npos)
+        {
+            out.truncated = cut;
+            return true;
+        }
+
+        bool lat = false, lon = false;
+        pos = ForEachAttribute(text, pos, [&](std::string_view name, std::string_view value)
+        {
+                 if (name == "lat")     lat = ReadReal(value, out.latitude);
+            else if (name == "lon")     lon = ReadReal(value, out.longitude);
+        });
+        out.point = lat && lon;
+        out.truncated = cut && pos == std::string_view::npos;
+        return true;
+    }
+
+    bool PeekHeader(const std::string& buffer, Header& out, size_t window)
+    {
+        return PeekHeader(buffer.data(), buffer.size(), out, window);
+    }
+
+    bool ParseTimestamp(std::string_view text, DateTime& out)
+    {
+        unsigned year, month, day, hour, minute, second;
+        if (!ReadDigits(text, 0, 4, year) || text.size() < 20 || text[4] != '-' ||
+            !ReadDigits(text, 5, 2, month) || text[7] != '-' ||
+            !ReadDigits(text, 8, 2, day) || text[10] != 'T' ||
+            !ReadDigits(text, 11, 2, hour) || text[13] != ':' ||
+            !ReadDigits(text, 14, 2, minute) || text[16] != ':' ||
+            !ReadDigits(text, 17, 2, second))
+        {
+            return false;
+        }
+
+        // Optional fraction, then 'Z'
+        size_t pos = 19;
+        double fraction = 0;
+        if (text[pos] == '.')
+        {
+            double scale = 0.1;
+            for (pos++; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; pos++)
+            {
+                fraction += scale * (text[pos] - '0');
+                scale *= 0.1;
+            }
+        }
+        if (pos >= text.size() || text[pos] != 'Z')
+        {
+            return false;
+        }
+
+        out = DateTime(year, month, day, hour, minute, second + fraction);
+        return true;
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_peek.h
+// @brief           Header peek: pulls uid, type, time, stale and the point
+//                  lat/lon out of the first few hundred bytes of a message
+//                  without an XML parse, so a receiver can drop messages it
+//                  does not want before paying for ParseCOT.
+//
+//                  The scan is bounded and forgiving. It does not check that
+//                  the message is well formed and does not decode entities;
+//                  anything it accepts still goes through the full parse.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <functional>                       // function
+#include <string>                           // string
+#include <string_view>                      // string_view
+//
+#include "cot_info.h"                       // DateTime
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Peek
+{
+    /// @brief Bytes scanned by default. Holds the declaration, a typical <event>
+    ///        tag and the <point> after it.
+    static const size_t DefaultWindow = 512;
+
+    /// @brief Raw attribute text found by PeekHeader(). Views point into the
+    ///        scanned buffer and are empty when the attribute was not found.
+    struct Header
+    {
+        std::string_view    uid;
+        std::string_view    type;
+        std::string_view    time;
+        std::string_view    stale;
+        double              latitude;       /// NaN when not found
+        double              longitude;      /// NaN when not found
+        bool                event;          /// An <event> start tag was found
+        bool                point;          /// A <point> tag with lat and lon was found after it
+        bool                truncated;      /// The window ended before the <event> and <point>
+                                            /// tags were read, so a value may be missing
+
+        /// @brief Constructor - Initializes Everything
+        Header();
+
+        /// @brief 'type' starts with prefix, e.g. "a-f-"
+        bool TypeStartsWith(std::string_view prefix) const
+        {
+            return type.substr(0, prefix.size()) == prefix;
+        }
+
+        /// @brief lat/lon found and inside the box (inclusive). False also when
+        ///        the point was not seen; 'truncated' tells that from outside.
+        bool Within(double south, double west, double north, double east) const
+        {
+            return point && latitude >= south && latitude <= north && longitude >= west && longitude <= east;
+        }
+    };
+
+    /// @brief Decides from a header whether a message is worth a full parse
+    using Filter = std::function<bool(const Header&)>;
+
+    /// @brief Scan at most 'window' bytes for the <event> and <point> attributes.
+    ///        Anything before "<event" (transport garbage, the declaration) is
+    ///        skipped. An attribute whose closing quote lies past the window is
+    ///        not read, nor any after it, and 'truncated' is set.
+    /// @return true if an <event> start tag was found
+    bool PeekHeader(const char* data, size_t size, Header& out, size_t window = DefaultWindow);
+
+    /// @brief Overloaded - Peek a string
+    bool PeekHeader(const std::string& buffer, Header& out, size_t window = DefaultWindow);
+
+    /// @brief Parse "YYYY-MM-DDTHH:MM:SS[.f]Z" as the peeked time and stale hold it
+    /// @return true if the text has that layout
+    bool ParseTimestamp(std::string_view text, DateTime& out);
+};
@@ -0,0 +1,312 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_shape.cpp
+// @brief           Implementation of the shape vertex extractor and simplifier
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cmath>                        // NAN, cos
+//
+#include "cot_format.h"                 // ReadReal
+#include "cot_shape.h"                  // Vertices header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Vertices
+{
+    namespace
+    {
+        bool IsSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        /// @brief Read a real at pos and the spaces after it
+        bool ReadReal(std::string_view text, size_t& pos, double& value)
+        {
+            const char* start = text.data() + pos;
+            const char* stop = Format::ReadReal(start, text.data() + text.size(), value);
+            if (stop == start)
+            {
+                return false;
+            }
+            pos = stop - text.data();
+            while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+            return true;
+        }
+
+        /// @brief Value of the first attribute 'wanted' of the tag whose attributes
+        ///        start at pos, a null view when there is none; pos is left at the
+        ///        end of the tag
+        std::string_view FindAttribute(std::string_view text, size_t& pos, std::string_view wanted)
+        {
+            std::string_view found;
+            while (pos < text.size())
+            {
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size() || text[pos] == '>' || text[pos] == '/')
+                {
+                    break;
+                }
+
+                const size_t nameStart = pos;
+                while (pos < text.size() && text[pos] != '=' && text[pos] != '>' && !IsSpace(text[pos])) { pos++; }
+                const std::string_view name = text.substr(nameStart, pos - nameStart);
+
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size() || text[pos] != '=')
+                {
+                    continue;
+                }
+                pos++;
+                while (pos < text.size() && IsSpace(text[pos])) { pos++; }
+                if (pos >= text.size() || (text[pos] != '"' && text[pos] != '\''))
+                {
+                    continue;
+                }
+
+                const char quote = text[pos++];
+                const size_t close = text.find(quote, pos);
+                if (close == std::string_view::npos)
+                {
+                    pos = text.size();
+                    break;
+                }
+                if (name == wanted && found.data() == nullptr)
+                {
+                    found = text.substr(pos, close - pos);
+                }
+                pos = close + 1;
+            }
+            return found;
+        }
+
+        /// @brief Squared distance from p to the segment a-b
+        double SegmentDistance2(double px, double py, double ax, double ay, double bx, double by)
+        {
+            const double dx = bx - ax, dy = by - ay;
+            const double length2 = dx * dx + dy * dy;
+            double t = 0;
+            if (length2 > 0)
+            {
+                t = ((px - ax) * dx + (py - ay) * dy) / length2;
+                t = t < 0 ? 0 : (t > 1 ? 1 : t);
+            }
+            const double ex = ax + t * dx - px, ey = ay + t * dy - py;
+            return ex * ex + ey * ey;
+        }
+    };
+
+    bool ParsePoint(std::string_view text, double& lat, double& lon, double& hae)
+    {
+        size_t pos = 0;
+        if (!ReadReal(text, pos, lat) || pos >= text.size() || text[pos++] != ',' || !ReadReal(text, pos, lon))
+        {
+            return false;
+        }
+        if (pos >= text.size() || text[pos++] != ',' || !ReadReal(text, pos, hae))
+        {
+            hae = NAN;
+        }
+        return true;
+    }
+
+    size_t Extract(const char* data, size_t size, Shape& out)
+    {
+        out.Clear();
+        if (data == nullptr)
+        {
+            return 0;
+        }
+
+        const std::string_view text(data, size);
+        std::string_view strokeColor, strokeWeight, fillColor;
+        bool hasStrokeColor = false, hasStrokeWeight = false, hasFillColor = false;
+
+        // Only direct children of <detail> count, as in the DOM
+        const size_t none = std::string_view::npos;
+        size_t depth = 0, detailDepth = none;
+        size_t pos = 0;
+        while ((pos = text.find('<', pos)) != none && ++pos < text.size())
+        {
+            const char c = text[pos];
+            if (c == '/')
+            {
+                depth -= depth > 0;
+                detailDepth = depth < detailDepth ? none : detailDepth;
+                continue;
+            }
+            if (c == '?' || c == '!')
+            {
+                const std::string_view close = text.compare(pos, 3, "!--") == 0 ? "-->" :
+                    (text.compare(pos, 8, "![CDATA[") == 0 ? "]]>" : (c == '?' ? "?>" : ">"));
+                pos = text.find(close, pos);
+                if (pos == none)
+                {
+                    break;
+                }
+                continue;
+            }
+
+            const size_t nameStart = pos;
+            while (pos < text.size() && !IsSpace(text[pos]) && text[pos] != '>' && text[pos] != '/') { pos++; }
+            const std::string_view name = text.substr(nameStart, pos - nameStart);
+
+            if (depth != detailDepth)
+            {
+                FindAttribute(text, pos, {});
+            }
+            else if (name == "link")
+            {
+                double lat, lon, hae;
+                const std::string_view point = FindAttribute(text, pos, "point");
+                if (!point.empty() && ParsePoint(point, lat, lon, hae))
+                {
+                    out.Add(lat, lon, hae);
+                }
+            }
+            else if (!hasStrokeColor && name == "strokeColor")
+            {
+                strokeColor = FindAttribute(text, pos, "value");
+                hasStrokeColor = true;
+            }
+            else if (!hasStrokeWeight && name == "strokeWeight")
+            {
+                strokeWeight = FindAttribute(text, pos, "value");
+                hasStrokeWeight = true;
+            }
+            else if (!hasFillColor && name == "fillColor")
+            {
+                fillColor = FindAttribute(text, pos, "value");
+                hasFillColor = true;
+            }
+            else
+            {
+                FindAttribute(text, pos, {});
+            }
+
+            if (pos < text.size() && text[pos] == '/')
+            {
+                continue;
+            }
+            depth++;
+            if (name == "detail")
+            {
+                // A later <detail> replaces an earlier one, as ParseCOT reads them
+                detailDepth = depth;
+                out.Clear();
+                hasStrokeColor = hasStrokeWeight = hasFillColor = false;
+            }
+        }
+
+        // The style belongs to the vertices, as ParseCOT reads it
+        if (out.Size() > 0)
+        {
+            out.strokeColor.assign(strokeColor.begin(), strokeColor.end());
+            out.fillColor.assign(fillColor.begin(), fillColor.end());
+            // NaN without a value attribute, 0 for one that is not a number
+            size_t at = 0;
+            if (hasStrokeWeight && strokeWeight.data() != nullptr && !ReadReal(strokeWeight, at, out.strokeWeight))
+            {
+                out.strokeWeight = 0;
+            }
+        }
+        return out.Size();
+    }
+
+    size_t Extract(const std::string& buffer, Shape& out)
+    {
+        return Extract(buffer.data(), buffer.size(), out);
+    }
+
+    size_t Simplifier::Run(const Shape& in, double toleranceMeters, std::vector<uint8_t>& keep)
+    {
+        const size_t n = in.Size();
+        if (n <= 2)
+        {
+            keep.assign(n, 1);
+            return n;
+        }
+
+        // Local flat projection in metres around the first vertex
+        const double lat0 = in.latitude[0], lon0 = in.longitude[0];
+        const double ky = 110574.0;
+        const double kx = 111320.0 * std::cos(lat0 * 3.14159265358979323846 / 180.0);
+        mX.resize(n);
+        mY.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            double dlon = in.longitude[i] - lon0;
+            if (dlon > 180) { dlon -= 360; }
+            else if (dlon < -180) { dlon += 360; }
+            mX[i] = dlon * kx;
+            mY[i] = (in.latitude[i] - lat0) * ky;
+        }
+
+        keep.assign(n, 0);
+        keep[0] = keep[n - 1] = 1;
+        size_t kept = 2;
+        const double tolerance2 = toleranceMeters * toleranceMeters;
+
+        mStack.clear();
+        mStack.emplace_back(0u, static_cast<uint32_t>(n - 1));
+        while (!mStack.empty())
+        {
+            const uint32_t a = mStack.back().first, b = mStack.back().second;
+            mStack.pop_back();
+            if (b <= a + 1)
+            {
+                continue;
+            }
+
+            uint32_t farthest = a;
+            double worst = -1;
+            for (uint32_t i = a + 1; i < b; i++)
+            {
+                const double d = SegmentDistance2(mX[i], mY[i], mX[a], mY[a], mX[b], mY[b]);
+                if (d > worst)
+                {
+                    worst = d;
+                    farthest = i;
+                }
+            }
+            if (worst > tolerance2)
+            {
+                keep[farthest] = 1;
+                kept++;
+                mStack.emplace_back(a, farthest);
+                mStack.emplace_back(farthest, b);
+            }
+        }
+        return kept;
+    }
+
+    size_t Simplifier::Run(const Shape& in, double toleranceMeters, Shape& out)
+    {
+        Run(in, toleranceMeters, mKeep);
+
+        out.Clear();
+        for (size_t i = 0; i < mKeep.size(); i++)
+        {
+            if (mKeep[i])
+            {
+                out.Add(in.latitude[i], in.longitude[i], i < in.hae.size() ? in.hae[i] : NAN);
+            }
+        }
+        out.strokeColor = in.strokeColor;
+        out.strokeWeight = in.strokeWeight;
+        out.fillColor = in.fillColor;
+        return out.Size();
+    }
+
+    size_t Simplify(const Shape& in, double toleranceMeters, Shape& out)
+    {
+        Simplifier simplifier;
+        return simplifier.Run(in, toleranceMeters, out);
+    }
+};
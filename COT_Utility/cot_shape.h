@@ -0,0 +1,77 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_shape.h
+// @brief           Vertex handling for drawn shapes and routes.
+//
+//                  Extract() pulls every <link point="lat,lon[,hae]"/> out of
+//                  a raw message straight into a Shape's vertex arrays, with no
+//                  DOM, attribute strings or strtod; ParseCOT reads points with
+//                  the same number parser. Simplifier thins a polyline for
+//                  display (Douglas-Peucker).
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint8_t, uint32_t
+#include <string>                           // string
+#include <string_view>                      // string_view
+#include <utility>                          // pair
+#include <vector>                           // vector
+//
+#include "cot_info.h"                       // Shape
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Vertices
+{
+    /// @brief Parse a link point, "lat,lon" or "lat,lon,hae". Spaces around the
+    ///        numbers are allowed.
+    /// @param hae - [out] - NaN when the point has only two values
+    /// @return true if lat and lon parsed
+    bool ParsePoint(std::string_view text, double& lat, double& lon, double& hae);
+
+    /// @brief Replace 'out' with the point of every <link> child of <detail>, in
+    ///        order, and the first strokeColor, strokeWeight and fillColor values.
+    ///        Links without a point (a chat parent) and points that do not parse
+    ///        are skipped; with no vertices the style is left empty, as ParseCOT
+    ///        does. The scan tracks nesting but does not check the XML and does
+    ///        not decode entities.
+    /// @return number of vertices read
+    size_t Extract(const char* data, size_t size, Shape& out);
+
+    /// @brief Overloaded - Extract from a string
+    size_t Extract(const std::string& buffer, Shape& out);
+
+    /// @brief Douglas-Peucker simplification. Distances are measured in metres
+    ///        on a local flat projection around the first vertex, which is close
+    ///        enough for display over a few hundred kilometres. The first and
+    ///        last vertices are always kept. Reuse one object to keep its
+    ///        scratch buffers; not thread safe.
+    class Simplifier
+    {
+    public:
+        /// @brief Mark the vertices to keep for a tolerance in metres
+        /// @param keep - [out] - keep[i] is 1 for a kept vertex
+        /// @return number of vertices kept
+        size_t Run(const Shape& in, double toleranceMeters, std::vector<uint8_t>& keep);
+
+        /// @brief Overloaded - Copy the kept vertices and the style into 'out',
+        ///        which must not be 'in'
+        size_t Run(const Shape& in, double toleranceMeters, Shape& out);
+
+    private:
+        std::vector<double>                         mX;
+        std::vector<double>                         mY;
+        std::vector<std::pair<uint32_t, uint32_t>>  mStack;
+        std::vector<uint8_t>                        mKeep;
+    };
+
+    /// @brief Simplify with a temporary Simplifier
+    /// @return number of vertices kept
+    size_t Simplify(const Shape& in, double toleranceMeters, Shape& out);
+};
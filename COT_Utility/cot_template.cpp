@@ -0,0 +1,127 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_template.cpp
+// @brief           Implementation of the precompiled CoT message skeleton
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "cot_fields.h"                 // Emit
+#include "cot_format.h"                 // AppendFixed, AppendEscaped, TimestampWriter
+#include "cot_template.h"               // Template header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+COTTemplate::COTTemplate(const COTSchema& p, const Precision& precision)
+    : mPrecision(precision), mPending(0), mReserve(0)
+{
+    std::string& c = mConstant;
+    const Detail& d = p.detail;
+
+    c += "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>";
+    c += "<event version=\"";
+    Format::AppendFixed(c, p.event.version > 0 ? p.event.version : 2.0, 1);
+    c += "\" uid=\"";
+    AddSlot(Slot::Uid);
+    c += "\" type=\"";
+    Format::AppendEscaped(c, p.event.type);
+    c += "\" time=\"";
+    AddSlot(Slot::Time);
+    c += "\" start=\"";
+    AddSlot(Slot::Start);
+    c += "\" stale=\"";
+    AddSlot(Slot::Stale);
+    c += "\" how=\"";
+    Format::AppendEscaped(c, p.event.how);
+    c += "\">";
+
+    c += "<point lat=\"";
+    AddSlot(Slot::Latitude);
+    c += "\" lon=\"";
+    AddSlot(Slot::Longitude);
+    c += "\" hae=\"";
+    AddSlot(Slot::Hae);
+    c += "\" ce=\"";
+    Format::AppendFixed(c, p.point.circularError, 1);
+    c += "\" le=\"";
+    Format::AppendFixed(c, p.point.linearError, 1);
+    c += "\"/>";
+
+    c += "<detail>";
+    Fields::Emit(c, d.takv);
+    Fields::Emit(c, d.contact);
+    Fields::Emit(c, d.uid);
+    Fields::Emit(c, d.precisionLocation);
+    Fields::Emit(c, d.group);
+    // Written only when the prototype has them, so there is no battery="nan"
+    if (d.status.Valid())
+    {
+        c += "<status battery=\"";
+        AddSlot(Slot::Battery);
+        c += "\"/>";
+    }
+    if (d.track.Valid())
+    {
+        c += "<track course=\"";
+        AddSlot(Slot::Course);
+        c += "\" speed=\"";
+        AddSlot(Slot::Speed);
+        c += "\"/>";
+    }
+    Fields::Emit(c, d.link);
+    Fields::Emit(c, d.remarks);
+    Fields::Emit(c, d.emergency);
+    Fields::Emit(c, d.chat);
+    Fields::Emit(c, d.shape);
+    c += "</detail></event>";
+    AddSlot(Slot::End);
+
+    // Room for the constant text plus typical slot values
+    mReserve = mConstant.size() + p.event.uid.size() + 3 * 24 + 7 * Format::MaxNumber;
+}
+
+void COTTemplate::AddSlot(Slot slot)
+{
+    mPieces.push_back(Piece{ static_cast<uint32_t>(mPending), static_cast<uint32_t>(mConstant.size() - mPending), slot });
+    mPending = mConstant.size();
+}
+
+void COTTemplate::Render(const COTSchema& cot, std::string& out) const
+{
+    out.clear();
+    out.reserve(mReserve);
+
+    // Time, start and stale usually share a day, so the date is formatted once
+    Format::TimestampWriter stamps(mPrecision.seconds);
+
+    for (const Piece& piece : mPieces)
+    {
+        out.append(mConstant, piece.offset, piece.length);
+
+        switch (piece.slot)
+        {
+        case Slot::Uid:         Format::AppendEscaped(out, cot.event.uid);                                  break;
+        case Slot::Time:        stamps.Append(out, cot.event.time.ToCivil());                               break;
+        case Slot::Start:       stamps.Append(out, cot.event.start.ToCivil());                              break;
+        case Slot::Stale:       stamps.Append(out, cot.event.stale.ToCivil());                              break;
+        case Slot::Latitude:    Format::AppendFixed(out, cot.point.latitude, mPrecision.latLon);            break;
+        case Slot::Longitude:   Format::AppendFixed(out, cot.point.longitude, mPrecision.latLon);           break;
+        case Slot::Hae:         Format::AppendFixed(out, cot.point.hae, mPrecision.hae);                    break;
+        case Slot::Course:      Format::AppendFixed(out, cot.detail.track.course, mPrecision.course);       break;
+        case Slot::Speed:       Format::AppendFixed(out, cot.detail.track.speed, mPrecision.speed);         break;
+        case Slot::Battery:     Format::AppendFixed(out, cot.detail.status.battery, mPrecision.battery);    break;
+        case Slot::End:                                                                                     break;
+        }
+    }
+}
+
+std::string COTTemplate::Render(const COTSchema& cot) const
+{
+    std::string out;
+    Render(cot, out);
+    return out;
+}
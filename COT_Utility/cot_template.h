@@ -0,0 +1,101 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_template.h
+// @brief           A precompiled CoT message skeleton for senders whose events
+//                  share one structure and differ only in a few values.
+//
+//                  The constant XML (declaration, version, type, how, ce/le,
+//                  takv, contact, uid, precisionlocation, group and any link,
+//                  remarks, emergency, chat or shape) is rendered
+//                  once from a prototype COTSchema. Each Render() then copies
+//                  the constant fragments and formats only the variable slots:
+//                  uid, time, start, stale, lat, lon, hae, course, speed and
+//                  battery. Output is compact XML with the same elements as
+//                  GenerateXMLCOTMessage, without its pretty-printing, except
+//                  that <status> and <track> are written only when the
+//                  prototype has them (GenerateXMLCOTMessage writes "nan").
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstdint>                          // uint32_t
+#include <string>                           // string
+#include <vector>                           // vector
+//
+#include "cot_info.h"                       // COTSchema
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+class COTTemplate
+{
+public:
+
+    /// @brief Decimal places written for the variable numbers
+    struct Precision
+    {
+        int latLon;                 /// About 1 cm at 7
+        int hae;
+        int course;
+        int speed;
+        int battery;
+        int seconds;                /// Fractional second digits of time, start and stale
+
+        /// @brief Constructor - Initializes Everything
+        Precision(int latLon = 7, int hae = 2, int course = 2, int speed = 2, int battery = 0, int seconds = 2)
+            : latLon(latLon), hae(hae), course(course), speed(speed), battery(battery), seconds(seconds) {}
+    };
+
+    /// @brief Compile a template
+    /// @param prototype - [in] - schema supplying every constant field
+    /// @param precision - [in/opt] - decimal places of the variable numbers
+    explicit COTTemplate(const COTSchema& prototype, const Precision& precision = Precision());
+
+    /// @brief Render a message. Variable slots come from 'cot', everything
+    ///        else from the prototype. 'out' is overwritten and its capacity
+    ///        reused, so a warm string renders without allocating.
+    void Render(const COTSchema& cot, std::string& out) const;
+
+    /// @brief Overloaded - Render a message into a new string
+    std::string Render(const COTSchema& cot) const;
+
+    /// @brief Constant text, all fragments back to back
+    const std::string& Constant() const { return mConstant; }
+
+private:
+
+    enum class Slot : uint8_t
+    {
+        Uid,
+        Time,
+        Start,
+        Stale,
+        Latitude,
+        Longitude,
+        Hae,
+        Course,
+        Speed,
+        Battery,
+        End         /// Last fragment, no slot after it
+    };
+
+    /// @brief A constant fragment of mConstant followed by a slot
+    struct Piece
+    {
+        uint32_t    offset;
+        uint32_t    length;
+        Slot        slot;
+    };
+
+    /// @brief Close the pending fragment with a slot
+    void AddSlot(Slot slot);
+
+    std::string         mConstant;
+    std::vector<Piece>  mPieces;
+    Precision           mPrecision;
+    size_t              mPending;       /// Start of the fragment being built
+    size_t              mReserve;       /// Typical output size
+};
@@ -0,0 +1,182 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_trace.cpp
+// @brief           Implementation of the COT Utility trace rings
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // sort
+#include <cstdio>                       // snprintf
+#include <fstream>                      // ofstream
+//
+#include "cot_trace.h"                  // Trace header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Trace
+{
+    std::atomic<bool> gEnabled(true);
+
+    namespace
+    {
+        const uint64_t kRingSize = COT_TRACE_RING_SIZE;
+        static_assert((kRingSize & (kRingSize - 1)) == 0, "COT_TRACE_RING_SIZE must be a power of two");
+
+        /// @brief Single writer ring. Fields are relaxed atomics so a concurrent
+        ///        Collect() reads stale values at worst, never torn ones; 'head'
+        ///        tells it which slots may have been overwritten during the copy.
+        struct Ring
+        {
+            std::atomic<uint64_t>       head{ 0 };
+            std::atomic<const char*>    name[kRingSize];
+            std::atomic<uint64_t>       start[kRingSize];
+            std::atomic<uint64_t>       duration[kRingSize];
+        };
+
+        /// @brief Rings are never freed, so spans of finished threads can still be dumped
+        std::atomic<Ring*> gRings[MaxThreads];
+        std::atomic<unsigned> gNextRing(0);
+
+        const std::chrono::steady_clock::time_point gEpoch = std::chrono::steady_clock::now();
+
+        Ring* ThreadRing()
+        {
+            thread_local Ring* ring = nullptr;
+            thread_local bool claimed = false;
+            if (!claimed)
+            {
+                claimed = true;
+                const unsigned index = gNextRing.fetch_add(1, std::memory_order_relaxed);
+                if (index < MaxThreads)
+                {
+                    ring = new Ring();
+                    gRings[index].store(ring, std::memory_order_release);
+                }
+            }
+            return ring;
+        }
+    };
+
+    void SetEnabled(bool enabled)
+    {
+        gEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint64_t Now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - gEpoch).count());
+    }
+
+    void Record(const char* name, uint64_t start, uint64_t duration)
+    {
+        Ring* ring = ThreadRing();
+        if (ring == nullptr)
+        {
+            return;
+        }
+
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t slot = head & (kRingSize - 1);
+        ring->name[slot].store(name, std::memory_order_relaxed);
+        ring->start[slot].store(start, std::memory_order_relaxed);
+        ring->duration[slot].store(duration, std::memory_order_relaxed);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    std::vector<Span> Collect()
+    {
+        std::vector<Span> spans;
+        for (unsigned t = 0; t < MaxThreads; t++)
+        {
+            const Ring* ring = gRings[t].load(std::memory_order_acquire);
+            if (ring == nullptr)
+            {
+                continue;
+            }
+
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            const uint64_t first = head > kRingSize ? head - kRingSize : 0;
+            const size_t begin = spans.size();
+            for (uint64_t i = first; i < head; i++)
+            {
+                const uint64_t slot = i & (kRingSize - 1);
+                Span s;
+                s.name = ring->name[slot].load(std::memory_order_relaxed);
+                s.thread = t;
+                s.start = ring->start[slot].load(std::memory_order_relaxed);
+                s.duration = ring->duration[slot].load(std::memory_order_relaxed);
+                spans.push_back(s);
+            }
+
+            // Drop the slots the writer reused while they were being copied
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t after = ring->head.load(std::memory_order_relaxed);
+            const uint64_t valid = after > kRingSize ? after - kRingSize : 0;
+            if (valid > first)
+            {
+                const uint64_t lost = std::min(valid - first, head - first);
+                spans.erase(spans.begin() + begin, spans.begin() + begin + static_cast<size_t>(lost));
+            }
+        }
+
+        // Parents before children that start on the same tick
+        std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b)
+        {
+            return a.start != b.start ? a.start < b.start : a.duration > b.duration;
+        });
+        return spans;
+    }
+
+    void Clear()
+    {
+        for (auto& slot : gRings)
+        {
+            Ring* ring = slot.load(std::memory_order_acquire);
+            if (ring != nullptr)
+            {
+                ring->head.store(0, std::memory_order_release);
+            }
+        }
+    }
+
+    std::string RenderChromeTrace(const std::vector<Span>& spans)
+    {
+        std::string out;
+        out.reserve(64 + spans.size() * 96);
+        out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+        char line[256];
+        bool first = true;
+        for (const Span& s : spans)
+        {
+            // Span names are static identifiers from the library; no escaping needed
+            std::snprintf(line, sizeof(line),
+                "%s\n{\"name\":\"%s\",\"cat\":\"cot\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",", s.name, s.thread,
+                static_cast<double>(s.start) / 1000.0, static_cast<double>(s.duration) / 1000.0);
+            out += line;
+            first = false;
+        }
+
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool WriteChromeTrace(const std::string& path)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        file << RenderChromeTrace(Collect());
+        return static_cast<bool>(file);
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_trace.h
+// @brief           Optional scoped trace points for the COT Utility hot paths.
+//
+//                  The instrumentation macros at the bottom of this file compile
+//                  to nothing unless COT_ENABLE_TRACING is defined. When compiled
+//                  in, every span is written to a fixed size per-thread ring
+//                  buffer (oldest spans are overwritten), and the rings can be
+//                  dumped as Chrome trace-event JSON for chrome://tracing or
+//                  ui.perfetto.dev.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <atomic>                           // atomic
+#include <chrono>                           // steady_clock
+#include <cstdint>                          // uint64_t
+#include <string>                           // string
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Spans kept per thread, must be a power of two. A ParseCOT call
+///        records about eight spans.
+#ifndef COT_TRACE_RING_SIZE
+#define COT_TRACE_RING_SIZE 8192
+#endif
+
+namespace Trace
+{
+    /// @brief One completed span, as returned by Collect()
+    struct Span
+    {
+        const char* name;           /// Static span name
+        uint32_t    thread;         /// Small thread number, in order of first span
+        uint64_t    start;          /// Start in ns since the trace epoch
+        uint64_t    duration;       /// Duration in ns
+    };
+
+    /// @brief Most threads that can record. Later threads are not traced.
+    static const unsigned MaxThreads = 256;
+
+    /// @brief Runtime switch, on by default
+    extern std::atomic<bool> gEnabled;
+
+    inline bool Enabled() { return gEnabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enabled);
+
+    /// @brief Nanoseconds since the trace epoch (first use in the process)
+    uint64_t Now();
+
+    /// @brief Append a completed span to the calling thread's ring
+    /// @param name     - [in] - span name, must have static lifetime
+    /// @param start    - [in] - start from Now()
+    /// @param duration - [in] - duration in ns
+    void Record(const char* name, uint64_t start, uint64_t duration);
+
+    /// @brief Copy the spans still held by every ring, ordered by start time.
+    ///        Safe while writers run; spans overwritten during the copy are dropped.
+    std::vector<Span> Collect();
+
+    /// @brief Drop every recorded span. Not atomic with respect to writers.
+    void Clear();
+
+    /// @brief Render spans as Chrome trace-event JSON ("X" complete events, us)
+    std::string RenderChromeTrace(const std::vector<Span>& spans);
+
+    /// @brief Collect() and write RenderChromeTrace() to a file
+    /// @return true if the file was written
+    bool WriteChromeTrace(const std::string& path);
+
+    /// @brief Records the lifetime of the scope as a span. Next() ends the
+    ///        current span and starts another, for sequential phases that share
+    ///        one scope.
+    class ScopedSpan
+    {
+    public:
+        explicit ScopedSpan(const char* name) : mName(name), mActive(Enabled())
+        {
+            if (mActive) { mStart = Now(); }
+        }
+
+        ~ScopedSpan()
+        {
+            if (mActive) { Record(mName, mStart, Now() - mStart); }
+        }
+
+        void Next(const char* name)
+        {
+            if (mActive)
+            {
+                const uint64_t now = Now();
+                Record(mName, mStart, now - mStart);
+                mStart = now;
+            }
+            mName = name;
+        }
+
+        ScopedSpan(const ScopedSpan&) = delete;
+        ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    private:
+        const char* mName;
+        bool        mActive;
+        uint64_t    mStart = 0;
+    };
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+// Instrumentation macros used inside the library
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifdef COT_ENABLE_TRACING
+#define COT_TRACE_SCOPE(var, name)  Trace::ScopedSpan cotTrace_##var(name)
+#define COT_TRACE_NEXT(var, name)   cotTrace_##var.Next(name)
+#else
+#define COT_TRACE_SCOPE(var, name)  do { } while (0)
+#define COT_TRACE_NEXT(var, name)   do { } while (0)
+#endif
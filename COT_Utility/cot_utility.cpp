@@ -11,22 +11,165 @@
 //          name                        reason included
 //          --------------------        ---------------------------------------
 #include <sstream>                      // Stringstream
+#include <algorithm>                    // remove, remove_if
+#include <cctype>                       // isspace
+#include <cmath>                        // NAN
+#include <limits>                       // numeric_limits
+#include <string_view>                  // string_view
+#include <type_traits>                  // decay_t
+#include <vector>                       // vector
 //
 #include "cot_utility.h"                // COT Parser header.
+#include "cot_metrics.h"                // Counters and latency histograms
+#include "cot_trace.h"                  // Trace points
+#include "cot_alloc_profile.h"          // Allocation phases
+#include "cot_format.h"                 // TimestampWriter, ReadReal
+#include "cot_shape.h"                  // ParsePoint
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+// A phase is both a trace span and an allocation profiler site
+#define COT_PHASE(var, name)        COT_TRACE_SCOPE(var, name); COT_ALLOC_SCOPE(var, name)
+#define COT_PHASE_NEXT(var, name)   COT_TRACE_NEXT(var, name); COT_ALLOC_NEXT(var, name)
+
+namespace
+{
+    void ReadAttribute(const pugi::xml_node& node, const char* name, std::string& value)
+    {
+        pugi::xml_attribute attr = node.attribute(name);
+        attr ? value = attr.as_string() : value = "";
+    }
+
+    void ReadAttribute(const pugi::xml_node& node, const char* name, double& value)
+    {
+        // A missing attribute has an empty value, which reads as 0
+        Format::ReadReal(node.attribute(name).value(), value);
+    }
+
+    /// @brief Read every attribute in T's field table. A missing attribute reads
+    ///        as empty or 0; a missing nested element leaves its member untouched,
+    ///        or resets it when the table lists it as an Extension.
+    /// @param children - [in/opt] - bit n set reads the n'th nested element
+    template <class T>
+    void ReadElement(const pugi::xml_node& node, T& out, uint32_t children = ~0u);
+
+    template <class T>
+    void Reset(T& out)
+    {
+        out = T();
+    }
+
+    void Reset(Shape& out)
+    {
+        out.Clear();
+    }
+
+    /// @brief The first <link> without a 'point'; the ones with are shape vertices
+    void ReadElement(const pugi::xml_node& first, Link& out, uint32_t = ~0u)
+    {
+        for (pugi::xml_node link = first; link; link = link.next_sibling(Link::Element))
+        {
+            if (!link.attribute("point"))
+            {
+                ReadElement<Link>(link, out);
+                return;
+            }
+        }
+        Reset(out);
+    }
+
+    /// @brief Every <link point="lat,lon[,hae]"/> from the first <link> on, then
+    ///        the style elements beside them
+    void ReadElement(const pugi::xml_node& first, Shape& out, uint32_t = ~0u)
+    {
+        out.Clear();
+        for (pugi::xml_node link = first; link; link = link.next_sibling(Shape::Element))
+        {
+            pugi::xml_attribute point = link.attribute("point");
+            if (!point)
+            {
+                continue;
+            }
+
+            double lat, lon, hae;
+            if (!Vertices::ParsePoint(point.value(), lat, lon, hae))
+            {
+                continue;
+            }
+            out.Add(lat, lon, hae);
+        }
+
+        // Style only goes with vertices
+        if (out.Size() == 0)
+        {
+            return;
+        }
+        const pugi::xml_node detail = first.parent();
+        ReadAttribute(detail.child("strokeColor"), "value", out.strokeColor);
+        pugi::xml_attribute weight = detail.child("strokeWeight").attribute("value");
+        out.strokeWeight = NAN;
+        if (weight)
+        {
+            Format::ReadReal(weight.value(), out.strokeWeight);
+        }
+        ReadAttribute(detail.child("fillColor"), "value", out.fillColor);
+    }
+
+    template <class T>
+    void ReadElement(const pugi::xml_node& node, T& out, uint32_t children)
+    {
+        unsigned index = 0;
+        Fields::ForEach<T>([&](const auto& d)
+        {
+            using D = std::decay_t<decltype(d)>;
+            if constexpr (Fields::IsChild<D>::value)
+            {
+                using Sub = std::decay_t<decltype(out.*d.member)>;
+                if ((children >> index++) & 1u)
+                {
+                    if (pugi::xml_node child = node.child(Sub::Element))
+                    {
+                        ReadElement(child, out.*d.member);
+                    }
+                    else if (!d.required)
+                    {
+                        Reset(out.*d.member);
+                    }
+                }
+            }
+            else if constexpr (Fields::IsContent<D>::value)
+            {
+                out.*d.member = node.child_value();
+            }
+            else
+            {
+                ReadAttribute(node, d.xml, out.*d.member);
+            }
+        });
+    }
+
+    // The detail bits of ParseOptions are indexed by Detail's table
+    static_assert(std::tuple_size<decltype(Detail::Describe())>::value == 12 &&
+        ParseOptions::Takv == 1u << ParseOptions::DetailShift &&
+        (ParseOptions::Detail >> ParseOptions::DetailShift) == 0xFFF, "ParseOptions detail bits must match Detail::Describe()");
+};
+
 COT_Utility::COT_Utility() {}
 
 COT_Utility::~COT_Utility() {}
 
 bool COT_Utility::VerifyXML(std::string& buffer)
 {
+    COT_METRIC_TIMER(Verify);
+    COT_METRIC_INC(VerifyCalls);
+    COT_PHASE(verify, "VerifyXML");
+
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_string(buffer.c_str());
 
     if (!result)
     {
+        COT_METRIC_INC(VerifyFailed);
         std::cout << "ERROR: " << result.description() << "\n";
         return false;
     }
@@ -36,49 +179,59 @@ bool COT_Utility::VerifyXML(std::string& buffer)
 
 std::string COT_Utility::GenerateXMLCOTMessage(COTSchema& cot) 
 {
+    COT_METRIC_TIMER(Generate);
+    COT_METRIC_INC(GenerateCalls);
+    COT_PHASE(generate, "GenerateXMLCOTMessage");
+    COT_PHASE(phase, "Generate/build");
+
     std::stringstream msg;
 
     // XML declaration
     msg << "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>";
 
-    // Event start
-    msg << "<event version=\"2.0\" uid=\"" << cot.event.uid << "\" type=\"" << cot.event.type << "\" time=\"" << cot.event.time.ToCOTTimestamp() <<
-        "\" start=\"" << cot.event.time.ToCOTTimestamp() << "\" stale=\"" << cot.event.stale.ToCOTTimestamp() << "\" how=\"" << cot.event.how << "\">";
-
-    // Point data
-    msg << "<point lat=\"" << cot.point.latitude << "\" lon=\"" << cot.point.longitude << "\" hae=\"" << cot.point.hae << "\" ce=\"" << cot.point.circularError << "\" le=\"" << cot.point.linearError << "\"/>";
-
-    // Detail section
-    msg << "<detail>";
+    // Timestamps, sharing one date prefix when they fall on the same day
+    Format::TimestampWriter stamps;
+    char time[Format::MaxTimestamp], start[Format::MaxTimestamp], stale[Format::MaxTimestamp];
+    const std::string_view timeText(time, stamps.Write(time, cot.event.time.ToCivil()) - time);
+    const std::string_view startText(start, stamps.Write(start, cot.event.start.ToCivil()) - start);
+    const std::string_view staleText(stale, stamps.Write(stale, cot.event.stale.ToCivil()) - stale);
 
-    if (!cot.detail.contact.callsign.empty())
-    {
-        msg << "<contact callsign=\"" << cot.detail.contact.callsign << "\" endpoint=\"" << cot.detail.contact.endpoint << "\" xmppUsername=\"" << cot.detail.contact.xmppUsername << "\"/>";
-    }
+    // Event start
+    msg << "<event version=\"2.0\" uid=\"" << cot.event.uid << "\" type=\"" << cot.event.type << "\" time=\"" << timeText <<
+        "\" start=\"" << startText << "\" stale=\"" << staleText << "\" how=\"" << cot.event.how << "\">";
 
-    msg << "<uid Droid=\"" << cot.detail.uid.droid << "\"/>";
-    msg << "<__group name=\"" << cot.detail.group.name << "\" role=\"" << cot.detail.group.role << "\"/>";
-    msg << "<status battery=\"" << cot.detail.status.battery << "\"/>";
-    msg << "<track course=\"" << cot.detail.track.course << "\" speed=\"" << cot.detail.track.speed << "\"/>"; // corrected line
-    msg << "</detail></event>";
+    // Point and detail, from their field tables
+    std::string body;
+    Fields::Emit(body, cot.point);
+    Fields::Emit(body, cot.detail);
+    msg << body << "</event>";
 
     // Create XML document to load in the msg for propper xml formating 
+    COT_PHASE_NEXT(phase, "Generate/reparse");
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_string(msg.str().c_str());
 
     if (result)
     {
+        COT_PHASE_NEXT(phase, "Generate/format");
         std::stringstream newMsg;
         doc.save(newMsg);
-        return newMsg.str();
+        std::string out = newMsg.str();
+        COT_METRIC_ADD(GenerateBytes, out.size());
+        return out;
     }
 
     // else just send unformatted string
-    return msg.str();
+    std::string out = msg.str();
+    COT_METRIC_ADD(GenerateBytes, out.size());
+    return out;
 }
 
 bool COT_Utility::UpdateReceivedCOTMessage(std::string& receivedMessage, COTSchema& cot, std::string& modifiedMessage, bool acknowledgment)
 {
+    COT_METRIC_TIMER(Update);
+    COT_METRIC_INC(UpdateCalls);
+
     // Create XML document to load in the receivedMessage
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_string(receivedMessage.c_str());
@@ -119,6 +272,7 @@ bool COT_Utility::UpdateReceivedCOTMessage(std::string& receivedMessage, COTSche
             std::stringstream modifiedXmlStream;
             doc.save(modifiedXmlStream);
             modifiedMessage = modifiedXmlStream.str();
+            COT_METRIC_INC(UpdateModified);
             return true;
         }
 
@@ -127,6 +281,7 @@ bool COT_Utility::UpdateReceivedCOTMessage(std::string& receivedMessage, COTSche
     }
     else 
     {
+        COT_METRIC_INC(UpdateFailed);
         std::cerr << "Failed to parse XML: " << result.description() << std::endl;
         return false;
     }
@@ -134,6 +289,9 @@ bool COT_Utility::UpdateReceivedCOTMessage(std::string& receivedMessage, COTSche
 
 bool COT_Utility::AcknowledgeReceivedCOTMessage(std::string& receivedMessage, std::string& responseMessage)
 {
+    COT_METRIC_TIMER(Acknowledge);
+    COT_METRIC_INC(AckCalls);
+
     // Create XML document to load in the receivedMessage
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_string(receivedMessage.c_str());
@@ -163,6 +321,7 @@ bool COT_Utility::AcknowledgeReceivedCOTMessage(std::string& receivedMessage, st
             std::stringstream modifiedXmlStream;
             doc.save(modifiedXmlStream);
             responseMessage = modifiedXmlStream.str();
+            COT_METRIC_INC(AckModified);
             return true;
         }
 
@@ -171,26 +330,67 @@ bool COT_Utility::AcknowledgeReceivedCOTMessage(std::string& receivedMessage, st
     }
     else
     {
+        COT_METRIC_INC(AckFailed);
         std::cerr << "Failed to parse XML: " << result.description() << std::endl;
         return false;
     }
 }
 
-int COT_Utility::ParseCOT(std::string& buffer, COTSchema& cot)
+int COT_Utility::ParseCOT(std::string& buffer, COTSchema& cot, uint32_t options)
 {
+    COT_METRIC_TIMER(Parse);
+    COT_METRIC_INC(ParseCalls);
+    COT_METRIC_ADD(ParseBytes, buffer.size());
+    COT_PHASE(parse, "ParseCOT");
+    COT_PHASE(phase, "ParseCOT/prefix");
+
     // Remove any trash that may come in before the "<?xml" tag.
     size_t position = buffer.find("<?xml");
+    if (position == std::string::npos)
+    {
+        COT_METRIC_FAIL(NoXmlDeclaration);
+        COT_METRIC_INC(ParseRejected);
+        return -1;
+    }
     buffer.erase(0, position);
 
+    // Cheap structural check, without building a tree
+    Validate::Issue issue;
+    if ((mValidation & Validate::WellFormed) && !Validate::CheckWellFormed(buffer, issue))
+    {
+        COT_METRIC_FAIL(NotWellFormed);
+        COT_METRIC_INC(ParseRejected);
+        std::cerr << "\nERROR: " << issue.what << " at byte " << issue.offset << "\n";
+        return -1;
+    }
+
     // Verify buffer is good XML data first. 
-    if (!VerifyXML(buffer))
+    COT_PHASE_NEXT(phase, "ParseCOT/xml");
+    if ((mValidation & Validate::Document) && !VerifyXML(buffer))
     {
+        COT_METRIC_FAIL(MalformedXml);
+        COT_METRIC_INC(ParseRejected);
         return -1;
     }
 
     // Create a parsed xml document.
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_string(buffer.c_str());
+    if (!result)
+    {
+        COT_METRIC_FAIL(MalformedXml);
+        COT_METRIC_INC(ParseRejected);
+        std::cout << "ERROR: " << result.description() << "\n";
+        return -1;
+    }
+
+    if ((mValidation & Validate::Strict) && !Validate::CheckStrict(doc, issue))
+    {
+        COT_METRIC_FAIL(NotStrict);
+        COT_METRIC_INC(ParseRejected);
+        std::cerr << "\nERROR: " << issue.field << (*issue.field ? ": " : "") << issue.what << "\n";
+        return -1;
+    }
 
     // Set up nodes for ease and easier reading later
     pugi::xml_node root = doc.root();
@@ -210,129 +410,144 @@ int COT_Utility::ParseCOT(std::string& buffer, COTSchema& cot)
     // in the event we start parsing into a vector. 
     if (eventsSize != 1)
     {
+        COT_METRIC_FAIL(EventCount);
+        COT_METRIC_INC(ParseRejected);
         std::cerr << "\nERROR: Event Size Error\n";
         return -1;
     }
     else if (pointsSize != 1)
     {
+        COT_METRIC_FAIL(PointCount);
+        COT_METRIC_INC(ParseRejected);
         std::cerr << "\nERROR: Point Size Error\n";
         return -1;
     }
 
     // Parse <event> tag and gather data. 
+    COT_PHASE_NEXT(phase, "ParseCOT/event");
     for (auto&& event : root.children("event"))
     {
-        std::string time, start, stale;
         // Read attribute value
         pugi::xml_attribute attr;
-        (attr = event.attribute("version")) ? cot.event.version = attr.as_double() : cot.event.version = 0;
-
-        // Parse Type attribute into data points.
-        (attr = event.attribute("type")) ? cot.event.type = attr.as_string() : cot.event.type = "";
-        ParseTypeAttribute(cot.event.type, cot.event.indicator, cot.event.location);
-
-        // Parse UID
-        (attr = event.attribute("uid")) ? cot.event.uid = attr.as_string() : cot.event.uid = "";
-
-        // Parse times into data points in COT structure
-        (attr = event.attribute("time")) ? time = attr.as_string() : time = "";
-        ParseTimeAttribute(time, cot.event.time);
-        (attr = event.attribute("start")) ? start = attr.as_string() : start = "";
-        ParseTimeAttribute(start, cot.event.start);
-        (attr = event.attribute("stale")) ? stale = attr.as_string() : stale = "";
-        ParseTimeAttribute(stale, cot.event.stale);
-
-        // Parse How attribute into data points.
-        (attr = event.attribute("how")) ? cot.event.how = attr.as_string() : cot.event.how = "";
-        ParseHowAttribute(cot.event.how, cot.event.howEntry, cot.event.howData);
-
-        // Parse <event><point> tag and gather data. 
-        for (auto&& point : event.children("point"))
+        if (options & ParseOptions::EventCore)
         {
-            // Read attribute value
-            pugi::xml_attribute attr1;
-            (attr1 = point.attribute("lat")) ? cot.point.latitude = attr1.as_double() : cot.point.latitude = 0;
-            (attr1 = point.attribute("lon")) ? cot.point.longitude = attr1.as_double() : cot.point.longitude = 0;
-            (attr1 = point.attribute("hae")) ? cot.point.hae = attr1.as_double() : cot.point.hae = 0;
-            (attr1 = point.attribute("ce")) ? cot.point.circularError = attr1.as_double() : cot.point.circularError = 0;
-            (attr1 = point.attribute("le")) ? cot.point.linearError = attr1.as_double() : cot.point.linearError = 0;
-        }
+            Format::ReadReal(event.attribute("version").value(), cot.event.version);
 
-        // Parse <event><detail> tag and gather data. 
-        for (auto&& detail : events.children("detail"))
-        {
-            pugi::xml_attribute attr1;
-
-            // Parse <takv>
-            pugi::xml_node takv = detail.child("takv");
-            if (takv)
+            // Parse Type attribute into data points.
+            (attr = event.attribute("type")) ? cot.event.type = attr.as_string() : cot.event.type = "";
+            if (!ParseTypeAttribute(cot.event.type, cot.event.indicator, cot.event.location))
             {
-                (attr1 = takv.attribute("version")) ? cot.detail.takv.version = attr1.as_string() : cot.detail.takv.version = "";
-                (attr1 = takv.attribute("device")) ? cot.detail.takv.device = attr1.as_string() : cot.detail.takv.device = "";
-                (attr1 = takv.attribute("os")) ? cot.detail.takv.os = attr1.as_string() : cot.detail.takv.os = "";
-                (attr1 = takv.attribute("platform")) ? cot.detail.takv.platform = attr1.as_string() : cot.detail.takv.platform = "";
+                COT_METRIC_FAIL(BadType);
             }
 
-            // Parse <contact>
-            pugi::xml_node contact = detail.child("contact");
-            if (contact)
+            // Parse UID
+            (attr = event.attribute("uid")) ? cot.event.uid = attr.as_string() : cot.event.uid = "";
+
+            // Parse How attribute into data points.
+            (attr = event.attribute("how")) ? cot.event.how = attr.as_string() : cot.event.how = "";
+            if (!ParseHowAttribute(cot.event.how, cot.event.howEntry, cot.event.howData))
             {
-                (attr1 = contact.attribute("endpoint")) ? cot.detail.contact.endpoint = attr1.as_string() : cot.detail.contact.endpoint = "";
-                (attr1 = contact.attribute("callsign")) ? cot.detail.contact.callsign = attr1.as_string() : cot.detail.contact.callsign = "";
-                (attr1 = contact.attribute("xmppUsername")) ? cot.detail.contact.xmppUsername = attr1.as_string() : cot.detail.contact.xmppUsername = "";
+                COT_METRIC_FAIL(BadHow);
             }
+        }
 
-            // Parse <uid>
-            pugi::xml_node uid = detail.child("uid");
-            if (uid)
+        // Parse times into data points in COT structure
+        if (options & ParseOptions::Times)
+        {
+            std::string time, start, stale;
+            (attr = event.attribute("time")) ? time = attr.as_string() : time = "";
+            if (!ParseTimeAttribute(time, cot.event.time))
             {
-                (attr1 = uid.attribute("Droid")) ? cot.detail.uid.droid = attr1.as_string() : cot.detail.uid.droid = "";
+                COT_METRIC_FAIL(BadTime);
             }
-
-            // Parse <precisionlocation>
-            pugi::xml_node precision = detail.child("precisionlocation");
-            if (precision)
+            (attr = event.attribute("start")) ? start = attr.as_string() : start = "";
+            if (!ParseTimeAttribute(start, cot.event.start))
             {
-                (attr1 = precision.attribute("altsrc")) ? cot.detail.precisionLocation.altsrc = attr1.as_string() : cot.detail.precisionLocation.altsrc = "";
-                (attr1 = precision.attribute("geopointsrc")) ? cot.detail.precisionLocation.geopointsrc = attr1.as_string() : cot.detail.precisionLocation.geopointsrc = "";
+                COT_METRIC_FAIL(BadStart);
             }
-
-            // Parse <__group>
-            pugi::xml_node group = detail.child("__group");
-            if (group)
+            (attr = event.attribute("stale")) ? stale = attr.as_string() : stale = "";
+            if (!ParseTimeAttribute(stale, cot.event.stale))
             {
-                (attr1 = group.attribute("role")) ? cot.detail.group.role = attr1.as_string() : cot.detail.group.role = "";
-                (attr1 = group.attribute("name")) ? cot.detail.group.name = attr1.as_string() : cot.detail.group.name = "";
+                COT_METRIC_FAIL(BadStale);
             }
+        }
 
-            // Parse <status>
-            pugi::xml_node status = detail.child("status");
-            if (status)
+        // Parse <event><point> tag and gather data. 
+        COT_PHASE_NEXT(phase, "ParseCOT/point");
+        if (options & ParseOptions::Point)
+        {
+            for (auto&& point : event.children(Point::Data::Element))
             {
-                (attr1 = status.attribute("battery")) ? cot.detail.status.battery = attr1.as_double() : cot.detail.status.battery = 0;
+                ReadElement(point, cot.point);
             }
+        }
 
-            // Parse <track>
-            pugi::xml_node track = detail.child("track");
-            if (track)
+        // Parse <event><detail> tag and gather data. 
+        COT_PHASE_NEXT(phase, "ParseCOT/detail");
+        if (options & ParseOptions::Detail)
+        {
+            for (auto&& detail : events.children(Detail::Element))
             {
-                (attr1 = track.attribute("course")) ? cot.detail.track.course = attr1.as_double() : cot.detail.track.course = 0;
-                (attr1 = track.attribute("speed")) ? cot.detail.track.speed = attr1.as_double() : cot.detail.track.speed = 0;
+                ReadElement(detail, cot.detail, options >> ParseOptions::DetailShift);
             }
         }
     }
 
+    // Values checked last, once they are decoded
+    if ((mValidation & Validate::Semantic) && !Validate::CheckSemantic(cot, issue, options))
+    {
+        COT_METRIC_FAIL(NotSemantic);
+        COT_METRIC_INC(ParseRejected);
+        std::cerr << "\nERROR: " << issue.field << (*issue.field ? ": " : "") << issue.what << "\n";
+        return -1;
+    }
+
     // return number of points read
+    COT_METRIC_INC(ParseAccepted);
     return pointsSize;
 }
 
-int COT_Utility::ParseCOT(const char* buffer, COTSchema& cot)
+int COT_Utility::ParseCOT(const char* buffer, COTSchema& cot, uint32_t options)
 {
+    if (buffer == nullptr)
+    {
+        return -1;
+    }
+
+    // Charged with the copy only, the parse below enters its own phases
+    COT_ALLOC_SCOPE(copy, "ParseCOT/copy");
     std::string str = buffer;
-    int num = ParseCOT(str, cot);
+    int num = ParseCOT(str, cot, options);
     return num;
 }
 
+int COT_Utility::ParseCOT(std::string& buffer, COTSchema& cot, const Peek::Filter& accept, uint32_t options)
+{
+    Peek::Header header;
+    if (Peek::PeekHeader(buffer, header) && !header.truncated && accept && !accept(header))
+    {
+        COT_METRIC_INC(ParseFiltered);
+        return 0;
+    }
+    return ParseCOT(buffer, cot, options);
+}
+
+int COT_Utility::ParseCOT(const char* buffer, COTSchema& cot, const Peek::Filter& accept, uint32_t options)
+{
+    if (buffer == nullptr)
+    {
+        return -1;
+    }
+
+    Peek::Header header;
+    if (Peek::PeekHeader(buffer, std::char_traits<char>::length(buffer), header) && !header.truncated && accept && !accept(header))
+    {
+        COT_METRIC_INC(ParseFiltered);
+        return 0;
+    }
+    return ParseCOT(buffer, cot, options);
+}
+
 COTSchema COT_Utility::ParseBufferToCOT(const char* buffer)
 {
     COTSchema cot;
@@ -347,6 +562,8 @@ std::string COT_Utility::GetVersion()
 
 bool COT_Utility::ParseTypeAttribute(std::string& type, Point::Type& ind, Location::Type& loc)
 {
+    COT_PHASE(type, "ParseTypeAttribute");
+
     // Read the data from the file as String Vector
     std::vector<std::string> values;
     values.clear();
@@ -368,7 +585,7 @@ bool COT_Utility::ParseTypeAttribute(std::string& type, Point::Type& ind, Locati
 
     // Type string must have minimum 3 type identifiers to give us the data we need. 
     //      Must also start with an "a" as its the onlt identifier we currently support. 
-    if ((values.size() < 2) || (values[0] != "a"))
+    if ((values.size() < 3) || (values[0] != "a"))
     {
         return false;
     }
@@ -383,6 +600,8 @@ bool COT_Utility::ParseTypeAttribute(std::string& type, Point::Type& ind, Locati
 
 bool COT_Utility::ParseHowAttribute(std::string& type, How::Entry::Type& how, How::Data::Type& data)
 {
+    COT_PHASE(how, "ParseHowAttribute");
+
     // Read the data from the file as String Vector
     std::vector<std::string> values;
     values.clear();
@@ -403,7 +622,7 @@ bool COT_Utility::ParseHowAttribute(std::string& type, How::Entry::Type& how, Ho
     }
 
     // Type string must have minimum 2 type identifiers to give us the data we need. 
-    if (values.size() < 1)
+    if (values.size() < 2)
     {
         return false;
     }
@@ -418,6 +637,8 @@ bool COT_Utility::ParseHowAttribute(std::string& type, How::Entry::Type& how, Ho
 
 bool COT_Utility::ParseTimeAttribute(std::string& type, DateTime& dt)
 {
+    COT_PHASE(time, "ParseTimeAttribute");
+
     // Read the data from the file as String Vector
     std::vector<std::string> values;
     values.clear();
@@ -438,19 +659,23 @@ bool COT_Utility::ParseTimeAttribute(std::string& type, DateTime& dt)
     }
 
     // Time string must have minimum 2 type identifiers (Date and Time) to give us the data we need. 
+    // A failure leaves dt invalid, never half written or holding the last message's time.
     if (values.size() < 2)
     {
         std::cerr << "Failed to parse time attribute!\n";
+        dt = DateTime();
         return false;
     }
     else if (!ParseDateStamp(values[0], dt))
     {
         std::cerr << "Failed to parse date stamp!\n";
+        dt = DateTime();
         return false;
     }
     else if (!ParseTimeStamp(values[1], dt))
     {
         std::cerr << "Failed to parse time stamp!\n";
+        dt = DateTime();
         return false;
     }
     return true;
@@ -473,17 +698,15 @@ bool COT_Utility::ParseDateStamp(std::string& type, DateTime& dt)
     }
 
     // Time string must have minimum 3 type identifiers (Year, Month, Day) to give us the data we need. 
-    if (values.size() < 3)
+    int year = 0, month = 0, day = 0;
+    if (values.size() < 3 || !ParseInteger(values[0], year) || !ParseInteger(values[1], month) || !ParseInteger(values[2], day))
     {
         return false;
     }
-    else
-    {
-        dt.year = std::stoi(values[0]);
-        dt.month = std::stoi(values[1]);
-        dt.day = std::stoi(values[2]);
-    }
 
+    dt.year = year;
+    dt.month = month;
+    dt.day = day;
     return true;
 }
 
@@ -507,89 +730,76 @@ bool COT_Utility::ParseTimeStamp(std::string& type, DateTime& dt)
     }
 
     // Time string must have minimum 3 type identifiers (Hour, Minute, Secs) to give us the data we need. 
-    if (values.size() < 3)
+    int hour = 0, minute = 0, second = 0;
+    if (values.size() < 3 || !ParseInteger(values[0], hour) || !ParseInteger(values[1], minute) || !ParseInteger(values[2], second))
     {
         return false;
     }
-    else
+
+    dt.hour = hour;
+    dt.minute = minute;
+    dt.second = second;
+    return true;
+}
+
+bool COT_Utility::ParseInteger(const std::string& text, int& value)
+{
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+    {
+        i++;
+    }
+
+    bool negative = false;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+    {
+        negative = (text[i] == '-');
+        i++;
+    }
+
+    // Accumulate as a negative number so INT_MIN is reachable without overflow
+    const size_t first = i;
+    long long result = 0;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9')
+    {
+        result = result * 10 - (text[i] - '0');
+        if (result < std::numeric_limits<int>::min())
+        {
+            return false;
+        }
+        i++;
+    }
+
+    if (i == first || (!negative && -result > std::numeric_limits<int>::max()))
     {
-        dt.hour = std::stoi(values[0]);
-        dt.minute = std::stoi(values[1]);
-        dt.second = std::stoi(values[2]);
+        return false;
     }
 
+    value = static_cast<int>(negative ? result : -result);
     return true;
 }
 
 Root::Type COT_Utility::RootTypeCharToEnum(std::string& root)
 {
-         if (root == "a")   return Root::Type::a;
-    else if (root == "b")   return Root::Type::b;
-    else if (root == "t")   return Root::Type::t;
-    else if (root == "r")   return Root::Type::r;
-    else if (root == "c")   return Root::Type::c;
-    else if (root == "res") return Root::Type::res;
-    else return Root::Type::Error;
+    return Root::CodeToType(root);
 }
 
 Point::Type COT_Utility::PointTypeCharToEnum(std::string& type)
 {
-         if (type == "p") return Point::Type::p;
-    else if (type == "u") return Point::Type::u;
-    else if (type == "a") return Point::Type::a;
-    else if (type == "f") return Point::Type::f;
-    else if (type == "n") return Point::Type::n;
-    else if (type == "s") return Point::Type::s;
-    else if (type == "h") return Point::Type::h;
-    else if (type == "j") return Point::Type::j;
-    else if (type == "k") return Point::Type::k;
-    else if (type == "o") return Point::Type::o;
-    else if (type == "x") return Point::Type::x;
-    else return Point::Type::Error;
+    return Point::CodeToType(type);
 }
 
 Location::Type COT_Utility::LocationTypeCharToEnum(std::string& loc)
 {
-         if (loc == "P") return Location::Type::P;
-    else if (loc == "A") return Location::Type::A;
-    else if (loc == "G") return Location::Type::G;
-    else if (loc == "S") return Location::Type::S;
-    else if (loc == "U") return Location::Type::U;
-    else if (loc == "X") return Location::Type::X;
-    else return Location::Type::Error;
+    return Location::CodeToType(loc);
 }
 
 How::Entry::Type COT_Utility::HowEntryTypeCharToEnum(std::string& entry)
 {
-         if (entry == "h")   return How::Entry::Type::h;
-    else if (entry == "m")   return How::Entry::Type::m;
-    else return How::Entry::Type::Error;
+    return How::Entry::CodeToType(entry);
 }
 
 How::Data::Type COT_Utility::HowDataTypeCharToEnum(std::string& data, How::Entry::Type entry)
 {
-    if (entry == How::Entry::Type::h)
-    {
-             if (data == "e")   return How::Data::Type::e;
-        else if (data == "c")   return How::Data::Type::cal;
-        else if (data == "t")   return How::Data::Type::t;
-        else if (data == "p")   return How::Data::Type::paste;
-        else return How::Data::Type::Error;
-    }
-    else if (entry == How::Entry::Type::m)
-    {
-             if (data == "i")   return How::Data::Type::i;
-        else if (data == "g")   return How::Data::Type::g;
-        else if (data == "m")   return How::Data::Type::m;
-        else if (data == "s")   return How::Data::Type::s;
-        else if (data == "f")   return How::Data::Type::f;
-        else if (data == "c")   return How::Data::Type::con;
-        else if (data == "p")   return How::Data::Type::pred;
-        else if (data == "r")   return How::Data::Type::r;
-        else return How::Data::Type::Error;
-    }
-    else
-    {
-        return How::Data::Type::Error;
-    }
+    return How::Data::CodeToType(data, entry);
 }
\ No newline at end of file
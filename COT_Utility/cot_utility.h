@@ -10,15 +10,53 @@
 //  Include files:
 //          name                            reason included
 //          --------------------            ------------------------------------
+#include <cstdint>                          // uint32_t
 #include <iostream>                         // ostream
 #include <iomanip>                          // setw
 #include <unordered_map>                    // maps
 //
 #include "cot_info.h"                       // schemas
+#include "cot_peek.h"                       // Header peek filter
+#include "cot_validate.h"                   // Validation tiers
 #include "../PugiXML/pugixml.hpp"           // XML
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
+/// @brief Which parts of a message ParseCOT fills in. Parts left out are not
+///        copied or parsed at all and keep whatever the schema already held.
+namespace ParseOptions
+{
+    /// @brief Position of the first detail bit: options >> DetailShift has bit i
+    ///        set for entry i of Detail::Describe()
+    static const unsigned DetailShift = 3;
+
+    enum : uint32_t
+    {
+        EventCore           = 1u << 0,      /// version, uid, type and how, with their enums
+        Times               = 1u << 1,      /// time, start and stale
+        Point               = 1u << 2,      /// <point>
+        Takv                = 1u << 3,      /// Detail bits follow Detail::Describe() order, from DetailShift
+        Contact             = 1u << 4,
+        Uid                 = 1u << 5,
+        PrecisionLocation   = 1u << 6,
+        Group               = 1u << 7,
+        Status              = 1u << 8,
+        Track               = 1u << 9,
+        Link                = 1u << 10,
+        Remarks             = 1u << 11,
+        Emergency           = 1u << 12,
+        Chat                = 1u << 13,
+        Shape               = 1u << 14,
+
+        Detail              = Takv | Contact | Uid | PrecisionLocation | Group | Status | Track |
+                              Link | Remarks | Emergency | Chat | Shape,
+        All                 = EventCore | Times | Point | Detail,
+
+        MapDisplay          = EventCore | Times | Point,    /// Position, identity and staleness
+        Routing             = EventCore                     /// Type and uid only
+    };
+};
+
 class COT_Utility
 {
 public:
@@ -55,14 +93,30 @@ public:
     /// @brief Parse a COT Message from std::string
     /// @param buffer  - [in]  - String buffer containing the XML data to be parsed.
     /// @param cot     - [out] - Vector of COT Structures to store the parsed data into. 
+    /// @param options - [in/opt] - ParseOptions bits of the parts to fill in
     /// @return -1 on error, 1 on good parse.
-    int ParseCOT(std::string& buffer, COTSchema& cot);
+    int ParseCOT(std::string& buffer, COTSchema& cot, uint32_t options = ParseOptions::All);
 
     /// @brief Overloaded - Parse a COT Message from uint8_t buffer
     /// @param buffer  - [in]  - char buffer containing the XML data to be parsed.
     /// @param Targets - [out] - Vector of COT Structures to store the parsed data into. 
+    /// @param options - [in/opt] - ParseOptions bits of the parts to fill in
     /// @return -1 on error, 1 on good parse.
-    int ParseCOT(const char* buffer, COTSchema& cot);
+    int ParseCOT(const char* buffer, COTSchema& cot, uint32_t options = ParseOptions::All);
+
+    /// @brief Overloaded - Parse a COT Message only if a filter accepts its header.
+    ///        The header comes from Peek::PeekHeader(); a buffer with no <event>
+    ///        in the peek window, or whose header runs past it, is not judged
+    ///        and goes to the full parse.
+    /// @param buffer  - [in]  - String buffer containing the XML data to be parsed.
+    /// @param cot     - [out] - COT Structure to store the parsed data into, untouched if dropped.
+    /// @param accept  - [in]  - returns true to parse the message
+    /// @param options - [in/opt] - ParseOptions bits of the parts to fill in
+    /// @return -1 on error, 0 if the filter dropped it, 1 on good parse.
+    int ParseCOT(std::string& buffer, COTSchema& cot, const Peek::Filter& accept, uint32_t options = ParseOptions::All);
+
+    /// @brief Overloaded - Parse a COT Message from a char buffer if a filter accepts its header
+    int ParseCOT(const char* buffer, COTSchema& cot, const Peek::Filter& accept, uint32_t options = ParseOptions::All);
 
     /// @brief Parse a COT Message
     /// @param Buffer  - [in]  - char buffer containing the XML data to be parsed.
@@ -72,9 +126,23 @@ public:
     /// @brief Get a string containing the current version information
     std::string GetVersion();
 
+    /// @brief Choose the validation tiers ParseCOT runs
+    /// @param tiers - [in] - Validate bits, e.g. Validate::Trusted for internal links.
+    ///                       Validate::Legacy (the default) runs VerifyXML first.
+    void SetValidation(uint32_t tiers) { mValidation = tiers; }
+
+    /// @brief Validation tiers ParseCOT runs
+    uint32_t GetValidation() const { return mValidation; }
+
 protected:
 private:
 
+    /// @brief Benchmark and tooling builds reach the private sub-parsers through this
+    friend class COT_UtilityAccess;
+
+    /// @brief COTView::Materialize() decodes type, how and times with the same sub-parsers
+    friend class COTView;
+
     /// @brief Parse a string "type" attriubute
     /// @param type - [in]  - Type string to be parsed
     /// @param ind  - [out] - enumeration value for the PointType parsed from string.
@@ -91,7 +159,7 @@ private:
 
     /// @brief Parse a string "time" attriubute
     /// @param type - [in]  - Time string to be parsed
-    /// @param dt   - [out] - DateTime struct to store the parsed data into.
+    /// @param dt   - [out] - DateTime struct to store the parsed data into; reset when the parse fails
     /// @return true if parsed, false if not
     bool ParseTimeAttribute(std::string& type, DateTime& dt);
 
@@ -107,6 +175,14 @@ private:
     /// @return true if parsed, false if not
     bool ParseTimeStamp(std::string& type, DateTime& dt);
 
+    /// @brief Parse the leading integer of a string the way std::stoi does
+    ///        (leading spaces, optional sign, stops at the first non-digit)
+    ///        but without throwing on bad or out of range input.
+    /// @param text  - [in]  - string to be parsed
+    /// @param value - [out] - parsed value, untouched on failure
+    /// @return true if parsed, false if not
+    bool ParseInteger(const std::string& text, int& value);
+
     /// @brief Converts a string into a RootType enumeration value
     /// @param root - [in] - string to be converted.
     /// @return RootType enum conversion
@@ -133,6 +209,8 @@ private:
     /// @return RootType enum conversion
     How::Data::Type HowDataTypeCharToEnum(std::string& data, How::Entry::Type entry);
 
+    uint32_t mValidation = Validate::Legacy;    /// Tiers ParseCOT runs
+
     const int MAJOR = 0;
     const int MINOR = 2;
     const int BUILD = 0;
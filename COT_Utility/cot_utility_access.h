@@ -0,0 +1,46 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_utility_access.h
+// @brief           Exposes the private COT_Utility sub-parsers to benchmarks and
+//                  tooling builds. Not intended for application use.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include "cot_utility.h"                    // COT_Utility
+// 
+/////////////////////////////////////////////////////////////////////////////////
+
+class COT_UtilityAccess
+{
+public:
+
+    static bool ParseTypeAttribute(COT_Utility& c, std::string& type, Point::Type& ind, Location::Type& loc)
+    {
+        return c.ParseTypeAttribute(type, ind, loc);
+    }
+
+    static bool ParseHowAttribute(COT_Utility& c, std::string& type, How::Entry::Type& how, How::Data::Type& data)
+    {
+        return c.ParseHowAttribute(type, how, data);
+    }
+
+    static bool ParseTimeAttribute(COT_Utility& c, std::string& type, DateTime& dt)
+    {
+        return c.ParseTimeAttribute(type, dt);
+    }
+
+    static bool ParseDateStamp(COT_Utility& c, std::string& type, DateTime& dt)
+    {
+        return c.ParseDateStamp(type, dt);
+    }
+
+    static bool ParseTimeStamp(COT_Utility& c, std::string& type, DateTime& dt)
+    {
+        return c.ParseTimeStamp(type, dt);
+    }
+};
@@ -0,0 +1,446 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_validate.cpp
+// @brief           Implementation of the CoT validation tiers
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <charconv>                     // from_chars
+#include <cmath>                        // isnan
+#include <cstring>                      // strlen
+#include <string_view>                  // string_view
+#include <tuple>                        // tie
+//
+#include "cot_peek.h"                   // ParseTimestamp
+#include "cot_utility.h"                // ParseOptions
+#include "cot_validate.h"               // Validate header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Validate
+{
+    namespace
+    {
+        bool Fail(Issue& issue, uint32_t tier, const char* what, const char* field = "", size_t offset = 0)
+        {
+            issue.tier = tier;
+            issue.what = what;
+            issue.field = field;
+            issue.offset = offset;
+            return false;
+        }
+
+        bool IsSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        bool IsNameStart(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || static_cast<unsigned char>(c) >= 0x80;
+        }
+
+        bool IsNameChar(char c)
+        {
+            return IsNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+        }
+
+        /// @brief Length of the XML name at pos, 0 if there is none
+        size_t NameLength(std::string_view text, size_t pos)
+        {
+            if (pos >= text.size() || !IsNameStart(text[pos]))
+            {
+                return 0;
+            }
+            size_t end = pos + 1;
+            while (end < text.size() && IsNameChar(text[end])) { end++; }
+            return end - pos;
+        }
+
+        /// @brief The whole text is one number, as strtod would read it
+        bool IsNumber(const char* text)
+        {
+            const char* end = text + std::strlen(text);
+            if (text != end && *text == '+') { text++; }
+            double value = 0;
+            const std::from_chars_result r = std::from_chars(text, end, value);
+            return r.ec == std::errc() && r.ptr == end && text != end;
+        }
+
+        /// @brief One or more [A-Za-z0-9_] tokens separated by single dashes
+        bool IsDashTokens(const char* text, size_t minimum)
+        {
+            size_t tokens = 0, length = 0;
+            for (;; text++)
+            {
+                const char c = *text;
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+                {
+                    length++;
+                    continue;
+                }
+                if (length == 0 || (c != '-' && c != '\0'))
+                {
+                    return false;
+                }
+                tokens++;
+                length = 0;
+                if (c == '\0')
+                {
+                    return tokens >= minimum;
+                }
+            }
+        }
+
+        size_t CountChildren(const pugi::xml_node& node, const char* name)
+        {
+            size_t n = 0;
+            for (pugi::xml_node child = node.child(name); child; child = child.next_sibling(name)) { n++; }
+            return n;
+        }
+
+        bool IsCalendar(const DateTime& t)
+        {
+            return t.IsValid() && t.month >= 1 && t.month <= 12 && t.day >= 1 && t.day <= 31 && t.hour < 24 && t.minute < 60;
+        }
+
+        bool Before(const DateTime& a, const DateTime& b)
+        {
+            return std::tie(a.year, a.month, a.day, a.hour, a.minute, a.second) < std::tie(b.year, b.month, b.day, b.hour, b.minute, b.second);
+        }
+    };
+
+    bool CheckWellFormed(const char* data, size_t size, Issue& issue)
+    {
+        if (data == nullptr)
+        {
+            return Fail(issue, WellFormed, "no data");
+        }
+
+        const std::string_view text(data, size);
+        std::string_view open[MaxDepth];
+        size_t depth = 0;
+        bool root = false;
+        size_t pos = 0;
+
+        while (pos < size)
+        {
+            // Character data up to the next markup; only whitespace outside the root
+            size_t next = text.find('<', pos);
+            if (next == std::string_view::npos)
+            {
+                next = size;
+            }
+            if (depth == 0)
+            {
+                for (size_t i = pos; i < next; i++)
+                {
+                    if (!IsSpace(text[i]))
+                    {
+                        return Fail(issue, WellFormed, "text outside the root element", "", i);
+                    }
+                }
+            }
+            if (next == size)
+            {
+                break;
+            }
+            pos = next;
+
+            const std::string_view rest = text.substr(pos);
+            if (rest.compare(0, 2, "<?") == 0)
+            {
+                const size_t end = text.find("?>", pos + 2);
+                if (end == std::string_view::npos)
+                {
+                    return Fail(issue, WellFormed, "unterminated processing instruction", "", pos);
+                }
+                pos = end + 2;
+            }
+            else if (rest.compare(0, 4, "<!--") == 0)
+            {
+                const size_t end = text.find("-->", pos + 4);
+                if (end == std::string_view::npos)
+                {
+                    return Fail(issue, WellFormed, "unterminated comment", "", pos);
+                }
+                pos = end + 3;
+            }
+            else if (rest.compare(0, 9, "<![CDATA[") == 0)
+            {
+                const size_t end = text.find("]]>", pos + 9);
+                if (depth == 0 || end == std::string_view::npos)
+                {
+                    return Fail(issue, WellFormed, depth == 0 ? "CDATA outside the root element" : "unterminated CDATA", "", pos);
+                }
+                pos = end + 3;
+            }
+            else if (rest.compare(0, 2, "<!") == 0)
+            {
+                // DOCTYPE, possibly with an internal subset in brackets
+                if (depth != 0 || root)
+                {
+                    return Fail(issue, WellFormed, "misplaced declaration", "", pos);
+                }
+                int brackets = 0;
+                size_t i = pos + 2;
+                for (; i < size; i++)
+                {
+                    if (text[i] == '[') { brackets++; }
+                    else if (text[i] == ']') { brackets--; }
+                    else if (text[i] == '>' && brackets <= 0) { break; }
+                }
+                if (i >= size)
+                {
+                    return Fail(issue, WellFormed, "unterminated declaration", "", pos);
+                }
+                pos = i + 1;
+            }
+            else if (rest.compare(0, 2, "</") == 0)
+            {
+                const size_t length = NameLength(text, pos + 2);
+                const std::string_view name = text.substr(pos + 2, length);
+                size_t i = pos + 2 + length;
+                while (i < size && IsSpace(text[i])) { i++; }
+                if (length == 0 || i >= size || text[i] != '>')
+                {
+                    return Fail(issue, WellFormed, "bad end tag", "", pos);
+                }
+                if (depth == 0 || open[depth - 1] != name)
+                {
+                    return Fail(issue, WellFormed, "end tag does not match the open element", "", pos);
+                }
+                depth--;
+                pos = i + 1;
+            }
+            else
+            {
+                const size_t length = NameLength(text, pos + 1);
+                if (length == 0)
+                {
+                    return Fail(issue, WellFormed, "bad tag name", "", pos);
+                }
+                if (depth == 0 && root)
+                {
+                    return Fail(issue, WellFormed, "more than one root element", "", pos);
+                }
+
+                const std::string_view name = text.substr(pos + 1, length);
+                size_t i = pos + 1 + length;
+                bool closed = false;
+                for (;;)
+                {
+                    const size_t before = i;
+                    while (i < size && IsSpace(text[i])) { i++; }
+                    if (i >= size)
+                    {
+                        return Fail(issue, WellFormed, "unterminated start tag", "", pos);
+                    }
+                    if (text[i] == '>')
+                    {
+                        i++;
+                        break;
+                    }
+                    if (text.compare(i, 2, "/>") == 0)
+                    {
+                        i += 2;
+                        closed = true;
+                        break;
+                    }
+
+                    // name = "value", separated from what came before by whitespace
+                    const size_t attribute = NameLength(text, i);
+                    if (attribute == 0 || i == before)
+                    {
+                        return Fail(issue, WellFormed, "bad attribute", "", i);
+                    }
+                    i += attribute;
+                    while (i < size && IsSpace(text[i])) { i++; }
+                    if (i >= size || text[i] != '=')
+                    {
+                        return Fail(issue, WellFormed, "attribute without a value", "", i);
+                    }
+                    i++;
+                    while (i < size && IsSpace(text[i])) { i++; }
+                    if (i >= size || (text[i] != '"' && text[i] != '\''))
+                    {
+                        return Fail(issue, WellFormed, "unquoted attribute value", "", i);
+                    }
+                    const size_t end = text.find(text[i], i + 1);
+                    if (end == std::string_view::npos)
+                    {
+                        return Fail(issue, WellFormed, "unterminated attribute value", "", i);
+                    }
+                    const size_t lt = text.find('<', i + 1);
+                    if (lt < end)
+                    {
+                        return Fail(issue, WellFormed, "'<' in attribute value", "", lt);
+                    }
+                    i = end + 1;
+                }
+
+                root = true;
+                if (!closed)
+                {
+                    if (depth == MaxDepth)
+                    {
+                        return Fail(issue, WellFormed, "elements nested too deep", "", pos);
+                    }
+                    open[depth++] = name;
+                }
+                pos = i;
+            }
+        }
+
+        if (depth != 0)
+        {
+            return Fail(issue, WellFormed, "unclosed element", "", size);
+        }
+        if (!root)
+        {
+            return Fail(issue, WellFormed, "no root element", "", size);
+        }
+        return true;
+    }
+
+    bool CheckWellFormed(const std::string& buffer, Issue& issue)
+    {
+        return CheckWellFormed(buffer.data(), buffer.size(), issue);
+    }
+
+    bool CheckStrict(const pugi::xml_document& doc, Issue& issue)
+    {
+        size_t roots = 0;
+        for (pugi::xml_node n = doc.first_child(); n; n = n.next_sibling())
+        {
+            roots += (n.type() == pugi::node_element) ? 1 : 0;
+        }
+        const pugi::xml_node event = doc.document_element();
+        if (roots != 1 || std::strcmp(event.name(), "event") != 0)
+        {
+            return Fail(issue, Strict, "root element is not a single <event>");
+        }
+
+        static const char* const kEventAttributes[] = { "version", "uid", "type", "time", "start", "stale", "how" };
+        for (const char* name : kEventAttributes)
+        {
+            if (!event.attribute(name))
+            {
+                return Fail(issue, Strict, "missing event attribute", name);
+            }
+        }
+        if (!IsNumber(event.attribute("version").value()))
+        {
+            return Fail(issue, Strict, "not a number", "version");
+        }
+        if (event.attribute("uid").value()[0] == '\0')
+        {
+            return Fail(issue, Strict, "empty", "uid");
+        }
+        if (!IsDashTokens(event.attribute("type").value(), 1))
+        {
+            return Fail(issue, Strict, "not dash separated tokens", "type");
+        }
+        if (!IsDashTokens(event.attribute("how").value(), 2))
+        {
+            return Fail(issue, Strict, "not dash separated tokens", "how");
+        }
+        for (const char* name : { "time", "start", "stale" })
+        {
+            DateTime t;
+            if (!Peek::ParseTimestamp(event.attribute(name).value(), t))
+            {
+                return Fail(issue, Strict, "not a YYYY-MM-DDTHH:MM:SS[.f]Z timestamp", name);
+            }
+        }
+
+        if (CountChildren(event, "point") != 1)
+        {
+            return Fail(issue, Strict, "not exactly one <point>");
+        }
+        const pugi::xml_node point = event.child("point");
+        for (const char* name : { "lat", "lon", "hae", "ce", "le" })
+        {
+            const pugi::xml_attribute attr = point.attribute(name);
+            if (!attr)
+            {
+                return Fail(issue, Strict, "missing point attribute", name);
+            }
+            if (!IsNumber(attr.value()))
+            {
+                return Fail(issue, Strict, "not a number", name);
+            }
+        }
+
+        if (CountChildren(event, "detail") > 1)
+        {
+            return Fail(issue, Strict, "more than one <detail>");
+        }
+        return true;
+    }
+
+    bool CheckSemantic(const COTSchema& cot, Issue& issue, uint32_t options)
+    {
+        const Event& e = cot.event;
+        if (options & ParseOptions::EventCore)
+        {
+            if (!(e.version > 0))
+            {
+                return Fail(issue, Semantic, "version not positive", "version");
+            }
+            if (e.uid.empty())
+            {
+                return Fail(issue, Semantic, "empty", "uid");
+            }
+            if (e.how.empty())
+            {
+                return Fail(issue, Semantic, "empty", "how");
+            }
+
+            // Root::Type, plus the TAK user drawn shapes ("u-d-...")
+            const std::string_view root = std::string_view(e.type).substr(0, e.type.find('-'));
+            if (Root::CodeToType(root) == Root::Type::Error && root != "u")
+            {
+                return Fail(issue, Semantic, "unknown type root", "type");
+            }
+        }
+
+        if (options & ParseOptions::Times)
+        {
+            if (!IsCalendar(e.time))    { return Fail(issue, Semantic, "not a calendar time", "time"); }
+            if (!IsCalendar(e.start))   { return Fail(issue, Semantic, "not a calendar time", "start"); }
+            if (!IsCalendar(e.stale))   { return Fail(issue, Semantic, "not a calendar time", "stale"); }
+            if (!Before(e.time, e.stale))
+            {
+                return Fail(issue, Semantic, "stale is not after time", "stale");
+            }
+        }
+
+        if (options & ParseOptions::Point)
+        {
+            const Point::Data& p = cot.point;
+            if (!(p.latitude >= -90.0 && p.latitude <= 90.0))
+            {
+                return Fail(issue, Semantic, "outside [-90, 90]", "lat");
+            }
+            if (!(p.longitude >= -180.0 && p.longitude <= 180.0))
+            {
+                return Fail(issue, Semantic, "outside [-180, 180]", "lon");
+            }
+            if (p.circularError < 0)
+            {
+                return Fail(issue, Semantic, "negative", "ce");
+            }
+            if (p.linearError < 0)
+            {
+                return Fail(issue, Semantic, "negative", "le");
+            }
+        }
+        return true;
+    }
+};
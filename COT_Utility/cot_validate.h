@@ -0,0 +1,85 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_validate.h
+// @brief           Validation tiers for received CoT, from cheapest to dearest.
+//
+//                  WellFormed  - one pass over the bytes checking tags nest and
+//                                attributes are quoted, without building a tree
+//                  Document    - VerifyXML, a full pugixml parse (the original
+//                                ParseCOT behaviour)
+//                  Strict      - the parsed document has the CoT event shape:
+//                                required attributes present, numbers and
+//                                timestamps in their exact formats
+//                  Semantic    - the parsed values make sense: lat/lon in range,
+//                                stale after time, known type root
+//
+//                  Each tier is a bit; COT_Utility::SetValidation() picks the
+//                  tiers ParseCOT runs, and each check can be called on its own.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint32_t
+#include <string>                           // string
+//
+#include "cot_info.h"                       // COTSchema
+#include "../PugiXML/pugixml.hpp"           // xml_document
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Validate
+{
+    enum : uint32_t
+    {
+        WellFormed  = 1u << 0,
+        Document    = 1u << 1,
+        Strict      = 1u << 2,
+        Semantic    = 1u << 3,
+
+        Trusted     = 0,                                /// Only what ParseCOT needs to read the message
+        Legacy      = Document,                         /// As ParseCOT always did, the default
+        Untrusted   = WellFormed | Strict | Semantic    /// Every check; Document adds nothing to these
+    };
+
+    /// @brief Why a check failed. The strings are static; 'offset' is the byte
+    ///        position for WellFormed and 0 for the other tiers.
+    struct Issue
+    {
+        uint32_t    tier;           /// Tier bit that failed
+        const char* what;           /// Description
+        const char* field;          /// Attribute concerned, or ""
+        size_t      offset;
+
+        /// @brief Constructor - Initializes Everything
+        Issue() : tier(0), what(""), field(""), offset(0) {}
+    };
+
+    /// @brief Deepest element nesting CheckWellFormed() accepts
+    static const size_t MaxDepth = 64;
+
+    /// @brief Tags balance and match, attributes are name="value" or name='value'
+    ///        with no '<' inside, comments, PIs and CDATA are closed, and there is
+    ///        exactly one root element. Entities are not checked. No allocation.
+    bool CheckWellFormed(const char* data, size_t size, Issue& issue);
+
+    /// @brief Overloaded - Check a string
+    bool CheckWellFormed(const std::string& buffer, Issue& issue);
+
+    /// @brief The document is one <event> with version, uid, type, time, start,
+    ///        stale and how, exactly one <point> with lat, lon, hae, ce and le, and
+    ///        at most one <detail>. Numbers must parse in full, timestamps must be
+    ///        "YYYY-MM-DDTHH:MM:SS[.f]Z", type and how dash separated tokens.
+    bool CheckStrict(const pugi::xml_document& doc, Issue& issue);
+
+    /// @brief Values of a parsed schema are usable: uid, type and how set, type
+    ///        root known (a Root::Type, or "u" for TAK drawings), times valid
+    ///        with stale after time, lat in [-90, 90], lon in [-180, 180], ce
+    ///        and le not negative. Only the parts in the ParseOptions mask are
+    ///        checked.
+    bool CheckSemantic(const COTSchema& cot, Issue& issue, uint32_t options = ~0u);
+};
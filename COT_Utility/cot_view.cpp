@@ -0,0 +1,646 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_view.cpp
+// @brief           Implementation of the zero-copy message view
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstdint>                      // uint8_t, uint32_t
+//
+#include "cot_format.h"                 // ReadReal
+#include "cot_shape.h"                  // Vertices::Extract
+#include "cot_trace.h"                  // Trace points
+#include "cot_utility.h"                // COT_Utility, ParseOptions
+#include "cot_validate.h"               // CheckWellFormed, MaxDepth
+#include "cot_view.h"                   // COTView header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const size_t npos = std::string_view::npos;
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool IsBlank(std::string_view text)
+    {
+        for (char c : text)
+        {
+            if (!IsSpace(c)) { return false; }
+        }
+        return true;
+    }
+
+    /// @brief Next name="value" pair in the attribute part of a start tag
+    /// @return false once the tag has no more pairs
+    bool NextAttribute(std::string_view tag, size_t& pos, std::string_view& name, std::string_view& value)
+    {
+        while (pos < tag.size())
+        {
+            while (pos < tag.size() && IsSpace(tag[pos])) { pos++; }
+            const size_t nameStart = pos;
+            while (pos < tag.size() && tag[pos] != '=' && !IsSpace(tag[pos])) { pos++; }
+            name = tag.substr(nameStart, pos - nameStart);
+            while (pos < tag.size() && IsSpace(tag[pos])) { pos++; }
+            if (pos >= tag.size() || tag[pos] != '=')
+            {
+                continue;
+            }
+            pos++;
+            while (pos < tag.size() && IsSpace(tag[pos])) { pos++; }
+            if (pos >= tag.size() || (tag[pos] != '"' && tag[pos] != '\''))
+            {
+                continue;
+            }
+            const size_t close = tag.find(tag[pos], pos + 1);
+            if (close == npos)
+            {
+                return false;
+            }
+            value = tag.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief True if the start tag has the attribute, whatever its value
+    bool HasAttribute(std::string_view tag, std::string_view wanted)
+    {
+        size_t pos = 0;
+        std::string_view name, value;
+        while (NextAttribute(tag, pos, name, value))
+        {
+            if (name == wanted) { return true; }
+        }
+        return false;
+    }
+
+    /// @brief End of a start tag from pos, past the '>', honouring quotes
+    size_t TagEnd(std::string_view text, size_t pos)
+    {
+        for (;;)
+        {
+            pos = text.find_first_of("\"'>", pos);
+            if (pos == npos || text[pos] == '>')
+            {
+                return pos == npos ? npos : pos + 1;
+            }
+            pos = text.find(text[pos], pos + 1);
+            if (pos == npos)
+            {
+                return npos;
+            }
+            pos++;
+        }
+    }
+
+    /// @brief The XML names of T's attributes, in table order
+    template <class T>
+    const std::array<std::string_view, Fields::AttributeCount<T>()>& AttributeNames()
+    {
+        static const std::array<std::string_view, Fields::AttributeCount<T>()> names = []
+        {
+            std::array<std::string_view, Fields::AttributeCount<T>()> n{};
+            size_t index = 0;
+            Fields::ForEach<T>([&](const auto& d)
+            {
+                using D = std::decay_t<decltype(d)>;
+                if constexpr (!Fields::IsChild<D>::value && !Fields::IsContent<D>::value)
+                {
+                    n[index++] = d.xml;
+                }
+            });
+            return n;
+        }();
+        return names;
+    }
+
+    /// @brief Fill the first value of each table attribute, as pugixml finds it
+    template <class T>
+    void ReadAttributes(std::string_view tag, ElementView<T>& view)
+    {
+        const auto& names = AttributeNames<T>();
+        size_t pos = 0;
+        std::string_view name, value;
+        while (NextAttribute(tag, pos, name, value))
+        {
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                if (view.attributes[i].data() == nullptr && names[i] == name)
+                {
+                    view.attributes[i] = value;
+                    break;
+                }
+            }
+        }
+    }
+
+    /// @brief How an open element is read
+    struct Frame;
+    struct Handler
+    {
+        /// @brief A child start tag; sets 'child' to the frame its content goes to
+        void (*open)(void* view, std::string_view name, std::string_view tag, bool empty, Frame& child);
+
+        /// @brief Text or CDATA content, null if the element has none in its table
+        void (*text)(void* view, std::string_view text, bool cdata);
+    };
+
+    enum class Kind : uint8_t { Ignore, Event, Detail, Element };
+
+    struct Frame
+    {
+        Kind            kind = Kind::Ignore;
+        void*           view = nullptr;
+        const Handler*  handler = nullptr;
+        size_t          start = 0;      /// Offset of the start tag
+    };
+
+    /// @brief An element the table matched. Link takes only a <link> with no
+    ///        point; Shape only notes that a <link> was there.
+    template <class C>
+    bool Accept(const ElementView<C>&, std::string_view)
+    {
+        return true;
+    }
+
+    bool Accept(const ElementView<Link>&, std::string_view tag)
+    {
+        return !HasAttribute(tag, "point");
+    }
+
+    template <class C>
+    const Handler* Attach(ElementView<C>& view, std::string_view tag);
+
+    const Handler* Attach(ElementView<Shape>&, std::string_view)
+    {
+        return nullptr;
+    }
+
+    template <class T>
+    void Open(void* view, std::string_view name, std::string_view tag, bool empty, Frame& child)
+    {
+        ElementView<T>& v = *static_cast<ElementView<T>*>(view);
+        bool taken = false;
+        Fields::ForEach<T>([&](const auto& d)
+        {
+            using D = std::decay_t<decltype(d)>;
+            if constexpr (Fields::IsChild<D>::value)
+            {
+                using C = std::decay_t<decltype(std::declval<T&>().*d.member)>;
+                ElementView<C>& sub = std::get<ElementView<C>>(v.children);
+
+                // The first child of each kind, as pugixml's child() finds it
+                if (!sub.present && name == C::Element && Accept(sub, tag))
+                {
+                    sub.present = true;
+                    const Handler* handler = Attach(sub, tag);
+                    if (!taken && !empty && handler != nullptr)
+                    {
+                        child.kind = Kind::Element;
+                        child.view = &sub;
+                        child.handler = handler;
+                        taken = true;
+                    }
+                }
+            }
+        });
+    }
+
+    template <class T>
+    void SetText(void* view, std::string_view text, bool cdata)
+    {
+        ElementView<T>& v = *static_cast<ElementView<T>*>(view);
+        if (v.text.data() == nullptr)
+        {
+            v.text = text;
+            v.cdata = cdata;
+        }
+    }
+
+    template <class T>
+    constexpr bool HasContent()
+    {
+        bool content = false;
+        std::apply([&content](const auto&... d) { ((content = content || Fields::IsContent<std::decay_t<decltype(d)>>::value), ...); }, T::Describe());
+        return content;
+    }
+
+    template <class T>
+    const Handler kHandler = { &Open<T>, HasContent<T>() ? &SetText<T> : nullptr };
+
+    template <class C>
+    const Handler* Attach(ElementView<C>& view, std::string_view tag)
+    {
+        ReadAttributes(tag, view);
+        return &kHandler<C>;
+    }
+
+    /// @brief Fold one <detail> into the merged view: a nested element the
+    ///        later one lacks is kept if required and dropped if an Extension
+    void Merge(ElementView<Detail>& into, const ElementView<Detail>& from)
+    {
+        into.present = true;
+        Fields::ForEach<Detail>([&](const auto& d)
+        {
+            using C = std::decay_t<decltype(std::declval<Detail&>().*d.member)>;
+            const ElementView<C>& sub = std::get<ElementView<C>>(from.children);
+            if (sub.present || !d.required)
+            {
+                std::get<ElementView<C>>(into.children) = sub;
+            }
+        });
+    }
+
+    void AppendUtf8(std::string& out, uint32_t ch)
+    {
+        // As pugixml writes a character reference, including out of range ones
+        if (ch < 0x80)
+        {
+            out += static_cast<char>(ch);
+        }
+        else if (ch < 0x800)
+        {
+            out += static_cast<char>(static_cast<uint8_t>(0xC0 | (ch >> 6)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | (ch & 0x3F)));
+        }
+        else if (ch < 0x10000)
+        {
+            out += static_cast<char>(static_cast<uint8_t>(0xE0 | (ch >> 12)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3F)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | (ch & 0x3F)));
+        }
+        else
+        {
+            out += static_cast<char>(static_cast<uint8_t>(0xF0 | (ch >> 18)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | ((ch >> 12) & 0x3F)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3F)));
+            out += static_cast<char>(static_cast<uint8_t>(0x80 | (ch & 0x3F)));
+        }
+    }
+
+    /// @brief Decode the entity at raw[i] == '&'
+    /// @return index after it, or i + 1 with '&' appended when it is not one
+    size_t DecodeEntity(std::string_view raw, size_t i, std::string& out)
+    {
+        size_t j = i + 1;
+        if (j < raw.size() && raw[j] == '#')
+        {
+            const bool hex = (j + 1 < raw.size() && raw[j + 1] == 'x');
+            j += hex ? 2 : 1;
+            const size_t first = j;
+            uint32_t code = 0;
+            for (; j < raw.size(); j++)
+            {
+                const char c = raw[j];
+                if (c >= '0' && c <= '9') { code = code * (hex ? 16 : 10) + static_cast<uint32_t>(c - '0'); }
+                else if (hex && (c | ' ') >= 'a' && (c | ' ') <= 'f') { code = code * 16 + static_cast<uint32_t>((c | ' ') - 'a' + 10); }
+                else { break; }
+            }
+            if (j > first && j < raw.size() && raw[j] == ';')
+            {
+                AppendUtf8(out, code);
+                return j + 1;
+            }
+        }
+        else
+        {
+            static const struct { std::string_view name; char c; } kNamed[] =
+            {
+                { "amp;", '&' }, { "apos;", '\'' }, { "gt;", '>' }, { "lt;", '<' }, { "quot;", '"' }
+            };
+            for (const auto& e : kNamed)
+            {
+                if (raw.compare(j, e.name.size(), e.name) == 0)
+                {
+                    out += e.c;
+                    return j + e.name.size();
+                }
+            }
+        }
+
+        // Not a reference: kept as written
+        out += '&';
+        return i + 1;
+    }
+};
+
+namespace ViewImpl
+{
+    void Decode(std::string_view raw, Source source, std::string& out)
+    {
+        // Nearly every value needs nothing done
+        size_t i = 0;
+        for (; i < raw.size(); i++)
+        {
+            const char c = raw[i];
+            if (c == '\r' || (c == '&' && source != Source::CData) || (source == Source::Attribute && (c == '\t' || c == '\n')))
+            {
+                break;
+            }
+        }
+        out.assign(raw.data(), i);
+
+        while (i < raw.size())
+        {
+            const char c = raw[i];
+            if (c == '&' && source != Source::CData)
+            {
+                i = DecodeEntity(raw, i, out);
+                continue;
+            }
+            if (c == '\r')
+            {
+                out += (source == Source::Attribute) ? ' ' : '\n';
+                i += (i + 1 < raw.size() && raw[i + 1] == '\n') ? 2 : 1;
+                continue;
+            }
+            out += (source == Source::Attribute && (c == '\t' || c == '\n')) ? ' ' : c;
+            i++;
+        }
+
+        // "&#0;" ends the value, as it does a C string
+        const size_t nul = out.find('\0');
+        if (nul != std::string::npos)
+        {
+            out.resize(nul);
+        }
+    }
+
+    double ReadReal(std::string_view raw)
+    {
+        double value = 0;
+        if (raw.find('&') == npos)
+        {
+            Format::ReadReal(raw.data(), raw.data() + raw.size(), value);
+            return value;
+        }
+        std::string decoded;
+        Decode(raw, Source::Attribute, decoded);
+        Format::ReadReal(decoded.c_str(), value);
+        return value;
+    }
+};
+
+void ElementView<Shape>::Materialize(Shape& out) const
+{
+    if (!present)
+    {
+        out.Clear();
+        return;
+    }
+
+    Vertices::Extract(detail.data(), detail.size(), out);
+    if (out.strokeColor.find_first_of("&\t\n\r") != std::string::npos)
+    {
+        const std::string raw = out.strokeColor;
+        ViewImpl::Decode(raw, ViewImpl::Source::Attribute, out.strokeColor);
+    }
+    if (out.fillColor.find_first_of("&\t\n\r") != std::string::npos)
+    {
+        const std::string raw = out.fillColor;
+        ViewImpl::Decode(raw, ViewImpl::Source::Attribute, out.fillColor);
+    }
+}
+
+int COTView::Parse(const char* data, size_t size, bool checkWellFormed)
+{
+    COT_TRACE_SCOPE(view, "COTView::Parse");
+
+    event = EventView();
+    point = ElementView<Point::Data>();
+    detail = ElementView<Detail>();
+    if (data == nullptr)
+    {
+        return -1;
+    }
+
+    // pugixml reads the buffer as a C string
+    std::string_view text(data, size);
+    text = text.substr(0, text.find('\0'));
+    const size_t declaration = text.find("<?xml");
+    if (declaration == npos)
+    {
+        return -1;
+    }
+    text.remove_prefix(declaration);
+
+    Validate::Issue issue;
+    if (checkWellFormed && !Validate::CheckWellFormed(text.data(), text.size(), issue))
+    {
+        return -1;
+    }
+
+    // Frames for the open elements; deeper than MaxDepth is never read
+    Frame frames[Validate::MaxDepth + 1];
+    const Frame ignored;
+    size_t depth = 0;
+    size_t events = 0, points = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t next = text.find('<', pos);
+        if (next == npos)
+        {
+            next = text.size();
+        }
+
+        // Character data; pugixml drops it when it is all white space
+        const Frame& top = depth <= Validate::MaxDepth ? frames[depth] : ignored;
+        if (next > pos && top.handler != nullptr && top.handler->text != nullptr)
+        {
+            const std::string_view chars = text.substr(pos, next - pos);
+            if (!IsBlank(chars))
+            {
+                top.handler->text(top.view, chars, false);
+            }
+        }
+        if (next == text.size())
+        {
+            break;
+        }
+        pos = next;
+
+        const std::string_view rest = text.substr(pos);
+        if (rest.compare(0, 2, "<?") == 0)
+        {
+            const size_t end = text.find("?>", pos + 2);
+            if (end == npos) { return -1; }
+            pos = end + 2;
+        }
+        else if (rest.compare(0, 4, "<!--") == 0)
+        {
+            const size_t end = text.find("-->", pos + 4);
+            if (end == npos) { return -1; }
+            pos = end + 3;
+        }
+        else if (rest.compare(0, 9, "<![CDATA[") == 0)
+        {
+            const size_t end = text.find("]]>", pos + 9);
+            if (end == npos || depth == 0) { return -1; }
+            if (top.handler != nullptr && top.handler->text != nullptr)
+            {
+                top.handler->text(top.view, text.substr(pos + 9, end - pos - 9), true);
+            }
+            pos = end + 3;
+        }
+        else if (rest.compare(0, 2, "<!") == 0)
+        {
+            // DOCTYPE, possibly with an internal subset in brackets
+            int brackets = 0;
+            size_t i = pos + 2;
+            for (; i < text.size(); i++)
+            {
+                if (text[i] == '[') { brackets++; }
+                else if (text[i] == ']') { brackets--; }
+                else if (text[i] == '>' && brackets <= 0) { break; }
+            }
+            if (i >= text.size()) { return -1; }
+            pos = i + 1;
+        }
+        else if (rest.compare(0, 2, "</") == 0)
+        {
+            const size_t end = text.find('>', pos + 2);
+            if (end == npos || depth == 0) { return -1; }
+            if (depth <= Validate::MaxDepth && frames[depth].kind == Kind::Detail)
+            {
+                std::get<ElementView<Shape>>(mCurrent.children).detail = text.substr(frames[depth].start, end + 1 - frames[depth].start);
+                Merge(detail, mCurrent);
+            }
+            depth--;
+            pos = end + 1;
+        }
+        else
+        {
+            size_t nameEnd = pos + 1;
+            while (nameEnd < text.size() && !IsSpace(text[nameEnd]) && text[nameEnd] != '>' && text[nameEnd] != '/') { nameEnd++; }
+            const size_t end = TagEnd(text, nameEnd);
+            if (end == npos || nameEnd == pos + 1) { return -1; }
+
+            const std::string_view name = text.substr(pos + 1, nameEnd - pos - 1);
+            const bool empty = text[end - 2] == '/';
+            const std::string_view tag = text.substr(nameEnd, end - (empty ? 2 : 1) - nameEnd);
+
+            Frame child;
+            child.start = pos;
+            if (depth == 0)
+            {
+                if (name == "event" && ++events == 1)
+                {
+                    child.kind = Kind::Event;
+                    size_t at = 0;
+                    std::string_view attribute, value;
+                    while (NextAttribute(tag, at, attribute, value))
+                    {
+                        std::string_view* slot =
+                            attribute == "version" ? &event.version : attribute == "type" ? &event.type :
+                            attribute == "uid" ? &event.uid : attribute == "time" ? &event.time :
+                            attribute == "start" ? &event.start : attribute == "stale" ? &event.stale :
+                            attribute == "how" ? &event.how : nullptr;
+                        if (slot != nullptr && slot->data() == nullptr)
+                        {
+                            *slot = value;
+                        }
+                    }
+                }
+            }
+            else if (depth <= Validate::MaxDepth && frames[depth].kind == Kind::Event)
+            {
+                if (name == Point::Data::Element && ++points == 1)
+                {
+                    point.present = true;
+                    ReadAttributes(tag, point);
+                }
+                else if (name == Detail::Element)
+                {
+                    mCurrent = ElementView<Detail>();
+                    child.kind = Kind::Detail;
+                    child.view = &mCurrent;
+                    child.handler = &kHandler<Detail>;
+                    if (empty)
+                    {
+                        Merge(detail, mCurrent);
+                    }
+                }
+            }
+            else if (depth <= Validate::MaxDepth && frames[depth].handler != nullptr)
+            {
+                frames[depth].handler->open(frames[depth].view, name, tag, empty, child);
+            }
+
+            if (!empty)
+            {
+                depth++;
+                if (depth <= Validate::MaxDepth)
+                {
+                    frames[depth] = child;
+                }
+            }
+            pos = end;
+        }
+    }
+
+    if (depth != 0 || events != 1 || points != 1)
+    {
+        return -1;
+    }
+    return 1;
+}
+
+int COTView::Parse(const std::string& buffer, bool checkWellFormed)
+{
+    return Parse(buffer.data(), buffer.size(), checkWellFormed);
+}
+
+COTSchema COTView::Materialize(uint32_t options) const
+{
+    COTSchema cot;
+    Materialize(cot, options);
+    return cot;
+}
+
+void COTView::Materialize(COTSchema& out, uint32_t options) const
+{
+    COT_TRACE_SCOPE(materialize, "COTView::Materialize");
+
+    COT_Utility parser;
+    if (options & ParseOptions::EventCore)
+    {
+        out.event.version = event.Version();
+        Decode(event.type, out.event.type);
+        parser.ParseTypeAttribute(out.event.type, out.event.indicator, out.event.location);
+        Decode(event.uid, out.event.uid);
+        Decode(event.how, out.event.how);
+        parser.ParseHowAttribute(out.event.how, out.event.howEntry, out.event.howData);
+    }
+
+    if (options & ParseOptions::Times)
+    {
+        std::string time;
+        Decode(event.time, time);
+        parser.ParseTimeAttribute(time, out.event.time);
+        Decode(event.start, time);
+        parser.ParseTimeAttribute(time, out.event.start);
+        Decode(event.stale, time);
+        parser.ParseTimeAttribute(time, out.event.stale);
+    }
+
+    if (options & ParseOptions::Point)
+    {
+        point.Materialize(out.point);
+    }
+
+    if ((options & ParseOptions::Detail) && detail.present)
+    {
+        detail.Materialize(out.detail, options >> ParseOptions::DetailShift);
+    }
+}
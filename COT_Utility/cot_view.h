@@ -0,0 +1,265 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_view.h
+// @brief           Zero-copy view of a CoT message.
+//
+//                  COTView holds the same logical fields as COTSchema, but every
+//                  value is a std::string_view into the received buffer and
+//                  numbers are decoded only when asked for. One pass over the
+//                  bytes fills it, with no DOM and no allocation, so routing and
+//                  filtering can run on the raw message. Materialize() builds
+//                  an owning COTSchema, equal to what ParseCOT reads, when one
+//                  is needed.
+//
+//                  The views are the raw bytes between the quotes or tags:
+//                  entities are not decoded and line ends are not converted.
+//                  Decode() does that, and Materialize() uses it. A view is
+//                  valid as long as the buffer it was parsed from.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <array>                            // array
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint32_t
+#include <string>                           // string
+#include <string_view>                      // string_view
+#include <tuple>                            // tuple, get
+#include <type_traits>                      // decay_t, is_same
+//
+#include "cot_fields.h"                     // Field tables
+#include "cot_info.h"                       // COTSchema
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+template <class T> class ElementView;
+
+namespace ViewImpl
+{
+    /// @brief What a raw view holds, which decides how it is decoded
+    enum class Source
+    {
+        Attribute,      /// Entities, tab, CR and LF to a space, CR LF to one space
+        Text,           /// Entities, CR LF and CR to LF
+        CData           /// CR LF and CR to LF
+    };
+
+    /// @brief Decode raw bytes as pugixml does with its default options,
+    ///        replacing 'out'
+    void Decode(std::string_view raw, Source source, std::string& out);
+
+    /// @brief Read an attribute real as ParseCOT does: missing or not a number is 0
+    double ReadReal(std::string_view raw);
+
+    /// @brief A tuple of ElementView<C> for every nested element in a field table
+    template <class... Tuples> struct Concat;
+    template <> struct Concat<> { using type = std::tuple<>; };
+    template <class... A> struct Concat<std::tuple<A...>> { using type = std::tuple<A...>; };
+    template <class... A, class... B, class... Rest>
+    struct Concat<std::tuple<A...>, std::tuple<B...>, Rest...> : Concat<std::tuple<A..., B...>, Rest...> {};
+
+    template <class D> struct ChildView { using type = std::tuple<>; };
+    template <class T, class C> struct ChildView<Fields::Child<T, C>> { using type = std::tuple<ElementView<C>>; };
+
+    template <class Table> struct ChildViews;
+    template <class... D> struct ChildViews<std::tuple<D...>> { using type = typename Concat<typename ChildView<D>::type...>::type; };
+
+    /// @brief Member pointers of different types never match
+    template <class A, class B>
+    bool Same(A a, B b)
+    {
+        if constexpr (std::is_same<A, B>::value)
+        {
+            return a == b;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    /// @brief Position of an attribute in T's table, AttributeCount<T>() if not found
+    template <class T, class M>
+    size_t AttributeIndex(M T::* member)
+    {
+        size_t index = 0, found = Fields::AttributeCount<T>();
+        Fields::ForEach<T>([&](const auto& d)
+        {
+            using D = std::decay_t<decltype(d)>;
+            if constexpr (!Fields::IsChild<D>::value && !Fields::IsContent<D>::value)
+            {
+                found = Same(d.member, member) ? index : found;
+                index++;
+            }
+        });
+        return found;
+    }
+};
+
+/// @brief Shapes are read by Vertices::Extract from the <detail> that holds them
+template <>
+class ElementView<Shape>
+{
+public:
+    bool                present = false;    /// The <detail> has a <link> child
+    std::string_view    detail;             /// The whole <detail> element
+
+    /// @brief Replace 'out' with the vertices and style, as ParseCOT reads them.
+    ///        Entities in the link points are not decoded.
+    void Materialize(Shape& out) const;
+};
+
+/// @brief Raw view of one sub-schema element, laid out by its field table
+template <class T>
+class ElementView
+{
+public:
+    using Children = typename ViewImpl::ChildViews<decltype(T::Describe())>::type;
+    static constexpr size_t Attributes = Fields::AttributeCount<T>();
+
+    bool                                        present = false;    /// The element was in the message
+    std::array<std::string_view, Attributes>    attributes{};       /// Raw values in table order, data() null when missing
+    std::string_view                            text;               /// Raw first text or CDATA child, data() null when none
+    bool                                        cdata = false;      /// 'text' came from a CDATA section
+    Children                                    children;           /// Nested elements in table order
+
+    /// @brief Raw value of a text attribute or the text content
+    std::string_view Get(std::string T::* member) const
+    {
+        const size_t index = ViewImpl::AttributeIndex(member);
+        return index < Attributes ? attributes[index] : text;
+    }
+
+    /// @brief Decode a real attribute now, as ParseCOT does: missing is 0
+    double Get(double T::* member) const
+    {
+        const size_t index = ViewImpl::AttributeIndex(member);
+        return index < Attributes ? ViewImpl::ReadReal(attributes[index]) : 0;
+    }
+
+    /// @brief View of a nested element
+    template <class C>
+    const ElementView<C>& Get(C T::*) const
+    {
+        return std::get<ElementView<C>>(children);
+    }
+
+    /// @brief Decode every field into 'out' as ParseCOT does: a missing
+    ///        attribute is empty or 0, a missing nested element is left alone,
+    ///        or reset when the table lists it as an Extension.
+    /// @param childMask - [in/opt] - bit n set fills the n'th nested element
+    void Materialize(T& out, uint32_t childMask = ~0u) const
+    {
+        size_t index = 0;
+        unsigned child = 0;
+        Fields::ForEach<T>([&](const auto& d)
+        {
+            using D = std::decay_t<decltype(d)>;
+            if constexpr (Fields::IsChild<D>::value)
+            {
+                using C = std::decay_t<decltype(out.*d.member)>;
+                const ElementView<C>& view = std::get<ElementView<C>>(children);
+                if ((childMask >> child++) & 1u)
+                {
+                    if (view.present)
+                    {
+                        view.Materialize(out.*d.member);
+                    }
+                    else if (!d.required)
+                    {
+                        Reset(out.*d.member);
+                    }
+                }
+            }
+            else if constexpr (Fields::IsContent<D>::value)
+            {
+                ViewImpl::Decode(text, cdata ? ViewImpl::Source::CData : ViewImpl::Source::Text, out.*d.member);
+            }
+            else if constexpr (std::is_same<decltype(out.*d.member), double&>::value)
+            {
+                out.*d.member = ViewImpl::ReadReal(attributes[index++]);
+            }
+            else
+            {
+                ViewImpl::Decode(attributes[index++], ViewImpl::Source::Attribute, out.*d.member);
+            }
+        });
+    }
+
+private:
+    template <class C>
+    static void Reset(C& out)
+    {
+        out = C();
+    }
+
+    static void Reset(Shape& out)
+    {
+        out.Clear();
+    }
+};
+
+/// @brief Raw view of the <event> attributes
+struct EventView
+{
+    std::string_view version;
+    std::string_view type;
+    std::string_view uid;
+    std::string_view time;
+    std::string_view start;
+    std::string_view stale;
+    std::string_view how;
+
+    /// @brief 'type' starts with prefix, e.g. "a-f-"
+    bool TypeStartsWith(std::string_view prefix) const
+    {
+        return type.substr(0, prefix.size()) == prefix;
+    }
+
+    /// @brief Decode the version now, as ParseCOT does: missing is 0
+    double Version() const
+    {
+        return ViewImpl::ReadReal(version);
+    }
+};
+
+class COTView
+{
+public:
+    EventView                   event;
+    ElementView<Point::Data>    point;
+    ElementView<Detail>         detail;     /// Merged over every <detail>, as ParseCOT reads them
+
+    /// @brief View a message. As ParseCOT, anything before "<?xml" is skipped,
+    ///        the root must be one <event> and it must have exactly one <point>.
+    ///        The buffer is read up to its first NUL, as pugixml does.
+    /// @param checkWellFormed - [in/opt] - run Validate::CheckWellFormed() first.
+    ///                          Without it the scan still ends safely on broken
+    ///                          input but may accept what pugixml would not.
+    /// @return -1 on error, 1 on good parse, as ParseCOT
+    int Parse(const char* data, size_t size, bool checkWellFormed = true);
+
+    /// @brief Overloaded - View a string, which must outlive the view
+    int Parse(const std::string& buffer, bool checkWellFormed = true);
+
+    /// @brief An owning schema with the parts in the ParseOptions mask filled in
+    COTSchema Materialize(uint32_t options = ~0u) const;
+
+    /// @brief Overloaded - Fill the parts in the ParseOptions mask into 'out' as
+    ///        ParseCOT would; the rest, and the detail when the message had none,
+    ///        keep what 'out' held
+    void Materialize(COTSchema& out, uint32_t options = ~0u) const;
+
+    /// @brief Decode a raw attribute view, e.g. event.uid, into 'out'
+    static void Decode(std::string_view raw, std::string& out)
+    {
+        ViewImpl::Decode(raw, ViewImpl::Source::Attribute, out);
+    }
+
+private:
+    ElementView<Detail>         mCurrent;   /// The <detail> being read
+};
@@ -0,0 +1,480 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_zip.cpp
+// @brief           Implementation of the streaming zip writer and deflater
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // min, fill
+#include <cstddef>                      // ptrdiff_t
+#include <utility>                      // move
+//
+#include "cot_format.h"                 // UtcNow
+#include "cot_zip.h"                    // Zip header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Zip
+{
+    namespace
+    {
+        const size_t kWindow = 32768;
+        const uint32_t kWindowMask = kWindow - 1;
+        const size_t kMinMatch = 3;
+        const size_t kMaxMatch = 258;
+        const size_t kNiceMatch = 64;       /// Stop searching at a match this long
+        const size_t kMaxInsert = 32;       /// Longer matches are not hashed inside
+        const unsigned kHashBits = 15;
+        const uint32_t kLimit = 0xFFFFFFFFu;
+
+        /// @brief CRC-32 tables for slicing by 8: table k advances a byte k places
+        struct CrcTables
+        {
+            uint32_t t[8][256];
+
+            constexpr CrcTables() : t{}
+            {
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++)
+                    {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    t[0][i] = c;
+                }
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    for (int k = 1; k < 8; k++)
+                    {
+                        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+                    }
+                }
+            }
+        };
+
+        constexpr CrcTables kCrc;
+
+        /// @brief A fixed Huffman code, bits already reversed for LSB first output
+        struct Code
+        {
+            uint16_t bits;
+            uint8_t  length;
+        };
+
+        constexpr uint16_t Reverse(uint16_t code, unsigned length)
+        {
+            uint16_t r = 0;
+            for (unsigned i = 0; i < length; i++)
+            {
+                r = static_cast<uint16_t>((r << 1) | ((code >> i) & 1));
+            }
+            return r;
+        }
+
+        /// @brief Literal / length codes of the fixed block (RFC 1951 3.2.6)
+        struct LiteralCodes
+        {
+            Code c[288];
+
+            constexpr LiteralCodes() : c{}
+            {
+                for (unsigned s = 0; s < 288; s++)
+                {
+                    const unsigned length = s < 144 ? 8 : (s < 256 ? 9 : (s < 280 ? 7 : 8));
+                    const unsigned code = s < 144 ? 0x30 + s : (s < 256 ? 0x190 + (s - 144) : (s < 280 ? s - 256 : 0xC0 + (s - 280)));
+                    c[s] = Code{ Reverse(static_cast<uint16_t>(code), length), static_cast<uint8_t>(length) };
+                }
+            }
+        };
+
+        constexpr LiteralCodes kLiteral;
+
+        /// @brief Highest set bit
+        constexpr unsigned Log2(uint32_t v)
+        {
+            unsigned n = 0;
+            while (v >>= 1) { n++; }
+            return n;
+        }
+    };
+
+    uint32_t Crc32(uint32_t crc, const char* data, size_t size)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        crc = ~crc;
+        while (size >= 8)
+        {
+            const uint32_t lo = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+            crc = kCrc.t[7][lo & 0xFF] ^ kCrc.t[6][(lo >> 8) & 0xFF] ^ kCrc.t[5][(lo >> 16) & 0xFF] ^ kCrc.t[4][lo >> 24] ^
+                kCrc.t[3][p[4]] ^ kCrc.t[2][p[5]] ^ kCrc.t[1][p[6]] ^ kCrc.t[0][p[7]];
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+        {
+            crc = kCrc.t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Deflater
+    /////////////////////////////////////////////////////////////////////////////
+
+    Deflater::Deflater(int chain)
+        : mHead(size_t(1) << kHashBits), mPrev(kWindow), mChain(chain < 1 ? 1 : chain)
+    {
+        Reset();
+    }
+
+    void Deflater::Reset()
+    {
+        mWindow.clear();
+        mBase = 0;
+        mPos = 0;
+        std::fill(mHead.begin(), mHead.end(), 0u);
+        mBits = 0;
+        mBitCount = 0;
+        mStarted = false;
+    }
+
+    uint32_t Deflater::Hash(size_t offset) const
+    {
+        const uint8_t* p = mWindow.data() + offset;
+        const uint32_t v = (static_cast<uint32_t>(p[0]) << 16) | (p[1] << 8) | p[2];
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    void Deflater::Insert(uint32_t position)
+    {
+        const uint32_t h = Hash(position - mBase);
+        mPrev[position & kWindowMask] = mHead[h];
+        mHead[h] = position + 1;
+    }
+
+    void Deflater::Write(const char* data, size_t size, std::string& out)
+    {
+        // A window at a time, so the buffer stays small whatever 'size' is
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        while (size > 0)
+        {
+            const size_t n = std::min(size, kWindow);
+            mWindow.insert(mWindow.end(), p, p + n);
+            p += n;
+            size -= n;
+            Compress(kMaxMatch, out);
+
+            // Keep one window of history behind mPos
+            const size_t behind = mPos - mBase;
+            if (behind > 2 * kWindow)
+            {
+                const size_t drop = behind - kWindow;
+                mWindow.erase(mWindow.begin(), mWindow.begin() + static_cast<std::ptrdiff_t>(drop));
+                mBase += static_cast<uint32_t>(drop);
+            }
+        }
+    }
+
+    void Deflater::Finish(std::string& out)
+    {
+        Compress(0, out);
+        PutBits(kLiteral.c[256].bits, kLiteral.c[256].length, out);
+        while (mBitCount > 0)
+        {
+            out += static_cast<char>(mBits);
+            mBits >>= 8;
+            mBitCount = mBitCount > 8 ? mBitCount - 8 : 0;
+        }
+        Reset();
+    }
+
+    void Deflater::Compress(size_t keep, std::string& out)
+    {
+        if (!mStarted)
+        {
+            // The whole stream is one final block with the fixed codes
+            PutBits(3, 3, out);
+            mStarted = true;
+        }
+
+        const uint32_t end = mBase + static_cast<uint32_t>(mWindow.size());
+        const uint8_t* window = mWindow.data();
+        while (end - mPos > keep)
+        {
+            const size_t available = end - mPos;
+            const uint8_t* p = window + (mPos - mBase);
+            size_t best = 0;
+            uint32_t distance = 0;
+
+            if (available >= kMinMatch)
+            {
+                const size_t most = std::min(available, kMaxMatch);
+                const uint32_t h = Hash(mPos - mBase);
+                uint32_t candidate = mHead[h];
+                mPrev[mPos & kWindowMask] = candidate;
+                mHead[h] = mPos + 1;
+
+                best = kMinMatch - 1;
+                for (int tries = mChain; candidate != 0 && tries > 0; tries--)
+                {
+                    const uint32_t c = candidate - 1;
+                    if (mPos - c > kWindow)
+                    {
+                        break;
+                    }
+                    const uint8_t* q = window + (c - mBase);
+                    if (q[best] == p[best] && q[0] == p[0] && q[1] == p[1])
+                    {
+                        size_t length = 2;
+                        while (length < most && q[length] == p[length]) { length++; }
+                        if (length > best)
+                        {
+                            best = length;
+                            distance = mPos - c;
+                            if (length >= std::min(most, kNiceMatch))
+                            {
+                                break;
+                            }
+                        }
+                    }
+                    const uint32_t next = mPrev[c & kWindowMask];
+                    if (next >= candidate)
+                    {
+                        break;
+                    }
+                    candidate = next;
+                }
+            }
+
+            if (distance == 0)
+            {
+                PutBits(kLiteral.c[*p].bits, kLiteral.c[*p].length, out);
+                mPos++;
+                continue;
+            }
+
+            // Length symbol 257..285 and its extra bits
+            const uint32_t l = static_cast<uint32_t>(best - kMinMatch);
+            if (best == kMaxMatch)
+            {
+                PutBits(kLiteral.c[285].bits, kLiteral.c[285].length, out);
+            }
+            else if (l < 8)
+            {
+                PutBits(kLiteral.c[257 + l].bits, kLiteral.c[257 + l].length, out);
+            }
+            else
+            {
+                const unsigned n = Log2(l);
+                const unsigned step = (l >> (n - 2)) & 3;
+                const unsigned symbol = 257 + 4 * (n - 1) + step;
+                PutBits(kLiteral.c[symbol].bits, kLiteral.c[symbol].length, out);
+                PutBits(l - ((4 | step) << (n - 2)), n - 2, out);
+            }
+
+            // Distance code 0..29, five bits each, and its extra bits
+            const uint32_t d = distance - 1;
+            if (d < 4)
+            {
+                PutBits(Reverse(static_cast<uint16_t>(d), 5), 5, out);
+            }
+            else
+            {
+                const unsigned n = Log2(d);
+                const unsigned half = (d >> (n - 1)) & 1;
+                PutBits(Reverse(static_cast<uint16_t>(2 * n + half), 5), 5, out);
+                PutBits(d - ((2 | half) << (n - 1)), n - 1, out);
+            }
+
+            // Hash the positions inside a short match so later matches can start
+            // in them; a long one is usually a repeat whose inside adds nothing
+            const uint32_t stop = mPos + static_cast<uint32_t>(best);
+            if (best <= kMaxInsert)
+            {
+                for (uint32_t q = mPos + 1; q < stop && end - q >= kMinMatch; q++)
+                {
+                    Insert(q);
+                }
+            }
+            mPos = stop;
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Writer
+    /////////////////////////////////////////////////////////////////////////////
+
+    Writer::Writer(Sink sink, size_t flushBytes)
+        : mSink(std::move(sink)), mFlushBytes(flushBytes), mFlushed(0), mEntryStart(0), mOpen(false), mFinished(false)
+    {
+        mBuffer.reserve(mFlushBytes + 4096);
+
+        const Format::Civil now = Format::UtcNow();
+        const unsigned year = now.year < 1980 ? 1980 : now.year;
+        mTime = static_cast<uint16_t>((now.hour << 11) | (now.minute << 5) | (static_cast<unsigned>(now.second) / 2));
+        mDate = static_cast<uint16_t>(((year - 1980) << 9) | (now.month << 5) | now.day);
+    }
+
+    Writer::~Writer() = default;
+
+    void Writer::Put16(uint16_t value)
+    {
+        const char bytes[2] = { static_cast<char>(value), static_cast<char>(value >> 8) };
+        mBuffer.append(bytes, sizeof(bytes));
+    }
+
+    void Writer::Put32(uint32_t value)
+    {
+        const char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8),
+            static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+        mBuffer.append(bytes, sizeof(bytes));
+    }
+
+    void Writer::Begin(const std::string& name, Method method)
+    {
+        if (mFinished)
+        {
+            return;
+        }
+        End();
+
+        mEntries.push_back(Entry{ name, method, 0, 0, 0, Offset() });
+
+        // Local header. Flag bit 3: CRC and sizes follow the data; bit 11: UTF-8 name.
+        Put32(0x04034b50);
+        Put16(20);
+        Put16(0x0808);
+        Put16(static_cast<uint16_t>(method));
+        Put16(mTime);
+        Put16(mDate);
+        Put32(0);
+        Put32(0);
+        Put32(0);
+        Put16(static_cast<uint16_t>(name.size()));
+        Put16(0);
+        mBuffer += name;
+
+        if (method == Method::Deflate && !mDeflater)
+        {
+            mDeflater.reset(new Deflater());
+        }
+        mEntryStart = Offset();
+        mOpen = true;
+    }
+
+    void Writer::Write(const char* data, size_t size)
+    {
+        if (!mOpen)
+        {
+            return;
+        }
+
+        Entry& e = mEntries.back();
+        e.crc = Crc32(e.crc, data, size);
+        e.size += size;
+        if (e.method == Method::Deflate)
+        {
+            mDeflater->Write(data, size, mBuffer);
+        }
+        else
+        {
+            mBuffer.append(data, size);
+        }
+
+        if (mBuffer.size() >= mFlushBytes)
+        {
+            Flush();
+        }
+    }
+
+    void Writer::End()
+    {
+        if (!mOpen)
+        {
+            return;
+        }
+
+        Entry& e = mEntries.back();
+        if (e.method == Method::Deflate)
+        {
+            mDeflater->Finish(mBuffer);
+        }
+        e.compressed = Offset() - mEntryStart;
+
+        Put32(0x08074b50);
+        Put32(e.crc);
+        Put32(static_cast<uint32_t>(e.compressed));
+        Put32(static_cast<uint32_t>(e.size));
+        mOpen = false;
+    }
+
+    bool Writer::Finish()
+    {
+        if (mFinished)
+        {
+            return false;
+        }
+        End();
+
+        bool fits = mEntries.size() < 0xFFFF;
+        const uint64_t directory = Offset();
+        for (const Entry& e : mEntries)
+        {
+            fits = fits && e.compressed < kLimit && e.size < kLimit && e.offset < kLimit;
+
+            Put32(0x02014b50);
+            Put16(20);
+            Put16(20);
+            Put16(0x0808);
+            Put16(static_cast<uint16_t>(e.method));
+            Put16(mTime);
+            Put16(mDate);
+            Put32(e.crc);
+            Put32(static_cast<uint32_t>(e.compressed));
+            Put32(static_cast<uint32_t>(e.size));
+            Put16(static_cast<uint16_t>(e.name.size()));
+            Put16(0);
+            Put16(0);
+            Put16(0);
+            Put16(0);
+            Put32(0);
+            Put32(static_cast<uint32_t>(e.offset));
+            mBuffer += e.name;
+            if (mBuffer.size() >= mFlushBytes)
+            {
+                Flush();
+            }
+        }
+        const uint64_t size = Offset() - directory;
+        fits = fits && directory < kLimit && size < kLimit;
+
+        Put32(0x06054b50);
+        Put16(0);
+        Put16(0);
+        Put16(static_cast<uint16_t>(mEntries.size()));
+        Put16(static_cast<uint16_t>(mEntries.size()));
+        Put32(static_cast<uint32_t>(size));
+        Put32(static_cast<uint32_t>(directory));
+        Put16(0);
+        Flush();
+
+        mFinished = true;
+        return fits;
+    }
+
+    void Writer::Flush()
+    {
+        if (!mBuffer.empty())
+        {
+            mSink(mBuffer.data(), mBuffer.size());
+            mFlushed += mBuffer.size();
+            mBuffer.clear();
+        }
+    }
+};
@@ -0,0 +1,154 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_zip.h
+// @brief           Streaming zip archive writer, for KMZ export.
+//
+//                  Entries are stored or deflated as they are written and the
+//                  archive goes to a sink in chunks, so memory stays bounded
+//                  whatever the entry size. Sizes and CRC follow each entry in
+//                  a data descriptor, so nothing is seeked back or buffered.
+//
+//                  The deflater is a single fixed Huffman block over greedy
+//                  LZ77 matches in a 32 KiB window: no dynamic trees, so it
+//                  compresses less than zlib but needs no library. Archives
+//                  are plain zip (no ZIP64), so an entry or the archive must
+//                  stay under 4 GiB.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstddef>                          // size_t
+#include <cstdint>                          // uint8_t, uint32_t, uint64_t
+#include <functional>                       // function
+#include <memory>                           // unique_ptr
+#include <string>                           // string
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Zip
+{
+    /// @brief Continue a CRC-32 (the zip and gzip polynomial) over more bytes.
+    ///        Start from 0.
+    uint32_t Crc32(uint32_t crc, const char* data, size_t size);
+
+    /// @brief Raw deflate (RFC 1951) compressor, fed in pieces
+    class Deflater
+    {
+    public:
+        /// @brief Constructor - Initializes Everything
+        /// @param chain - [in/opt] - candidates tried per match; more is smaller and slower
+        explicit Deflater(int chain = 16);
+
+        /// @brief Compress more input, appending whatever output is ready to 'out'.
+        ///        Up to 258 bytes are held back until more input or Finish().
+        void Write(const char* data, size_t size, std::string& out);
+
+        /// @brief Compress the rest and end the stream. The deflater is reset
+        ///        for a new stream.
+        void Finish(std::string& out);
+
+    private:
+        /// @brief Encode from mPos while 'keep' bytes of lookahead remain
+        void Compress(size_t keep, std::string& out);
+
+        /// @brief Add 'count' bits, least significant first
+        void PutBits(uint32_t bits, unsigned count, std::string& out)
+        {
+            mBits |= static_cast<uint64_t>(bits) << mBitCount;
+            mBitCount += count;
+            if (mBitCount >= 32)
+            {
+                const char word[4] = { static_cast<char>(mBits), static_cast<char>(mBits >> 8),
+                    static_cast<char>(mBits >> 16), static_cast<char>(mBits >> 24) };
+                out.append(word, sizeof(word));
+                mBits >>= 32;
+                mBitCount -= 32;
+            }
+        }
+
+        /// @brief Hash slot of the three bytes at a window offset
+        uint32_t Hash(size_t offset) const;
+
+        /// @brief Put an absolute position at the head of its hash chain
+        void Insert(uint32_t position);
+
+        void Reset();
+
+        std::vector<uint8_t>    mWindow;        /// Input from absolute position mBase
+        uint32_t                mBase;
+        uint32_t                mPos;           /// Next absolute position to encode
+        std::vector<uint32_t>   mHead;          /// Latest position + 1 by hash, 0 if none
+        std::vector<uint32_t>   mPrev;          /// Previous position + 1 with the same hash
+        uint64_t                mBits;
+        unsigned                mBitCount;
+        int                     mChain;
+        bool                    mStarted;       /// Block header written
+    };
+
+    /// @brief Writes a zip archive to a sink. Not thread safe.
+    class Writer
+    {
+    public:
+        enum class Method : uint16_t
+        {
+            Stored = 0,
+            Deflate = 8
+        };
+
+        /// @brief Receives each chunk of the archive, in order
+        using Sink = std::function<void(const char* data, size_t size)>;
+
+        /// @brief Constructor - Initializes Everything
+        /// @param flushBytes - [in/opt] - buffered output that triggers a flush
+        explicit Writer(Sink sink, size_t flushBytes = 64 * 1024);
+        ~Writer();
+
+        /// @brief Start an entry, ending the one before
+        void Begin(const std::string& name, Method method);
+
+        /// @brief Add bytes to the current entry
+        void Write(const char* data, size_t size);
+
+        /// @brief End the last entry, write the central directory and flush.
+        ///        Nothing can be written after.
+        /// @return false if an entry or the archive reached 4 GiB, which needs
+        ///         ZIP64; the archive is then not readable
+        bool Finish();
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            Method      method;
+            uint32_t    crc;
+            uint64_t    compressed;
+            uint64_t    size;
+            uint64_t    offset;             /// Of the local header
+        };
+
+        /// @brief Archive bytes so far, flushed or buffered
+        uint64_t Offset() const { return mFlushed + mBuffer.size(); }
+
+        void End();
+        void Flush();
+        void Put16(uint16_t value);
+        void Put32(uint32_t value);
+
+        Sink                        mSink;
+        size_t                      mFlushBytes;
+        std::string                 mBuffer;
+        std::vector<Entry>          mEntries;
+        std::unique_ptr<Deflater>   mDeflater;
+        uint64_t                    mFlushed;       /// Archive bytes passed to the sink
+        uint64_t                    mEntryStart;    /// Archive offset of the entry data
+        bool                        mOpen;          /// An entry is being written
+        bool                        mFinished;
+        uint16_t                    mTime;          /// MS-DOS time and date of the entries
+        uint16_t                    mDate;
+    };
+};
@@ -1,6 +1,7 @@
 
 #include <iostream>
 #include "COT_Utility/cot_utility.h"
+#include "COT_Utility/cot_template.h"
 
 int main()
 {
@@ -52,6 +53,14 @@ int main()
     std::string out = c.GenerateXMLCOTMessage(cot3);
     std::cout << out;
 
+    // EXAMPLE: How to send repeated reports of one entity from a precompiled template.
+    // Only the position, times, uid, track and battery change between renders.
+    std::cout << "\n\n";
+    COTTemplate report(cot3);
+    cot3.point.latitude += 0.001;
+    report.Render(cot3, out);
+    std::cout << out;
+
 
     // EXAMPLE: How to append an 'ack' status to a received message. 
     std::cout << "\n\n";
@@ -0,0 +1,373 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            fuzz_driver.cpp
+// @brief           Standalone main() for the fuzz targets when libFuzzer is not
+//                  available (e.g. GCC builds). Replays files and directories
+//                  through LLVMFuzzerTestOneInput and can run a simple seeded
+//                  mutation loop over them, reporting execs/s and MB/s.
+//                  Not coverage guided; use the libFuzzer build for that.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // min
+#include <chrono>                       // steady_clock
+#include <csignal>                      // signal
+#include <cstdint>                      // uint8_t
+#include <cstdio>                       // printf
+#include <cstdlib>                      // strtoull, _Exit
+#include <cstring>                      // memcpy
+#include <exception>                    // set_terminate
+#include <filesystem>                   // directory_iterator
+#include <fstream>                      // ifstream
+#include <iostream>                     // cerr
+#include <sstream>                      // stringstream
+#include <string>                       // string
+#include <vector>                       // vector
+#ifndef _WIN32
+#include <fcntl.h>                      // open
+#include <unistd.h>                     // write, close
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+#if defined(__GNUC__) || defined(__clang__)
+extern "C" void __sanitizer_set_death_callback(void (*callback)(void)) __attribute__((weak));
+#endif
+
+namespace
+{
+    /// @brief Input being executed, written out if the process dies on it
+    std::vector<uint8_t> gCurrent;
+    std::string gArtifact = "fuzz-crash.bin";
+
+    /// @brief Async-signal-safe dump of the current input
+    void SaveCurrent()
+    {
+#ifndef _WIN32
+        int fd = open(gArtifact.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            if (!gCurrent.empty()) { (void)!write(fd, gCurrent.data(), gCurrent.size()); }
+            close(fd);
+        }
+        const char msg[] = "\n==fuzz_driver== crashing input written to the artifact file\n";
+        (void)!write(2, msg, sizeof(msg) - 1);
+#endif
+    }
+
+    void OnSignal(int sig)
+    {
+        SaveCurrent();
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+    }
+
+    void OnTerminate()
+    {
+        SaveCurrent();
+        try
+        {
+            if (std::current_exception()) { std::rethrow_exception(std::current_exception()); }
+        }
+        catch (const std::exception& e)
+        {
+            std::fprintf(stderr, "==fuzz_driver== uncaught exception: %s\n", e.what());
+        }
+        catch (...)
+        {
+            std::fprintf(stderr, "==fuzz_driver== uncaught exception\n");
+        }
+        std::abort();
+    }
+
+    /// @brief splitmix64, small and good enough to drive mutations
+    struct Random
+    {
+        uint64_t state;
+        explicit Random(uint64_t seed) : state(seed) {}
+        uint64_t Next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+        size_t Below(size_t n) { return n ? static_cast<size_t>(Next() % n) : 0; }
+    };
+
+    using Input = std::vector<uint8_t>;
+
+    bool ReadFile(const std::string& path, Input& out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) { return false; }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        const std::string s = ss.str();
+        out.assign(s.begin(), s.end());
+        return true;
+    }
+
+    /// @brief Load a libFuzzer dictionary: one "token" per line, \xNN and \\ \" escapes
+    bool ReadDictionary(const std::string& path, std::vector<Input>& tokens)
+    {
+        std::ifstream in(path);
+        if (!in) { return false; }
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            const size_t open = line.find('"');
+            const size_t close = line.rfind('"');
+            if (line.empty() || line[0] == '#' || open == std::string::npos || close <= open)
+            {
+                continue;
+            }
+
+            Input token;
+            for (size_t i = open + 1; i < close; i++)
+            {
+                if (line[i] == '\\' && i + 1 < close)
+                {
+                    if (line[i + 1] == 'x' && i + 3 < close)
+                    {
+                        token.push_back(static_cast<uint8_t>(std::strtoul(line.substr(i + 2, 2).c_str(), nullptr, 16)));
+                        i += 3;
+                    }
+                    else
+                    {
+                        token.push_back(static_cast<uint8_t>(line[++i]));
+                    }
+                }
+                else
+                {
+                    token.push_back(static_cast<uint8_t>(line[i]));
+                }
+            }
+            tokens.push_back(token);
+        }
+        return true;
+    }
+
+    /// @brief Apply one to four random edits
+    void Mutate(Input& in, const std::vector<Input>& seeds, const std::vector<Input>& dict, Random& rng, size_t maxLen)
+    {
+        const size_t edits = 1 + rng.Below(4);
+        for (size_t e = 0; e < edits; e++)
+        {
+            switch (rng.Below(8))
+            {
+            case 0:     // flip a bit
+                if (!in.empty()) { in[rng.Below(in.size())] ^= static_cast<uint8_t>(1u << rng.Below(8)); }
+                break;
+            case 1:     // replace a byte with a boundary value
+            {
+                static const uint8_t kInteresting[] = { 0, 0xFF, 0x7F, 0x80, '-', 'T', ':', '<', '>', '"', '=', '/', '9', '.' };
+                if (!in.empty()) { in[rng.Below(in.size())] = kInteresting[rng.Below(sizeof(kInteresting))]; }
+                break;
+            }
+            case 2:     // insert random bytes
+            {
+                const size_t n = 1 + rng.Below(8);
+                const size_t at = rng.Below(in.size() + 1);
+                for (size_t i = 0; i < n; i++) { in.insert(in.begin() + at, static_cast<uint8_t>(rng.Next())); }
+                break;
+            }
+            case 3:     // erase a range
+                if (!in.empty())
+                {
+                    const size_t at = rng.Below(in.size());
+                    const size_t n = 1 + rng.Below(std::min<size_t>(in.size() - at, 32));
+                    in.erase(in.begin() + at, in.begin() + at + n);
+                }
+                break;
+            case 4:     // duplicate a range
+                if (!in.empty())
+                {
+                    const size_t at = rng.Below(in.size());
+                    const size_t n = 1 + rng.Below(std::min<size_t>(in.size() - at, 64));
+                    Input copy(in.begin() + at, in.begin() + at + n);
+                    in.insert(in.begin() + rng.Below(in.size() + 1), copy.begin(), copy.end());
+                }
+                break;
+            case 5:     // splice a piece of another seed
+                if (!seeds.empty())
+                {
+                    const Input& other = seeds[rng.Below(seeds.size())];
+                    if (!other.empty())
+                    {
+                        const size_t at = rng.Below(other.size());
+                        const size_t n = 1 + rng.Below(std::min<size_t>(other.size() - at, 64));
+                        in.insert(in.begin() + rng.Below(in.size() + 1), other.begin() + at, other.begin() + at + n);
+                    }
+                }
+                break;
+            case 6:     // truncate
+                if (!in.empty()) { in.resize(rng.Below(in.size())); }
+                break;
+            default:    // insert a dictionary token
+                if (!dict.empty())
+                {
+                    const Input& token = dict[rng.Below(dict.size())];
+                    in.insert(in.begin() + rng.Below(in.size() + 1), token.begin(), token.end());
+                }
+                break;
+            }
+        }
+
+        if (in.size() > maxLen) { in.resize(maxLen); }
+    }
+
+    void Usage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " [options] [file|dir ...]\n"
+            "  Replays every input, then runs --runs mutated inputs derived from them.\n"
+            "  --runs=N          mutated executions after the replay (default 0)\n"
+            "  --time=S          stop mutating after S seconds (default unlimited)\n"
+            "  --seed=N          mutation PRNG seed (default 1)\n"
+            "  --max-len=N       largest mutated input in bytes (default 4096)\n"
+            "  --dict=PATH       libFuzzer style dictionary of tokens to splice in\n"
+            "  --artifact=PATH   where a crashing input is written (default fuzz-crash.bin)\n"
+            "  --report=S        seconds between progress lines (default 5)\n";
+    }
+};
+
+int main(int argc, char** argv)
+{
+    uint64_t runs = 0;
+    uint64_t seed = 1;
+    size_t maxLen = 4096;
+    double maxSeconds = 0;
+    double reportSeconds = 5;
+    std::string dictPath;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            paths.push_back(arg);
+            continue;
+        }
+
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+             if (key == "--runs")       runs = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--time")       maxSeconds = std::strtod(value.c_str(), nullptr);
+        else if (key == "--seed")       seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--max-len")    maxLen = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--dict")       dictPath = value;
+        else if (key == "--artifact")   gArtifact = value;
+        else if (key == "--report")     reportSeconds = std::strtod(value.c_str(), nullptr);
+        else
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Input> seeds;
+    for (const std::string& path : paths)
+    {
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec))
+        {
+            for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+            {
+                Input in;
+                if (entry.is_regular_file() && ReadFile(entry.path().string(), in)) { seeds.push_back(in); }
+            }
+        }
+        else
+        {
+            Input in;
+            if (!ReadFile(path, in))
+            {
+                std::cerr << "ERROR: Could not read " << path << "\n";
+                return 2;
+            }
+            seeds.push_back(in);
+        }
+    }
+
+    std::vector<Input> dict;
+    if (!dictPath.empty() && !ReadDictionary(dictPath, dict))
+    {
+        std::cerr << "ERROR: Could not read dictionary " << dictPath << "\n";
+        return 2;
+    }
+
+    std::signal(SIGSEGV, OnSignal);
+    std::signal(SIGABRT, OnSignal);
+    std::signal(SIGFPE, OnSignal);
+    std::signal(SIGILL, OnSignal);
+#ifdef SIGBUS
+    std::signal(SIGBUS, OnSignal);
+#endif
+    std::set_terminate(OnTerminate);
+#if defined(__GNUC__) || defined(__clang__)
+    // Sanitizer reports end the process without raising a signal
+    if (__sanitizer_set_death_callback) { __sanitizer_set_death_callback(SaveCurrent); }
+#endif
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point lastReport = start;
+    uint64_t execs = 0;
+    uint64_t bytes = 0;
+
+    auto Execute = [&](const Input& in)
+    {
+        gCurrent = in;
+        LLVMFuzzerTestOneInput(gCurrent.data(), gCurrent.size());
+        execs++;
+        bytes += in.size();
+    };
+
+    auto Report = [&](const char* stage)
+    {
+        const double s = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("%-8s execs: %-10llu %10.0f exec/s %8.2f MB/s  elapsed %.1fs\n", stage,
+            static_cast<unsigned long long>(execs), s > 0 ? execs / s : 0.0, s > 0 ? bytes / s / 1e6 : 0.0, s);
+        std::fflush(stdout);
+    };
+
+    // Replay
+    for (const Input& in : seeds) { Execute(in); }
+    Report("replay");
+
+    // Mutate
+    Random rng(seed);
+    Input in;
+    for (uint64_t r = 0; r < runs; r++)
+    {
+        in = seeds.empty() ? Input() : seeds[rng.Below(seeds.size())];
+        Mutate(in, seeds, dict, rng, maxLen);
+        Execute(in);
+
+        if ((r & 1023) == 0)
+        {
+            const Clock::time_point now = Clock::now();
+            if (maxSeconds > 0 && std::chrono::duration<double>(now - start).count() >= maxSeconds)
+            {
+                break;
+            }
+            if (reportSeconds > 0 && std::chrono::duration<double>(now - lastReport).count() >= reportSeconds)
+            {
+                Report("fuzz");
+                lastReport = now;
+            }
+        }
+    }
+
+    if (runs > 0) { Report("done"); }
+    return 0;
+}
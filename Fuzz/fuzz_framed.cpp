@@ -0,0 +1,36 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            fuzz_framed.cpp
+// @brief           Fuzz target: the length-prefixed framed stream decoder used
+//                  by the corpus and load tools, feeding each frame to ParseCOT
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstddef>                      // size_t
+#include <cstdint>                      // uint8_t
+#include <string>                       // string
+#include <vector>                       // vector
+//
+#include "cot_corpus.h"                 // DecodeFramed
+#include "cot_utility.h"                // COT_Utility
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    const std::string bytes(reinterpret_cast<const char*>(data), size);
+    std::vector<std::string> frames;
+    Corpus::DecodeFramed(bytes, frames);
+
+    COT_Utility c;
+    for (std::string& frame : frames)
+    {
+        COTSchema cot;
+        c.ParseCOT(frame, cot);
+    }
+    return 0;
+}
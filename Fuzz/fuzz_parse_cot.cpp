@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            fuzz_parse_cot.cpp
+// @brief           Fuzz target: COT_Utility::ParseCOT on arbitrary bytes, through
+//                  both the std::string and the const char* overloads, and the
+//                  header peek in front of the filtered overload, and the
+//                  Untrusted validation tiers, the shape vertex extractor and
+//                  the zero-copy view
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstddef>                      // size_t
+#include <cstdint>                      // uint8_t
+#include <string>                       // string
+#include <vector>                       // vector
+//
+#include "cot_chat.h"                   // ChatStore
+#include "cot_geofence.h"               // Geofences
+#include "cot_shape.h"                  // Vertex extractor
+#include "cot_utility.h"                // COT_Utility
+#include "cot_validate.h"               // Validation tiers
+#include "cot_view.h"                   // COTView
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    COT_Utility c;
+
+    std::string buffer(reinterpret_cast<const char*>(data), size);
+    COTSchema cot;
+    c.ParseCOT(buffer, cot);
+
+    // The const char* overload stops at the first NUL
+    const std::string terminated(reinterpret_cast<const char*>(data), size);
+    COTSchema cot2;
+    c.ParseCOT(terminated.c_str(), cot2);
+
+    // The peek reads only the bytes it was given, whatever their content
+    Peek::Header header;
+    if (Peek::PeekHeader(reinterpret_cast<const char*>(data), size, header))
+    {
+        DateTime stale;
+        Peek::ParseTimestamp(header.stale, stale);
+    }
+    std::string filtered(reinterpret_cast<const char*>(data), size);
+    COTSchema cot3;
+    c.ParseCOT(filtered, cot3, [](const Peek::Header& h) { return h.TypeStartsWith("a-f"); });
+
+    // The streaming check runs on raw bytes, with no terminator and no tree
+    Validate::Issue issue;
+    Validate::CheckWellFormed(reinterpret_cast<const char*>(data), size, issue);
+    COT_Utility untrusted;
+    untrusted.SetValidation(Validate::Untrusted);
+    std::string checked(reinterpret_cast<const char*>(data), size);
+    COTSchema cot4;
+    untrusted.ParseCOT(checked, cot4);
+
+    // The vertex scan reads only the bytes it was given
+    Shape shape;
+    Vertices::Extract(reinterpret_cast<const char*>(data), size, shape);
+    Shape simplified;
+    Vertices::Simplify(shape, 5.0, simplified);
+
+    // The view reads only the bytes it was given, checked or not; cot_diff
+    // compares what it materializes with the parse
+    for (bool check : { true, false })
+    {
+        COTView view;
+        if (view.Parse(reinterpret_cast<const char*>(data), size, check) > 0)
+        {
+            view.detail.Get(&Detail::track).Get(&Track::speed);
+            const COTSchema materialized = view.Materialize();
+            (void)materialized;
+        }
+    }
+
+    // Whatever the parse left in the chat fields can be stored and paged
+    ChatStore chats(ChatStore::Limits(1, 2, 64));
+    chats.Add(cot);
+    chats.Add(cot);
+    std::vector<ChatStore::Message> page;
+    ChatStore::Cursor cursor = ChatStore::Cursor::Latest();
+    chats.History(cot.detail.chat.chatroom, cursor, 1, page);
+
+    // Parsed vertices and points, whatever their values, as fences and tracks
+    Geofences fences(0.01);
+    fences.AddPolygon("shape", shape);
+    fences.AddCircle("point", cot.point.latitude, cot.point.longitude, cot.point.circularError);
+    std::vector<Geofences::Crossing> crossings;
+    fences.Update(cot, crossings);
+    fences.Update(cot.event.uid, Point::Data(shape.Size() > 0 ? shape.latitude[0] : 0, shape.Size() > 0 ? shape.longitude[0] : 0), crossings);
+
+    // A parsed message must survive being generated again
+    std::string out = c.GenerateXMLCOTMessage(cot);
+    (void)out;
+    return 0;
+}
@@ -0,0 +1,64 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            fuzz_sub_parsers.cpp
+// @brief           Fuzz target: the type / how / time / date / time stamp
+//                  attribute parsers. The first byte picks the parser, the rest
+//                  is the attribute value.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstddef>                      // size_t
+#include <cstdint>                      // uint8_t
+#include <string>                       // string
+//
+#include "cot_utility_access.h"         // Private sub-parsers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 1)
+    {
+        return 0;
+    }
+
+    COT_Utility c;
+    std::string value(reinterpret_cast<const char*>(data + 1), size - 1);
+    DateTime dt;
+
+    switch (data[0] % 5)
+    {
+    case 0:
+    {
+        Point::Type ind;
+        Location::Type loc;
+        COT_UtilityAccess::ParseTypeAttribute(c, value, ind, loc);
+        break;
+    }
+    case 1:
+    {
+        How::Entry::Type how;
+        How::Data::Type howData;
+        COT_UtilityAccess::ParseHowAttribute(c, value, how, howData);
+        break;
+    }
+    case 2:
+        if (COT_UtilityAccess::ParseTimeAttribute(c, value, dt))
+        {
+            std::string stamp = dt.ToCOTTimestamp();
+            (void)stamp;
+        }
+        break;
+    case 3:
+        COT_UtilityAccess::ParseDateStamp(c, value, dt);
+        break;
+    default:
+        COT_UtilityAccess::ParseTimeStamp(c, value, dt);
+        break;
+    }
+    return 0;
+}
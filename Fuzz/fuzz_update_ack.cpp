@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            fuzz_update_ack.cpp
+// @brief           Fuzz target: UpdateReceivedCOTMessage and
+//                  AcknowledgeReceivedCOTMessage on arbitrary bytes. The first
+//                  byte selects the acknowledgment flag.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstddef>                      // size_t
+#include <cstdint>                      // uint8_t
+#include <string>                       // string
+//
+#include "cot_utility.h"                // COT_Utility
+//
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size < 1)
+    {
+        return 0;
+    }
+
+    COT_Utility c;
+    const bool acknowledgment = (data[0] & 1) != 0;
+    std::string received(reinterpret_cast<const char*>(data + 1), size - 1);
+
+    COTSchema cot;
+    cot.point.latitude = 31.5990919461411;
+    std::string modified;
+    c.UpdateReceivedCOTMessage(received, cot, modified, acknowledgment);
+
+    std::string response;
+    c.AcknowledgeReceivedCOTMessage(received, response);
+    return 0;
+}
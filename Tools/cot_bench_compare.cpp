@@ -0,0 +1,530 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_bench_compare.cpp
+// @brief           Compares two cot_benchmark JSON outputs and exits non-zero on
+//                  a statistically significant performance regression
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // sort
+#include <cmath>                        // sqrt, erfc
+#include <cstdio>                       // printf
+#include <cstdlib>                      // strtod
+#include <fstream>                      // ifstream
+#include <iostream>                     // cerr
+#include <map>                          // map
+#include <sstream>                      // stringstream
+#include <string>                       // string
+#include <vector>                       // vector
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /////////////////////////////////////////////////////////////////////////////
+    // Minimal JSON reader, enough for the benchmark output format
+    /////////////////////////////////////////////////////////////////////////////
+
+    struct Value
+    {
+        enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+        double                                      number = 0;
+        std::string                                 string;
+        std::vector<Value>                          array;
+        std::vector<std::pair<std::string, Value>>  object;
+
+        const Value* Get(const std::string& key) const
+        {
+            for (const auto& kv : object)
+            {
+                if (kv.first == key) { return &kv.second; }
+            }
+            return nullptr;
+        }
+
+        double Number(const std::string& key, double fallback = 0) const
+        {
+            const Value* v = Get(key);
+            return (v && v->type == Type::Number) ? v->number : fallback;
+        }
+    };
+
+    class Reader
+    {
+    public:
+        explicit Reader(const std::string& text) : mText(text) {}
+
+        bool Parse(Value& out)
+        {
+            return ParseValue(out) && (Skip(), mPos == mText.size());
+        }
+
+    private:
+        void Skip()
+        {
+            while (mPos < mText.size() && (mText[mPos] == ' ' || mText[mPos] == '\n' || mText[mPos] == '\r' || mText[mPos] == '\t'))
+            {
+                mPos++;
+            }
+        }
+
+        bool Literal(const char* word)
+        {
+            size_t n = std::char_traits<char>::length(word);
+            if (mText.compare(mPos, n, word) != 0) { return false; }
+            mPos += n;
+            return true;
+        }
+
+        bool ParseString(std::string& out)
+        {
+            if (mText[mPos] != '"') { return false; }
+            mPos++;
+            while (mPos < mText.size() && mText[mPos] != '"')
+            {
+                char c = mText[mPos++];
+                if (c == '\\' && mPos < mText.size())
+                {
+                    char e = mText[mPos++];
+                    switch (e)
+                    {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u':
+                        // Names in the benchmark output are ASCII; keep escapes of control chars as '?'
+                        mPos += 4;
+                        out += '?';
+                        break;
+                    default: out += e; break;
+                    }
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+            if (mPos >= mText.size()) { return false; }
+            mPos++;
+            return true;
+        }
+
+        bool ParseValue(Value& out)
+        {
+            Skip();
+            if (mPos >= mText.size()) { return false; }
+
+            char c = mText[mPos];
+            if (c == '{')
+            {
+                out.type = Value::Type::Object;
+                mPos++;
+                Skip();
+                if (mPos < mText.size() && mText[mPos] == '}') { mPos++; return true; }
+                while (true)
+                {
+                    Skip();
+                    std::string key;
+                    if (mPos >= mText.size() || !ParseString(key)) { return false; }
+                    Skip();
+                    if (mPos >= mText.size() || mText[mPos++] != ':') { return false; }
+                    Value v;
+                    if (!ParseValue(v)) { return false; }
+                    out.object.emplace_back(key, std::move(v));
+                    Skip();
+                    if (mPos >= mText.size()) { return false; }
+                    if (mText[mPos] == ',') { mPos++; continue; }
+                    if (mText[mPos] == '}') { mPos++; return true; }
+                    return false;
+                }
+            }
+            if (c == '[')
+            {
+                out.type = Value::Type::Array;
+                mPos++;
+                Skip();
+                if (mPos < mText.size() && mText[mPos] == ']') { mPos++; return true; }
+                while (true)
+                {
+                    Value v;
+                    if (!ParseValue(v)) { return false; }
+                    out.array.push_back(std::move(v));
+                    Skip();
+                    if (mPos >= mText.size()) { return false; }
+                    if (mText[mPos] == ',') { mPos++; continue; }
+                    if (mText[mPos] == ']') { mPos++; return true; }
+                    return false;
+                }
+            }
+            if (c == '"')
+            {
+                out.type = Value::Type::String;
+                return ParseString(out.string);
+            }
+            if (Literal("true"))  { out.type = Value::Type::Bool; out.number = 1; return true; }
+            if (Literal("false")) { out.type = Value::Type::Bool; out.number = 0; return true; }
+            if (Literal("null"))  { out.type = Value::Type::Null; return true; }
+
+            const char* start = mText.c_str() + mPos;
+            char* end = nullptr;
+            out.number = std::strtod(start, &end);
+            if (end == start) { return false; }
+            out.type = Value::Type::Number;
+            mPos += static_cast<size_t>(end - start);
+            return true;
+        }
+
+        const std::string&  mText;
+        size_t              mPos = 0;
+    };
+
+    bool LoadJSON(const std::string& path, Value& out)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "ERROR: Could not open " << path << "\n";
+            return false;
+        }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        std::string text = ss.str();
+        Reader reader(text);
+        if (!reader.Parse(out) || out.type != Value::Type::Object)
+        {
+            std::cerr << "ERROR: " << path << " is not valid benchmark JSON\n";
+            return false;
+        }
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Statistics
+    /////////////////////////////////////////////////////////////////////////////
+
+    /// @brief Two-sided Mann-Whitney U test with tie correction and normal
+    ///        approximation. Robust to the outliers typical of timing samples.
+    /// @return p-value, or 1 if there are too few samples to tell
+    double MannWhitneyP(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        const size_t n1 = a.size();
+        const size_t n2 = b.size();
+        if (n1 < 3 || n2 < 3) { return 1.0; }
+
+        std::vector<std::pair<double, int>> all;
+        for (double v : a) { all.emplace_back(v, 0); }
+        for (double v : b) { all.emplace_back(v, 1); }
+        std::sort(all.begin(), all.end());
+
+        // Average ranks across ties
+        const size_t n = all.size();
+        double rankSumA = 0;
+        double tieTerm = 0;
+        for (size_t i = 0; i < n;)
+        {
+            size_t j = i;
+            while (j + 1 < n && all[j + 1].first == all[i].first) { j++; }
+            const double rank = (static_cast<double>(i) + static_cast<double>(j)) / 2.0 + 1.0;
+            const double t = static_cast<double>(j - i + 1);
+            tieTerm += t * t * t - t;
+            for (size_t k = i; k <= j; k++)
+            {
+                if (all[k].second == 0) { rankSumA += rank; }
+            }
+            i = j + 1;
+        }
+
+        const double dn1 = static_cast<double>(n1);
+        const double dn2 = static_cast<double>(n2);
+        const double u = rankSumA - dn1 * (dn1 + 1) / 2.0;
+        const double mean = dn1 * dn2 / 2.0;
+        const double var = dn1 * dn2 / 12.0 * ((dn1 + dn2 + 1) - tieTerm / ((dn1 + dn2) * (dn1 + dn2 - 1)));
+        if (var <= 0) { return 1.0; }
+
+        // Continuity correction
+        const double z = (std::fabs(u - mean) - 0.5) / std::sqrt(var);
+        return std::erfc(std::max(0.0, z) / std::sqrt(2.0));
+    }
+
+    double Median(std::vector<double> v)
+    {
+        if (v.empty()) { return 0; }
+        std::sort(v.begin(), v.end());
+        const size_t m = v.size() / 2;
+        return (v.size() % 2) ? v[m] : (v[m - 1] + v[m]) / 2.0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Comparison
+    /////////////////////////////////////////////////////////////////////////////
+
+    struct Thresholds
+    {
+        double  timePct = 10;           /// Allowed ns/op slowdown
+        double  alpha = 0.01;           /// Significance level of the sample test
+        double  latencyPct = 20;        /// Allowed slowdown of each latency percentile
+        double  allocPct = 0;           /// Allowed allocs/op increase
+        double  bytesPct = 5;           /// Allowed bytes/op increase
+        double  allocAbs = 0.05;        /// Ignore allocs/op changes smaller than this
+        std::vector<std::string> percentiles = { "p50", "p99" };
+        bool    failOnMissing = false;  /// A baseline case missing from the new run is a failure
+    };
+
+    enum class Verdict { Same, Better, Worse };
+
+    struct Row
+    {
+        std::string name;
+        std::string metric;
+        double      base = 0;
+        double      current = 0;
+        double      deltaPct = 0;
+        double      p = -1;
+        Verdict     verdict = Verdict::Same;
+    };
+
+    double DeltaPct(double base, double current)
+    {
+        return base != 0 ? (current - base) / base * 100.0 : (current != 0 ? 100.0 : 0.0);
+    }
+
+    std::vector<double> Samples(const Value& bench)
+    {
+        std::vector<double> out;
+        const Value* s = bench.Get("samples_ns_per_op");
+        if (s && s->type == Value::Type::Array)
+        {
+            for (const Value& v : s->array) { out.push_back(v.number); }
+        }
+        return out;
+    }
+
+    void Compare(const std::string& name, const Value& base, const Value& cur, const Thresholds& t, std::vector<Row>& rows)
+    {
+        // Throughput: median of samples plus a rank test so noise alone cannot fail the gate
+        {
+            std::vector<double> a = Samples(base);
+            std::vector<double> b = Samples(cur);
+            Row r;
+            r.name = name;
+            r.metric = "ns/op";
+            r.base = a.empty() ? base.Number("ns_per_op") : Median(a);
+            r.current = b.empty() ? cur.Number("ns_per_op") : Median(b);
+            r.deltaPct = DeltaPct(r.base, r.current);
+            r.p = MannWhitneyP(a, b);
+            const bool significant = (a.size() >= 3 && b.size() >= 3) ? (r.p < t.alpha) : true;
+            if (significant && r.deltaPct > t.timePct) { r.verdict = Verdict::Worse; }
+            else if (significant && r.deltaPct < -t.timePct) { r.verdict = Verdict::Better; }
+            rows.push_back(r);
+        }
+
+        // Latency percentiles: single values per run, threshold only
+        const Value* la = base.Get("latency_ns");
+        const Value* lb = cur.Get("latency_ns");
+        if (la && lb)
+        {
+            for (const std::string& pct : t.percentiles)
+            {
+                Row r;
+                r.name = name;
+                r.metric = "lat " + pct;
+                r.base = la->Number(pct);
+                r.current = lb->Number(pct);
+                if (r.base == 0 && r.current == 0) { continue; }
+                r.deltaPct = DeltaPct(r.base, r.current);
+                if (r.deltaPct > t.latencyPct) { r.verdict = Verdict::Worse; }
+                else if (r.deltaPct < -t.latencyPct) { r.verdict = Verdict::Better; }
+                rows.push_back(r);
+            }
+        }
+
+        // Allocations are deterministic, so any increase past the threshold counts
+        {
+            Row r;
+            r.name = name;
+            r.metric = "allocs/op";
+            r.base = base.Number("allocs_per_op");
+            r.current = cur.Number("allocs_per_op");
+            r.deltaPct = DeltaPct(r.base, r.current);
+            if (std::fabs(r.current - r.base) >= t.allocAbs)
+            {
+                if (r.deltaPct > t.allocPct) { r.verdict = Verdict::Worse; }
+                else if (r.deltaPct < -t.allocPct) { r.verdict = Verdict::Better; }
+            }
+            rows.push_back(r);
+        }
+
+        // Per-site breakdown (profiled builds only), so a regression names the phase that caused it
+        const Value* sa = base.Get("alloc_sites");
+        const Value* sb = cur.Get("alloc_sites");
+        if (sa && sb && sa->type == Value::Type::Array && sb->type == Value::Type::Array)
+        {
+            std::map<std::string, std::pair<double, double>> sites;
+            for (const Value& v : sa->array) { sites[v.Get("site") ? v.Get("site")->string : ""].first = v.Number("allocs_per_op"); }
+            for (const Value& v : sb->array) { sites[v.Get("site") ? v.Get("site")->string : ""].second = v.Number("allocs_per_op"); }
+            for (const auto& site : sites)
+            {
+                Row r;
+                r.name = name + " [" + site.first + "]";
+                r.metric = "allocs/op";
+                r.base = site.second.first;
+                r.current = site.second.second;
+                r.deltaPct = DeltaPct(r.base, r.current);
+                if (std::fabs(r.current - r.base) >= t.allocAbs)
+                {
+                    if (r.deltaPct > t.allocPct) { r.verdict = Verdict::Worse; }
+                    else if (r.deltaPct < -t.allocPct) { r.verdict = Verdict::Better; }
+                }
+                rows.push_back(r);
+            }
+        }
+        {
+            Row r;
+            r.name = name;
+            r.metric = "bytes/op";
+            r.base = base.Number("bytes_per_op");
+            r.current = cur.Number("bytes_per_op");
+            r.deltaPct = DeltaPct(r.base, r.current);
+            if (r.deltaPct > t.bytesPct) { r.verdict = Verdict::Worse; }
+            else if (r.deltaPct < -t.bytesPct) { r.verdict = Verdict::Better; }
+            rows.push_back(r);
+        }
+    }
+
+    void Usage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " BASELINE.json CURRENT.json [options]\n"
+            "  --time-threshold=PCT      allowed ns/op slowdown in percent (default 10)\n"
+            "  --alpha=P                 significance level for the sample rank test (default 0.01)\n"
+            "  --latency-threshold=PCT   allowed latency percentile slowdown in percent (default 20)\n"
+            "  --percentiles=p50,p99     latency percentiles to gate on (p50,p90,p99,p999,max)\n"
+            "  --alloc-threshold=PCT     allowed allocs/op increase in percent (default 0)\n"
+            "  --bytes-threshold=PCT     allowed bytes/op increase in percent (default 5)\n"
+            "  --filter=substr           only compare benchmarks whose name contains substr\n"
+            "  --fail-on-missing         fail if a baseline benchmark is missing from CURRENT\n"
+            "  --verbose                 print every metric, not just changes\n"
+            "Exit status: 0 no regression, 1 regression, 2 usage or input error\n";
+    }
+};
+
+int main(int argc, char** argv)
+{
+    Thresholds t;
+    std::vector<std::string> files;
+    std::string filter;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            files.push_back(arg);
+            continue;
+        }
+
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+             if (key == "--time-threshold")     t.timePct = std::strtod(value.c_str(), nullptr);
+        else if (key == "--alpha")              t.alpha = std::strtod(value.c_str(), nullptr);
+        else if (key == "--latency-threshold")  t.latencyPct = std::strtod(value.c_str(), nullptr);
+        else if (key == "--alloc-threshold")    t.allocPct = std::strtod(value.c_str(), nullptr);
+        else if (key == "--bytes-threshold")    t.bytesPct = std::strtod(value.c_str(), nullptr);
+        else if (key == "--filter")             filter = value;
+        else if (key == "--fail-on-missing")    t.failOnMissing = true;
+        else if (key == "--verbose")            verbose = true;
+        else if (key == "--percentiles")
+        {
+            t.percentiles.clear();
+            std::stringstream ss(value);
+            std::string p;
+            while (std::getline(ss, p, ',')) { if (!p.empty()) { t.percentiles.push_back(p); } }
+        }
+        else
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (files.size() != 2)
+    {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    Value base, current;
+    if (!LoadJSON(files[0], base) || !LoadJSON(files[1], current))
+    {
+        return 2;
+    }
+
+    const Value* baseList = base.Get("benchmarks");
+    const Value* curList = current.Get("benchmarks");
+    if (!baseList || !curList || baseList->type != Value::Type::Array || curList->type != Value::Type::Array)
+    {
+        std::cerr << "ERROR: Missing \"benchmarks\" array\n";
+        return 2;
+    }
+
+    std::map<std::string, const Value*> curByName;
+    for (const Value& b : curList->array)
+    {
+        const Value* n = b.Get("name");
+        if (n) { curByName[n->string] = &b; }
+    }
+
+    std::vector<Row> rows;
+    std::vector<std::string> missing;
+    for (const Value& b : baseList->array)
+    {
+        const Value* n = b.Get("name");
+        if (!n || (!filter.empty() && n->string.find(filter) == std::string::npos)) { continue; }
+
+        auto it = curByName.find(n->string);
+        if (it == curByName.end())
+        {
+            missing.push_back(n->string);
+            continue;
+        }
+        Compare(n->string, b, *it->second, t, rows);
+    }
+
+    size_t worse = 0;
+    size_t better = 0;
+    std::printf("%-40s %-10s %14s %14s %9s %9s  %s\n", "Benchmark", "Metric", "Baseline", "Current", "Delta", "p", "");
+    for (const Row& r : rows)
+    {
+        worse += (r.verdict == Verdict::Worse) ? 1 : 0;
+        better += (r.verdict == Verdict::Better) ? 1 : 0;
+        if (!verbose && r.verdict == Verdict::Same) { continue; }
+
+        char p[16] = "-";
+        if (r.p >= 0) { std::snprintf(p, sizeof(p), "%.4f", r.p); }
+        std::printf("%-40s %-10s %14.2f %14.2f %+8.1f%% %9s  %s\n", r.name.c_str(), r.metric.c_str(),
+            r.base, r.current, r.deltaPct, p,
+            r.verdict == Verdict::Worse ? "REGRESSION" : (r.verdict == Verdict::Better ? "improved" : ""));
+    }
+
+    for (const std::string& m : missing)
+    {
+        std::printf("%-40s missing from current run\n", m.c_str());
+    }
+
+    std::printf("\n%zu regression(s), %zu improvement(s), %zu missing\n", worse, better, missing.size());
+
+    if (worse > 0 || (t.failOnMissing && !missing.empty()))
+    {
+        return 1;
+    }
+    return 0;
+}
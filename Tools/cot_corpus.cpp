@@ -0,0 +1,617 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_corpus.cpp
+// @brief           Implementation of the synthetic CoT corpus generator
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // push_heap, pop_heap
+#include <cmath>                        // floor, cos
+#include <cstdio>                       // snprintf
+#include <cstdlib>                      // strtod
+#include <fstream>                      // ifstream, ofstream
+#include <sstream>                      // stringstream
+//
+#include "cot_corpus.h"                 // Corpus header
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Corpus
+{
+    /////////////////////////////////////////////////////////////////////////////
+    // Random
+    /////////////////////////////////////////////////////////////////////////////
+
+    static uint64_t SplitMix(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static inline uint64_t Rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    Random::Random(uint64_t seed)
+    {
+        for (uint64_t& v : s) { v = SplitMix(seed); }
+    }
+
+    uint64_t Random::Next()
+    {
+        const uint64_t result = Rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+        return result;
+    }
+
+    uint64_t Random::Range(uint64_t lo, uint64_t hi)
+    {
+        if (hi <= lo) { return lo; }
+        uint64_t span = hi - lo + 1;
+        return span == 0 ? Next() : lo + Next() % span;
+    }
+
+    double Random::Unit()
+    {
+        return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    double Random::Uniform(double lo, double hi)
+    {
+        return lo + (hi - lo) * Unit();
+    }
+
+    bool Random::Chance(double probability)
+    {
+        return probability > 0 && Unit() < probability;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Helpers
+    /////////////////////////////////////////////////////////////////////////////
+
+    bool ParseWeights(const std::string& text, Weights& out)
+    {
+        Weights parsed;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t comma = text.find(',', pos);
+            std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            size_t colon = item.rfind(':');
+            if (colon == std::string::npos || colon == 0)
+            {
+                return false;
+            }
+
+            char* end = nullptr;
+            std::string weight = item.substr(colon + 1);
+            double w = std::strtod(weight.c_str(), &end);
+            if (end == weight.c_str() || *end != '\0' || w < 0)
+            {
+                return false;
+            }
+
+            parsed.emplace_back(item.substr(0, colon), w);
+            if (comma == std::string::npos) { break; }
+            pos = comma + 1;
+        }
+
+        if (parsed.empty())
+        {
+            return false;
+        }
+
+        out = parsed;
+        return true;
+    }
+
+    const char* MalformationName(Malformation m)
+    {
+        switch (m)
+        {
+        case Malformation::None:            return "none";
+        case Malformation::Truncated:       return "truncated";
+        case Malformation::UnclosedTag:     return "unclosed_tag";
+        case Malformation::MissingPoint:    return "missing_point";
+        case Malformation::DuplicatePoint:  return "duplicate_point";
+        case Malformation::ShortType:       return "short_type";
+        case Malformation::ShortHow:        return "short_how";
+        case Malformation::BadTime:         return "bad_time";
+        case Malformation::BadNumber:       return "bad_number";
+        case Malformation::BadQuote:        return "bad_quote";
+        default:                            return "unknown";
+        }
+    }
+
+    /// @brief Replace the value of the first attribute 'name' in xml
+    static void ReplaceAttribute(std::string& xml, const std::string& name, const std::string& value)
+    {
+        std::string key = " " + name + "=\"";
+        size_t start = xml.find(key);
+        if (start == std::string::npos) { return; }
+        start += key.size();
+        size_t end = xml.find('"', start);
+        if (end == std::string::npos) { return; }
+        xml.replace(start, end - start, value);
+    }
+
+    /// @brief Append a double with fixed decimals
+    static void AppendNumber(std::string& out, double value, int decimals)
+    {
+        char buf[96];
+        int n = std::snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        out.append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Generator
+    /////////////////////////////////////////////////////////////////////////////
+
+    // Heap ordering of due entities; ties broken on index so the order is deterministic
+    template <typename T>
+    static bool Later(const T& a, const T& b)
+    {
+        return a.time != b.time ? a.time > b.time : a.index > b.index;
+    }
+
+    static const char* const kCallsignWords[] = { "ALPHA", "BRAVO", "VIPER", "HAWK", "RAVEN", "GHOST",
+        "TITAN", "SABER", "EAGLE", "WOLF", "COBRA", "REAPER", "NOMAD", "ROGUE", "SPARTAN", "ATLAS" };
+    static const char* const kDevices[] = { "Samsung SM-G781U", "Dell Inc. XPS 15 9510", "Google Pixel 7",
+        "Panasonic FZ-55", "Samsung SM-T878U" };
+    static const char* const kPlatforms[] = { "ATAK-CIV", "ATAK-MIL", "WinTAK-CIV", "iTAK" };
+    static const char* const kOSes[] = { "31", "33", "Microsoft Windows 10 Pro", "Microsoft Windows 11 Enterprise" };
+    static const char* const kTeams[] = { "Cyan", "Blue", "Red", "Green", "Yellow", "Magenta", "White" };
+    static const char* const kRoles[] = { "Team Member", "Team Lead", "HQ", "Sniper", "Medic", "RTO", "K9" };
+    static const char* const kUnknownNames[] = { "_flow-tags_", "archive", "__video", "sensor", "color",
+        "usericon", "labels_on", "strokeColor", "fillColor", "__serverdestination", "marti", "height" };
+    static const char* const kWords[] = { "moving", "north", "along", "route", "checkpoint", "observed",
+        "vehicle", "two", "personnel", "static", "grid", "bridge", "river", "crossing", "hold", "position",
+        "request", "resupply", "at", "the", "building", "&amp;", "awaiting", "orders" };
+
+    template <size_t N>
+    static const char* PickFrom(Random& r, const char* const (&list)[N])
+    {
+        return list[r.Range(0, N - 1)];
+    }
+
+    Generator::Generator(const Config& config) : mConfig(config), mRandom(config.seed)
+    {
+        const unsigned count = mConfig.uids == 0 ? 1 : mConfig.uids;
+        mEntities.resize(count);
+
+        // Entities start clustered around a common area of operation
+        const double centerLat = mRandom.Uniform(-60, 60);
+        const double centerLon = mRandom.Uniform(-170, 170);
+
+        for (unsigned i = 0; i < count; i++)
+        {
+            Entity& e = mEntities[i];
+            char uid[64];
+            std::snprintf(uid, sizeof(uid), "ANDROID-%016llx", static_cast<unsigned long long>(mRandom.Next()));
+            e.uid = uid;
+            e.type = MakeType();
+            e.how = Pick(mConfig.hows);
+            e.callsign = std::string(PickFrom(mRandom, kCallsignWords)) + "-" + std::to_string(i + 1);
+            e.device = PickFrom(mRandom, kDevices);
+
+            double rate = mRandom.Uniform(mConfig.minRateHz, std::max(mConfig.minRateHz, mConfig.maxRateHz));
+            e.interval = rate > 0 ? 1.0 / rate : 1.0;
+            e.nextTime = static_cast<double>(mConfig.startEpoch) + mRandom.Uniform(0, e.interval);
+
+            e.lat = centerLat + mRandom.Uniform(-0.5, 0.5);
+            e.lon = centerLon + mRandom.Uniform(-0.5, 0.5);
+            e.hae = mRandom.Uniform(-50, 3000);
+            e.course = mRandom.Uniform(0, 360);
+            e.speed = mRandom.Uniform(0, 40);
+            e.battery = static_cast<double>(mRandom.Range(5, 100));
+            mQueue.push_back({ e.nextTime, i });
+        }
+        std::make_heap(mQueue.begin(), mQueue.end(), Later<Due>);
+    }
+
+    const std::string& Generator::Pick(const Weights& weights)
+    {
+        static const std::string empty;
+        if (weights.empty()) { return empty; }
+
+        double total = 0;
+        for (const auto& w : weights) { total += w.second; }
+
+        double x = mRandom.Uniform(0, total);
+        for (const auto& w : weights)
+        {
+            if (x < w.second) { return w.first; }
+            x -= w.second;
+        }
+        return weights.back().first;
+    }
+
+    std::string Generator::MakeType()
+    {
+        const std::string& root = Pick(mConfig.roots);
+        if (root != "a")
+        {
+            return root;
+        }
+
+        const std::string& dim = Pick(mConfig.dimensions);
+        std::string type = "a-" + Pick(mConfig.affiliations) + "-" + dim;
+
+        static const char* const kGround[] = { "", "-U-C", "-U-C-I", "-E-V-A", "-E-V-C", "-I-M" };
+        static const char* const kAir[] = { "", "-M-F", "-M-H", "-C-F", "-M-F-Q" };
+        static const char* const kSea[] = { "", "-X", "-C-L", "-N" };
+        static const char* const kOther[] = { "", "-S" };
+
+             if (dim == "G") type += PickFrom(mRandom, kGround);
+        else if (dim == "A") type += PickFrom(mRandom, kAir);
+        else if (dim == "S") type += PickFrom(mRandom, kSea);
+        else                 type += PickFrom(mRandom, kOther);
+
+        return type;
+    }
+
+    std::string Generator::RandomText(size_t length)
+    {
+        std::string text;
+        text.reserve(length + 16);
+        while (text.size() < length)
+        {
+            if (!text.empty()) { text += ' '; }
+            text += PickFrom(mRandom, kWords);
+        }
+        return text;
+    }
+
+    void Generator::AppendUnknown(std::string& out, unsigned depth)
+    {
+        const char* name = PickFrom(mRandom, kUnknownNames);
+        out += '<';
+        out += name;
+
+        unsigned attributes = static_cast<unsigned>(mRandom.Range(0, 3));
+        for (unsigned a = 0; a < attributes; a++)
+        {
+            out += " attr";
+            out += std::to_string(a);
+            out += "=\"";
+            out += RandomText(mRandom.Range(1, 24));
+            out += '"';
+        }
+
+        if (depth + 1 < mConfig.unknownMaxDepth && mRandom.Chance(0.3))
+        {
+            out += '>';
+            AppendUnknown(out, depth + 1);
+            out += "</";
+            out += name;
+            out += '>';
+        }
+        else
+        {
+            out += "/>";
+        }
+    }
+
+    void Generator::Render(Entity& e, std::string& out)
+    {
+        const double time = e.nextTime;
+        const std::string stamp = Timestamp(time);
+
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>";
+        out += "<event version=\"2.0\" uid=\"" + e.uid + "\" type=\"" + e.type + "\" time=\"" + stamp +
+            "\" start=\"" + stamp + "\" stale=\"" + Timestamp(time + mConfig.staleSeconds) + "\" how=\"" + e.how + "\">";
+
+        out += "<point lat=\"";
+        AppendNumber(out, e.lat, 7);
+        out += "\" lon=\"";
+        AppendNumber(out, e.lon, 7);
+        out += "\" hae=\"";
+        AppendNumber(out, e.hae, 1);
+        out += "\" ce=\"";
+        AppendNumber(out, mRandom.Chance(0.3) ? 9999999.0 : mRandom.Uniform(1, 50), 1);
+        out += "\" le=\"";
+        AppendNumber(out, mRandom.Chance(0.3) ? 9999999.0 : mRandom.Uniform(1, 50), 1);
+        out += "\"/>";
+
+        out += "<detail>";
+
+        unsigned unknown = static_cast<unsigned>(mRandom.Range(0, mConfig.unknownMaxChildren));
+        unsigned unknownAt = static_cast<unsigned>(mRandom.Range(0, 7));
+        unsigned slot = 0;
+        auto maybeUnknown = [&]()
+        {
+            if (slot++ == unknownAt)
+            {
+                for (unsigned u = 0; u < unknown; u++) { AppendUnknown(out, 0); }
+            }
+        };
+
+        maybeUnknown();
+        if (mRandom.Chance(mConfig.takvRate))
+        {
+            out += "<takv version=\"4.8.1." + std::to_string(mRandom.Range(1, 999)) + "\" platform=\"" +
+                PickFrom(mRandom, kPlatforms) + "\" os=\"" + PickFrom(mRandom, kOSes) + "\" device=\"" + e.device + "\"/>";
+        }
+        maybeUnknown();
+        if (mRandom.Chance(mConfig.contactRate))
+        {
+            out += "<contact callsign=\"" + e.callsign + "\" endpoint=\"*:-1:stcp\"/>";
+        }
+        maybeUnknown();
+        out += "<uid Droid=\"" + e.callsign + "\"/>";
+        if (mRandom.Chance(mConfig.precisionRate))
+        {
+            out += "<precisionlocation altsrc=\"GPS\" geopointsrc=\"GPS\"/>";
+        }
+        maybeUnknown();
+        if (mRandom.Chance(mConfig.groupRate))
+        {
+            out += std::string("<__group name=\"") + PickFrom(mRandom, kTeams) + "\" role=\"" + PickFrom(mRandom, kRoles) + "\"/>";
+        }
+        maybeUnknown();
+        if (mRandom.Chance(mConfig.statusRate))
+        {
+            out += "<status battery=\"" + std::to_string(static_cast<int>(e.battery)) + "\"/>";
+        }
+        maybeUnknown();
+        if (mRandom.Chance(mConfig.trackRate))
+        {
+            out += "<track course=\"";
+            AppendNumber(out, e.course, 8);
+            out += "\" speed=\"";
+            AppendNumber(out, e.speed, 8);
+            out += "\"/>";
+        }
+        maybeUnknown();
+
+        // Type specific detail content
+        if (e.type == "b-t-f")
+        {
+            std::string room = mRandom.Chance(0.5) ? "All Chat Rooms" : PickFrom(mRandom, kTeams);
+            out += "<__chat parent=\"RootContactGroup\" groupOwner=\"false\" chatroom=\"" + room + "\" id=\"" + room +
+                "\" senderCallsign=\"" + e.callsign + "\"><chatgrp uid0=\"" + e.uid + "\" uid1=\"" + room + "\" id=\"" + room + "\"/></__chat>";
+            out += "<link uid=\"" + e.uid + "\" type=\"a-f-G-U-C\" relation=\"p-p\"/>";
+            out += "<remarks source=\"BAO.F.ATAK." + e.uid + "\" to=\"" + room + "\" time=\"" + stamp + "\">" +
+                RandomText(mRandom.Range(8, 160)) + "</remarks>";
+        }
+        else if (e.type == "b-a-o-tbl")
+        {
+            out += "<emergency type=\"911 Alert\">" + e.callsign + "</emergency>";
+        }
+        else if (e.type == "u-d-f")
+        {
+            unsigned vertices = static_cast<unsigned>(mRandom.Range(2, 64));
+            double lat = e.lat;
+            double lon = e.lon;
+            for (unsigned v = 0; v < vertices; v++)
+            {
+                lat += mRandom.Uniform(-0.001, 0.001);
+                lon += mRandom.Uniform(-0.001, 0.001);
+                out += "<link point=\"";
+                AppendNumber(out, lat, 7);
+                out += ',';
+                AppendNumber(out, lon, 7);
+                out += ",0.0\"/>";
+            }
+            // Some without a weight value, which reads as NaN; picked by the vertex
+            // count so the random sequence, and every other message, is unchanged
+            out += (vertices % 3 == 0) ? "<strokeColor value=\"-1\"/><strokeWeight/>" : "<strokeColor value=\"-1\"/><strokeWeight value=\"3.0\"/>";
+        }
+
+        if (mRandom.Chance(mConfig.remarksRate) && e.type != "b-t-f")
+        {
+            out += "<remarks>" + RandomText(mRandom.Range(0, mConfig.remarksMaxBytes)) + "</remarks>";
+        }
+
+        out += "</detail></event>";
+
+        // Advance the entity along its track for the next report
+        const double dt = e.interval;
+        const double rad = e.course * 3.14159265358979323846 / 180.0;
+        e.lat += std::cos(rad) * e.speed * dt / 111320.0;
+        e.lon += std::sin(rad) * e.speed * dt / (111320.0 * std::max(0.01, std::cos(e.lat * 3.14159265358979323846 / 180.0)));
+        if (e.lat > 89.9) { e.lat = 89.9; }
+        if (e.lat < -89.9) { e.lat = -89.9; }
+        if (e.lon > 180) { e.lon -= 360; }
+        if (e.lon < -180) { e.lon += 360; }
+        e.course = std::fmod(e.course + mRandom.Uniform(-10, 10) + 360.0, 360.0);
+        e.battery = std::max(1.0, e.battery - (mRandom.Chance(0.02) ? 1 : 0));
+    }
+
+    void Generator::Malform(Message& msg)
+    {
+        std::string& xml = msg.xml;
+        Malformation kind = static_cast<Malformation>(mRandom.Range(1, static_cast<uint64_t>(Malformation::Count) - 1));
+        msg.malformation = kind;
+
+        switch (kind)
+        {
+        case Malformation::Truncated:
+            xml.resize(static_cast<size_t>(mRandom.Range(1, xml.size() - 1)));
+            break;
+        case Malformation::UnclosedTag:
+            xml.erase(xml.rfind("</event>"));
+            break;
+        case Malformation::MissingPoint:
+        case Malformation::DuplicatePoint:
+        {
+            size_t start = xml.find("<point ");
+            size_t end = xml.find("/>", start);
+            if (start != std::string::npos && end != std::string::npos)
+            {
+                if (kind == Malformation::MissingPoint)
+                {
+                    xml.erase(start, end + 2 - start);
+                }
+                else
+                {
+                    xml.insert(end + 2, xml.substr(start, end + 2 - start));
+                }
+            }
+            break;
+        }
+        case Malformation::ShortType:
+            ReplaceAttribute(xml, "type", "a-f");
+            break;
+        case Malformation::ShortHow:
+            ReplaceAttribute(xml, "how", "h");
+            break;
+        case Malformation::BadTime:
+            ReplaceAttribute(xml, "time", "2O22-1x-22T18:0a:??Z");
+            break;
+        case Malformation::BadNumber:
+            ReplaceAttribute(xml, "lat", "north");
+            break;
+        case Malformation::BadQuote:
+        {
+            size_t uid = xml.find(" uid=\"");
+            if (uid != std::string::npos)
+            {
+                size_t end = xml.find('"', uid + 6);
+                if (end != std::string::npos) { xml.erase(end, 1); }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void Generator::Next(Message& msg)
+    {
+        // Pick the entity with the earliest due time
+        std::pop_heap(mQueue.begin(), mQueue.end(), Later<Due>);
+        Entity& e = mEntities[mQueue.back().index];
+
+        msg.xml.clear();
+        msg.uid = e.uid;
+        msg.time = e.nextTime;
+        msg.malformation = Malformation::None;
+        msg.garbage = false;
+
+        Render(e, msg.xml);
+        e.nextTime += e.interval;
+        mQueue.back().time = e.nextTime;
+        std::push_heap(mQueue.begin(), mQueue.end(), Later<Due>);
+
+        if (mRandom.Chance(mConfig.malformedRate))
+        {
+            Malform(msg);
+        }
+
+        if (mRandom.Chance(mConfig.garbageRate))
+        {
+            size_t length = static_cast<size_t>(mRandom.Range(1, std::max(1u, mConfig.garbageMaxBytes)));
+            std::string garbage(length, '\0');
+            for (char& c : garbage)
+            {
+                // Any byte except '<' so the garbage cannot start a tag
+                c = static_cast<char>(mRandom.Range(1, 255));
+                if (c == '<') { c = '\x7f'; }
+            }
+            msg.xml.insert(0, garbage);
+            msg.garbage = true;
+        }
+    }
+
+    std::vector<Message> Generator::Generate(size_t count)
+    {
+        std::vector<Message> messages(count);
+        for (Message& m : messages) { Next(m); }
+        return messages;
+    }
+
+    std::string Generator::Timestamp(double epochSeconds)
+    {
+        // Civil-from-days conversion (proleptic Gregorian, UTC)
+        double whole = std::floor(epochSeconds);
+        int64_t secs = static_cast<int64_t>(whole);
+        int millis = static_cast<int>((epochSeconds - whole) * 1000.0 + 0.5);
+        if (millis >= 1000) { millis -= 1000; secs++; }
+
+        int64_t days = secs / 86400;
+        int64_t rem = secs % 86400;
+        if (rem < 0) { rem += 86400; days--; }
+
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+        const int64_t year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0);
+
+        // Sized for every field at its widest, so nothing can be cut
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02uT%02d:%02d:%02d.%03dZ",
+            static_cast<long long>(year), month, day,
+            static_cast<int>(rem / 3600), static_cast<int>((rem / 60) % 60), static_cast<int>(rem % 60), millis);
+        return buf;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Framed files
+    /////////////////////////////////////////////////////////////////////////////
+
+    bool WriteFramed(const std::string& path, const std::vector<std::string>& messages)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) { return false; }
+
+        for (const std::string& m : messages)
+        {
+            const uint32_t n = static_cast<uint32_t>(m.size());
+            const unsigned char header[4] = { static_cast<unsigned char>(n >> 24), static_cast<unsigned char>(n >> 16),
+                static_cast<unsigned char>(n >> 8), static_cast<unsigned char>(n) };
+            out.write(reinterpret_cast<const char*>(header), 4);
+            out.write(m.data(), static_cast<std::streamsize>(m.size()));
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool DecodeFramed(const std::string& bytes, std::vector<std::string>& messages)
+    {
+        size_t pos = 0;
+        while (bytes.size() - pos >= 4)
+        {
+            const unsigned char* header = reinterpret_cast<const unsigned char*>(bytes.data() + pos);
+            const uint32_t n = (static_cast<uint32_t>(header[0]) << 24) | (static_cast<uint32_t>(header[1]) << 16) |
+                (static_cast<uint32_t>(header[2]) << 8) | static_cast<uint32_t>(header[3]);
+            pos += 4;
+            if (n > bytes.size() - pos)
+            {
+                return false;
+            }
+            messages.emplace_back(bytes, pos, n);
+            pos += n;
+        }
+        return pos == bytes.size();
+    }
+
+    bool ReadFramed(const std::string& path, std::vector<std::string>& messages)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) { return false; }
+
+        std::stringstream bytes;
+        bytes << in.rdbuf();
+        return DecodeFramed(bytes.str(), messages);
+    }
+};
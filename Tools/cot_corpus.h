@@ -0,0 +1,183 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_corpus.h
+// @brief           Deterministic, seeded generator of synthetic CoT traffic used
+//                  to feed the benchmarks and load tools
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <cstdint>                          // uint64_t
+#include <string>                           // string
+#include <utility>                          // pair
+#include <vector>                           // vector
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Corpus
+{
+    /// @brief Small portable PRNG (xoshiro256**). Unlike the <random> distributions
+    ///        its output is identical on every platform and standard library.
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed = 1);
+
+        /// @brief Next raw 64 bit value
+        uint64_t Next();
+
+        /// @brief Uniform integer in [lo, hi]
+        uint64_t Range(uint64_t lo, uint64_t hi);
+
+        /// @brief Uniform double in [0, 1)
+        double Unit();
+
+        /// @brief Uniform double in [lo, hi)
+        double Uniform(double lo, double hi);
+
+        /// @brief True with the given probability
+        bool Chance(double probability);
+
+    private:
+        uint64_t s[4];
+    };
+
+    /// @brief A weighted list of choices, e.g. "f:40,h:20,u:10"
+    using Weights = std::vector<std::pair<std::string, double>>;
+
+    /// @brief Parse a "key:weight,key:weight" list
+    /// @return false if the text is malformed
+    bool ParseWeights(const std::string& text, Weights& out);
+
+    /// @brief Ways a generated message can be broken on purpose
+    enum class Malformation : int
+    {
+        None,
+        Truncated,          /// Message cut short at a random byte
+        UnclosedTag,        /// </event> missing
+        MissingPoint,       /// No <point> element
+        DuplicatePoint,     /// Two <point> elements
+        ShortType,          /// type="a-f" (fewer than three fields)
+        ShortHow,           /// how="h"
+        BadTime,            /// Non-digit date/time fields
+        BadNumber,          /// lat="north"
+        BadQuote,           /// Unbalanced attribute quote
+        Count
+    };
+
+    /// @brief Name of a malformation kind
+    const char* MalformationName(Malformation m);
+
+    /// @brief Generator configuration. Every field has a realistic default.
+    struct Config
+    {
+        uint64_t    seed = 1;                   /// PRNG seed, same seed gives the same stream
+        unsigned    uids = 500;                 /// Number of distinct entities
+        double      minRateHz = 0.2;            /// Slowest per-entity update rate
+        double      maxRateHz = 2.0;            /// Fastest per-entity update rate
+        double      staleSeconds = 75;          /// stale - time
+        int64_t     startEpoch = 1671732000;    /// First timestamp (2022-12-22T18:00:00Z)
+
+        Weights     roots = { {"a", 85}, {"b-t-f", 6}, {"b-a-o-tbl", 1}, {"u-d-f", 4}, {"t-x-c-t", 4} };
+        Weights     affiliations = { {"f", 40}, {"h", 15}, {"u", 10}, {"n", 8}, {"a", 6}, {"s", 6},
+                                     {"p", 4}, {"j", 3}, {"k", 3}, {"o", 3}, {"x", 2} };
+        Weights     dimensions = { {"G", 60}, {"A", 20}, {"S", 10}, {"U", 4}, {"P", 3}, {"X", 3} };
+        Weights     hows = { {"m-g", 55}, {"h-e", 15}, {"h-g-i-g-o", 10}, {"m-f", 8}, {"m-s", 5},
+                             {"h-c", 3}, {"m-p", 2}, {"m-r", 2} };
+
+        double      takvRate = 0.7;             /// Probability of each optional detail child
+        double      contactRate = 0.9;
+        double      groupRate = 0.8;
+        double      statusRate = 0.6;
+        double      trackRate = 0.7;
+        double      precisionRate = 0.5;
+        double      remarksRate = 0.2;          /// Probability of a <remarks> element
+        unsigned    remarksMaxBytes = 2048;     /// Remarks length is uniform in [0, max]
+        unsigned    unknownMaxChildren = 4;     /// Unknown children count is uniform in [0, max]
+        unsigned    unknownMaxDepth = 2;        /// Nesting depth of unknown children
+
+        double      malformedRate = 0.0;        /// Probability a message is broken on purpose
+        double      garbageRate = 0.0;          /// Probability of transport garbage before <?xml
+        unsigned    garbageMaxBytes = 32;       /// Garbage length is uniform in [1, max]
+    };
+
+    /// @brief One generated message
+    struct Message
+    {
+        std::string     xml;                                /// Message bytes, including any garbage prefix
+        std::string     uid;                                /// Entity uid
+        double          time = 0;                           /// Event time, seconds since epoch
+        Malformation    malformation = Malformation::None;  /// How the message was broken, if at all
+        bool            garbage = false;                    /// Has a garbage prefix
+    };
+
+    class Generator
+    {
+    public:
+
+        /// @brief Construct a generator. Entities and their schedules are drawn from the seed.
+        explicit Generator(const Config& config);
+
+        /// @brief Produce the next message in event-time order
+        void Next(Message& msg);
+
+        /// @brief Produce 'count' messages
+        std::vector<Message> Generate(size_t count);
+
+        /// @brief Format seconds since epoch as a CoT timestamp with millisecond precision
+        static std::string Timestamp(double epochSeconds);
+
+    private:
+
+        struct Entity
+        {
+            std::string uid;
+            std::string type;
+            std::string how;
+            std::string callsign;
+            std::string device;
+            double      interval = 1;
+            double      nextTime = 0;
+            double      lat = 0;
+            double      lon = 0;
+            double      hae = 0;
+            double      course = 0;
+            double      speed = 0;
+            double      battery = 100;
+        };
+
+        /// @brief Entity due for its next report, ordered as a min-heap on time
+        struct Due
+        {
+            double  time;
+            size_t  index;
+        };
+
+        const std::string& Pick(const Weights& weights);
+        std::string MakeType();
+        std::string RandomText(size_t length);
+        void AppendUnknown(std::string& out, unsigned depth);
+        void Render(Entity& e, std::string& out);
+        void Malform(Message& msg);
+
+        Config              mConfig;
+        Random              mRandom;
+        std::vector<Entity> mEntities;
+        std::vector<Due>    mQueue;
+    };
+
+    /// @brief Write messages as a framed stream: 4-byte big-endian length, then the bytes
+    bool WriteFramed(const std::string& path, const std::vector<std::string>& messages);
+
+    /// @brief Split an in-memory framed stream into messages. Every length is checked
+    ///        against the bytes that remain, so hostile input cannot force a large allocation.
+    /// @return true if the stream ended exactly on a frame boundary
+    bool DecodeFramed(const std::string& bytes, std::vector<std::string>& messages);
+
+    /// @brief Read a framed stream written by WriteFramed
+    bool ReadFramed(const std::string& path, std::vector<std::string>& messages);
+};
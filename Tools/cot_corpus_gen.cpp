@@ -0,0 +1,183 @@
+
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_corpus_gen.cpp
+// @brief           Command line front end of the synthetic CoT corpus generator
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstdio>                       // fwrite
+#include <cstdlib>                      // strtoull, strtod
+#include <fstream>                      // ofstream
+#include <iostream>                     // cout, cerr
+#include <map>                          // map
+//
+#include "cot_corpus.h"                 // Corpus generator
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static void Usage(const char* name)
+{
+    std::cerr << "Usage: " << name << " [options]\n"
+        "  --seed=N              PRNG seed (default 1)\n"
+        "  --count=N             messages to generate (default 10000)\n"
+        "  --uids=N              distinct entities (default 500)\n"
+        "  --min-rate=HZ         slowest per-entity update rate (default 0.2)\n"
+        "  --max-rate=HZ         fastest per-entity update rate (default 2.0)\n"
+        "  --roots=k:w,...       event type root mix, e.g. a:85,b-t-f:6,u-d-f:4\n"
+        "  --affiliations=k:w,.. affiliation mix, e.g. f:40,h:15,u:10\n"
+        "  --dimensions=k:w,...  battle dimension mix, e.g. G:60,A:20,S:10\n"
+        "  --hows=k:w,...        how mix, e.g. m-g:55,h-e:15\n"
+        "  --remarks-rate=P      probability of <remarks> (default 0.2)\n"
+        "  --remarks-max=N       maximum remarks length in bytes (default 2048)\n"
+        "  --unknown-max=N       maximum unknown <detail> children (default 4)\n"
+        "  --malformed-rate=P    probability a message is broken (default 0)\n"
+        "  --garbage-rate=P      probability of a garbage prefix (default 0)\n"
+        "  --garbage-max=N       maximum garbage prefix length (default 32)\n"
+        "  --format=F            framed | stream | lines | dir (default framed)\n"
+        "  --out=PATH            output file, or directory for 'dir'; '-' for stdout (default -)\n"
+        "  --stats               print distribution statistics to stderr\n";
+}
+
+int main(int argc, char** argv)
+{
+    Corpus::Config config;
+    size_t count = 10000;
+    std::string format = "framed";
+    std::string out = "-";
+    bool stats = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+        bool ok = true;
+
+             if (key == "--seed")           config.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--count")          count = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--uids")           config.uids = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--min-rate")       config.minRateHz = std::strtod(value.c_str(), nullptr);
+        else if (key == "--max-rate")       config.maxRateHz = std::strtod(value.c_str(), nullptr);
+        else if (key == "--roots")          ok = Corpus::ParseWeights(value, config.roots);
+        else if (key == "--affiliations")   ok = Corpus::ParseWeights(value, config.affiliations);
+        else if (key == "--dimensions")     ok = Corpus::ParseWeights(value, config.dimensions);
+        else if (key == "--hows")           ok = Corpus::ParseWeights(value, config.hows);
+        else if (key == "--remarks-rate")   config.remarksRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--remarks-max")    config.remarksMaxBytes = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--unknown-max")    config.unknownMaxChildren = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--malformed-rate") config.malformedRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--garbage-rate")   config.garbageRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--garbage-max")    config.garbageMaxBytes = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--format")         format = value;
+        else if (key == "--out")            out = value;
+        else if (key == "--stats")          stats = true;
+        else                                ok = false;
+
+        if (!ok)
+        {
+            std::cerr << "ERROR: Bad argument '" << arg << "'\n";
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (format != "framed" && format != "stream" && format != "lines" && format != "dir")
+    {
+        std::cerr << "ERROR: Unknown format '" << format << "'\n";
+        return 2;
+    }
+
+    if (format == "dir" && out == "-")
+    {
+        std::cerr << "ERROR: --format=dir needs --out=DIRECTORY\n";
+        return 2;
+    }
+
+    std::ofstream file;
+    std::ostream* stream = &std::cout;
+    if (format != "dir" && out != "-")
+    {
+        file.open(out, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "ERROR: Could not open " << out << "\n";
+            return 1;
+        }
+        stream = &file;
+    }
+
+    Corpus::Generator generator(config);
+    Corpus::Message msg;
+    std::map<std::string, size_t> types;
+    std::map<std::string, size_t> malformed;
+    size_t garbage = 0;
+    size_t bytes = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+        generator.Next(msg);
+        bytes += msg.xml.size();
+
+        if (format == "framed")
+        {
+            const uint32_t len = static_cast<uint32_t>(msg.xml.size());
+            const char header[4] = { static_cast<char>(len >> 24), static_cast<char>(len >> 16),
+                static_cast<char>(len >> 8), static_cast<char>(len) };
+            stream->write(header, 4);
+            stream->write(msg.xml.data(), static_cast<std::streamsize>(msg.xml.size()));
+        }
+        else if (format == "stream")
+        {
+            stream->write(msg.xml.data(), static_cast<std::streamsize>(msg.xml.size()));
+        }
+        else if (format == "lines")
+        {
+            stream->write(msg.xml.data(), static_cast<std::streamsize>(msg.xml.size()));
+            stream->put('\n');
+        }
+        else
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/%08zu.xml", n);
+            std::ofstream single(out + name, std::ios::binary);
+            if (!single)
+            {
+                std::cerr << "ERROR: Could not write into directory " << out << "\n";
+                return 1;
+            }
+            single.write(msg.xml.data(), static_cast<std::streamsize>(msg.xml.size()));
+        }
+
+        if (stats)
+        {
+            size_t type = msg.xml.find(" type=\"");
+            if (type != std::string::npos)
+            {
+                size_t end = msg.xml.find('"', type + 7);
+                types[msg.xml.substr(type + 7, end == std::string::npos ? 0 : end - type - 7).substr(0, 5)]++;
+            }
+            malformed[Corpus::MalformationName(msg.malformation)]++;
+            garbage += msg.garbage ? 1 : 0;
+        }
+    }
+
+    stream->flush();
+
+    if (stats)
+    {
+        std::cerr << "messages: " << count << "  bytes: " << bytes << "  mean size: "
+            << (count ? bytes / count : 0) << "  garbage prefixes: " << garbage << "\n";
+        std::cerr << "type prefixes:\n";
+        for (const auto& t : types) { std::cerr << "  " << t.first << "\t" << t.second << "\n"; }
+        std::cerr << "malformations:\n";
+        for (const auto& m : malformed) { std::cerr << "  " << m.first << "\t" << m.second << "\n"; }
+    }
+
+    return 0;
+}
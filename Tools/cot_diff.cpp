@@ -0,0 +1,544 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_diff.cpp
+// @brief           Implementation of the differential testing helpers
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <algorithm>                    // max
+#include <clocale>                      // setlocale, localeconv
+#include <cmath>                        // fabs, isnan, pow
+#include <cstdio>                       // snprintf
+#include <cstdlib>                      // strtod
+#include <cstring>                      // memcmp, strlen
+#include <sstream>                      // ostringstream
+#include <type_traits>                  // decay_t, is_same
+//
+#include "cot_diff.h"                   // Diff header
+#include "cot_format.h"                 // WriteFixed, ReadReal
+#include "cot_shape.h"                  // Vertices::Extract
+#include "cot_template.h"               // COTTemplate
+#include "cot_utility.h"                // COT_Utility
+#include "cot_view.h"                   // COTView
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Diff
+{
+    namespace
+    {
+        std::string Text(double v)
+        {
+            std::ostringstream out;
+            out.precision(17);
+            out << v;
+            return out.str();
+        }
+
+        /// @brief Collects mismatches while walking two schemas
+        class Walker
+        {
+        public:
+            Walker(const Policy& policy, std::vector<Mismatch>& out) : mPolicy(policy), mOut(out) {}
+
+            void Str(const char* field, const std::string& a, const std::string& b)
+            {
+                if (a != b) { mOut.push_back(Mismatch{ field, a, b }); }
+            }
+
+            void Int(const char* field, long long a, long long b)
+            {
+                if (a != b) { mOut.push_back(Mismatch{ field, std::to_string(a), std::to_string(b) }); }
+            }
+
+            void Real(const char* field, double a, double b)
+            {
+                if (std::isnan(a) && std::isnan(b)) { return; }
+
+                const Tolerance& t = mPolicy.For(field);
+                const double diff = std::fabs(a - b);
+                const bool equal = (a == b) || diff <= t.absolute + t.relative * std::max(std::fabs(a), std::fabs(b));
+                if (!equal) { mOut.push_back(Mismatch{ field, Text(a), Text(b) }); }
+            }
+
+            void Stamp(const std::string& field, const DateTime& a, const DateTime& b)
+            {
+                Int((field + ".year").c_str(), a.year, b.year);
+                Int((field + ".month").c_str(), a.month, b.month);
+                Int((field + ".day").c_str(), a.day, b.day);
+                Int((field + ".hour").c_str(), a.hour, b.hour);
+                Int((field + ".minute").c_str(), a.minute, b.minute);
+                Real((field + ".second").c_str(), a.second, b.second);
+            }
+
+        private:
+            const Policy&           mPolicy;
+            std::vector<Mismatch>&  mOut;
+        };
+
+        /// @brief Vertex count, each vertex as path.lat/lon/hae, then the style
+        void Walk(Walker& w, const std::string& path, const Shape& a, const Shape& b)
+        {
+            w.Int((path + ".vertices").c_str(), static_cast<long long>(a.Size()), static_cast<long long>(b.Size()));
+            if (a.Valid() && b.Valid() && a.Size() == b.Size())
+            {
+                const std::string lat = path + ".lat", lon = path + ".lon", hae = path + ".hae";
+                for (size_t i = 0; i < a.Size(); i++)
+                {
+                    w.Real(lat.c_str(), a.latitude[i], b.latitude[i]);
+                    w.Real(lon.c_str(), a.longitude[i], b.longitude[i]);
+                    w.Real(hae.c_str(), a.hae[i], b.hae[i]);
+                }
+            }
+            w.Str((path + ".strokeColor").c_str(), a.strokeColor, b.strokeColor);
+            w.Real((path + ".strokeWeight").c_str(), a.strokeWeight, b.strokeWeight);
+            w.Str((path + ".fillColor").c_str(), a.fillColor, b.fillColor);
+        }
+
+        /// @brief Compare every field in T's table, named path.<attribute>, with
+        ///        the element text as path.text
+        template <class T>
+        void Walk(Walker& w, const std::string& path, const T& a, const T& b)
+        {
+            Fields::ForEach<T>([&](const auto& d)
+            {
+                using D = std::decay_t<decltype(d)>;
+                if constexpr (Fields::IsChild<D>::value)
+                {
+                    Walk(w, path + "." + d.name, a.*d.member, b.*d.member);
+                }
+                else if constexpr (Fields::IsContent<D>::value)
+                {
+                    w.Str((path + ".text").c_str(), a.*d.member, b.*d.member);
+                }
+                else
+                {
+                    const std::string field = path + "." + d.xml;
+                    if constexpr (std::is_same<std::decay_t<decltype(a.*d.member)>, double>::value)
+                    {
+                        w.Real(field.c_str(), a.*d.member, b.*d.member);
+                    }
+                    else
+                    {
+                        w.Str(field.c_str(), a.*d.member, b.*d.member);
+                    }
+                }
+            });
+        }
+
+        ParseOutcome RunReferenceParse(const std::string& input)
+        {
+            COT_Utility c;
+            ParseOutcome out;
+            std::string buffer = input;
+            out.result = c.ParseCOT(buffer, out.cot);
+            return out;
+        }
+    };
+
+    const Tolerance& Policy::For(const std::string& field) const
+    {
+        auto it = fields.find(field);
+        return it != fields.end() ? it->second : real;
+    }
+
+    Policy Policy::Exact()
+    {
+        return Policy();
+    }
+
+    Policy Policy::Generator()
+    {
+        Policy p;
+        const Tolerance sixDigits = { 0, 5e-6 };
+        for (const char* f : { "point.lat", "point.lon", "point.hae", "point.ce", "point.le",
+                               "detail.status.battery", "detail.track.course", "detail.track.speed", "event.version" })
+        {
+            p.fields[f] = sixDigits;
+        }
+        for (const char* f : { "event.time.second", "event.start.second", "event.stale.second" })
+        {
+            p.fields[f] = Tolerance{ 0.005, 0 };
+        }
+        for (const char* f : { "detail.shape.lat", "detail.shape.lon" })
+        {
+            p.fields[f] = Tolerance{ 5e-8, 0 };
+        }
+        p.fields["detail.shape.hae"] = Tolerance{ 0.05, 0 };
+        p.fields["detail.shape.strokeWeight"] = sixDigits;
+        return p;
+    }
+
+    std::vector<Mismatch> Compare(const COTSchema& a, const COTSchema& b, const Policy& policy)
+    {
+        std::vector<Mismatch> out;
+        Walker w(policy, out);
+
+        w.Real("event.version", a.event.version, b.event.version);
+        w.Str("event.type", a.event.type, b.event.type);
+        w.Int("event.indicator", static_cast<int>(a.event.indicator), static_cast<int>(b.event.indicator));
+        w.Int("event.location", static_cast<int>(a.event.location), static_cast<int>(b.event.location));
+        w.Str("event.uid", a.event.uid, b.event.uid);
+        w.Stamp("event.time", a.event.time, b.event.time);
+        w.Stamp("event.start", a.event.start, b.event.start);
+        w.Stamp("event.stale", a.event.stale, b.event.stale);
+        w.Str("event.how", a.event.how, b.event.how);
+        w.Int("event.howEntry", static_cast<int>(a.event.howEntry), static_cast<int>(b.event.howEntry));
+        w.Int("event.howData", static_cast<int>(a.event.howData), static_cast<int>(b.event.howData));
+
+        Walk(w, "point", a.point, b.point);
+        Walk(w, "detail", a.detail, b.detail);
+
+        return out;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Path registries
+    /////////////////////////////////////////////////////////////////////////////
+
+    ParsePath ReferenceParse()
+    {
+        return ParsePath{ "ParseCOT", RunReferenceParse };
+    }
+
+    GeneratePath ReferenceGenerate()
+    {
+        return GeneratePath{ "GenerateXMLCOTMessage", [](COTSchema& cot)
+        {
+            COT_Utility c;
+            return c.GenerateXMLCOTMessage(cot);
+        }, {} };
+    }
+
+    PatchPath ReferenceUpdate()
+    {
+        return PatchPath{ "UpdateReceivedCOTMessage", [](const std::string& in, std::string& out)
+        {
+            COT_Utility c;
+            std::string received = in;
+            COTSchema cot;
+            cot.point.latitude = 12.5;
+            return c.UpdateReceivedCOTMessage(received, cot, out, true);
+        } };
+    }
+
+    PatchPath ReferenceAcknowledge()
+    {
+        return PatchPath{ "AcknowledgeReceivedCOTMessage", [](const std::string& in, std::string& out)
+        {
+            COT_Utility c;
+            std::string received = in;
+            return c.AcknowledgeReceivedCOTMessage(received, out);
+        } };
+    }
+
+    std::vector<ParsePath> ParseCandidates()
+    {
+        std::vector<ParsePath> paths;
+
+        paths.push_back(ParsePath{ "ParseCOT(const char*)", [](const std::string& input)
+        {
+            COT_Utility c;
+            ParseOutcome out;
+            out.result = c.ParseCOT(input.c_str(), out.cot);
+            return out;
+        } });
+
+        // Vertices from the raw scan, the rest from a parse that skips them
+        paths.push_back(ParsePath{ "ParseCOT+Vertices::Extract", [](const std::string& input)
+        {
+            COT_Utility c;
+            ParseOutcome out;
+            std::string buffer = input;
+            out.result = c.ParseCOT(buffer, out.cot, ParseOptions::All & ~ParseOptions::Shape);
+            Vertices::Extract(input, out.cot.detail.shape);
+            return out;
+        } });
+
+        // One raw scan, then the owning schema built from the views
+        paths.push_back(ParsePath{ "COTView::Materialize", [](const std::string& input)
+        {
+            COTView view;
+            ParseOutcome out;
+            out.result = view.Parse(input);
+            if (out.result > 0)
+            {
+                view.Materialize(out.cot);
+            }
+            return out;
+        } });
+
+        return paths;
+    }
+
+    std::vector<GeneratePath> GenerateCandidates()
+    {
+        std::vector<GeneratePath> paths;
+
+        // Compiled from the schema it renders, so every constant field is exercised too
+        GeneratePath compiled{ "COTTemplate", [](COTSchema& cot)
+        {
+            return COTTemplate(cot).Render(cot);
+        }, {} };
+        const COTTemplate::Precision p;
+        compiled.tolerances["point.lat"] = Tolerance{ 0.5 / std::pow(10.0, p.latLon), 0 };
+        compiled.tolerances["point.lon"] = Tolerance{ 0.5 / std::pow(10.0, p.latLon), 0 };
+        compiled.tolerances["point.hae"] = Tolerance{ 0.5 / std::pow(10.0, p.hae), 0 };
+        compiled.tolerances["point.ce"] = Tolerance{ 0.05, 0 };
+        compiled.tolerances["point.le"] = Tolerance{ 0.05, 0 };
+        compiled.tolerances["detail.track.course"] = Tolerance{ 0.5 / std::pow(10.0, p.course), 0 };
+        compiled.tolerances["detail.track.speed"] = Tolerance{ 0.5 / std::pow(10.0, p.speed), 0 };
+        compiled.tolerances["detail.status.battery"] = Tolerance{ 0.5 / std::pow(10.0, p.battery), 0 };
+        for (const char* f : { "event.time.second", "event.start.second", "event.stale.second" })
+        {
+            compiled.tolerances[f] = Tolerance{ 0.5 / std::pow(10.0, p.seconds), 0 };
+        }
+        paths.push_back(compiled);
+
+        return paths;
+    }
+
+    std::vector<PatchPath> UpdateCandidates()
+    {
+        return {};
+    }
+
+    std::vector<PatchPath> AcknowledgeCandidates()
+    {
+        return {};
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Comparisons
+    /////////////////////////////////////////////////////////////////////////////
+
+    std::vector<Mismatch> DiffParse(const ParsePath& candidate, const std::string& input, const Policy& policy)
+    {
+        const ParseOutcome expected = RunReferenceParse(input);
+        const ParseOutcome actual = candidate.run(input);
+
+        if (expected.result != actual.result)
+        {
+            return { Mismatch{ "result", std::to_string(expected.result), std::to_string(actual.result) } };
+        }
+
+        // A rejected message leaves a partly filled schema; only compare if asked
+        if (expected.result < 0 && !policy.compareRejected)
+        {
+            return {};
+        }
+
+        return Compare(expected.cot, actual.cot, policy);
+    }
+
+    std::vector<Mismatch> DiffGenerate(const GeneratePath& candidate, const std::string& input, const Policy& policy, bool exact)
+    {
+        ParseOutcome source = RunReferenceParse(input);
+        if (source.result < 0)
+        {
+            return {};
+        }
+
+        COTSchema copy = source.cot;
+        const std::string actual = candidate.run(copy);
+
+        if (exact)
+        {
+            const std::string expected = ReferenceGenerate().run(copy = source.cot);
+            return expected == actual ? std::vector<Mismatch>() : std::vector<Mismatch>{ Mismatch{ "bytes", expected, actual } };
+        }
+
+        // Widen the policy by whatever the candidate rounds away on purpose
+        Policy widened = policy;
+        for (const auto& t : candidate.tolerances)
+        {
+            const Tolerance& base = policy.For(t.first);
+            widened.fields[t.first] = Tolerance{ std::max(base.absolute, t.second.absolute), std::max(base.relative, t.second.relative) };
+        }
+
+        const ParseOutcome reparsed = RunReferenceParse(actual);
+        if (reparsed.result != source.result)
+        {
+            return { Mismatch{ "result", std::to_string(source.result), std::to_string(reparsed.result) } };
+        }
+        std::vector<Mismatch> out = Compare(source.cot, reparsed.cot, widened);
+
+        // NaN reads back as NaN, so only the text shows an element the input did not carry
+        const size_t nan = actual.find("=\"nan\"");
+        if (nan != std::string::npos && input.find("=\"nan\"") == std::string::npos)
+        {
+            const size_t tag = actual.rfind('<', nan);
+            out.push_back(Mismatch{ "nan", "no \"nan\" value", actual.substr(tag, actual.find('>', nan) + 1 - tag) });
+        }
+        return out;
+    }
+
+    std::vector<Mismatch> DiffPatch(const PatchPath& reference, const PatchPath& candidate, const std::string& input, const Policy& policy, bool exact)
+    {
+        std::string expected, actual;
+        const bool a = reference.run(input, expected);
+        const bool b = candidate.run(input, actual);
+
+        if (a != b)
+        {
+            return { Mismatch{ "modified", a ? "true" : "false", b ? "true" : "false" } };
+        }
+        if (!a)
+        {
+            return {};
+        }
+        if (exact)
+        {
+            return expected == actual ? std::vector<Mismatch>() : std::vector<Mismatch>{ Mismatch{ "bytes", expected, actual } };
+        }
+
+        const ParseOutcome pa = RunReferenceParse(expected);
+        const ParseOutcome pb = RunReferenceParse(actual);
+        if (pa.result != pb.result)
+        {
+            return { Mismatch{ "result", std::to_string(pa.result), std::to_string(pb.result) } };
+        }
+        return Compare(pa.cot, pb.cot, policy);
+    }
+
+    std::vector<Mismatch> DiffRoundTrip(const std::string& input, const Policy& policy)
+    {
+        ParseOutcome first = RunReferenceParse(input);
+        if (first.result < 0)
+        {
+            return {};
+        }
+
+        const COTSchema parsed = first.cot;
+        const std::string generated = ReferenceGenerate().run(first.cot);
+        const ParseOutcome second = RunReferenceParse(generated);
+        if (second.result != first.result)
+        {
+            return { Mismatch{ "result", std::to_string(first.result), std::to_string(second.result) } };
+        }
+        return Compare(parsed, second.cot, policy);
+    }
+
+    std::vector<Mismatch> DiffReal(double value)
+    {
+        // strtod reads in the process locale; the reference is its "C" reading
+        const bool foreign = (*std::localeconv()->decimal_point != '.');
+        std::string locale;
+        if (foreign)
+        {
+            locale = std::setlocale(LC_NUMERIC, nullptr);
+            std::setlocale(LC_NUMERIC, "C");
+        }
+
+        std::vector<std::pair<std::string, std::string>> texts;
+        std::vector<std::string> fixedTexts;
+        std::vector<std::string> trimmedTexts;
+        char buffer[Format::MaxNumber + 8];
+        for (int decimals = 0; decimals <= Format::MaxDecimals; decimals++)
+        {
+            const std::string field = "fixed/" + std::to_string(decimals);
+            const std::string text(buffer, Format::WriteFixed(buffer, value, decimals));
+            texts.emplace_back(field, text);
+            texts.emplace_back(field + "/decorated", " \t+" + text + "x");
+            fixedTexts.push_back(text);
+            trimmedTexts.emplace_back(buffer, Format::WriteTrimmed(buffer, value, decimals));
+        }
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        texts.emplace_back("g17", buffer);
+
+        std::vector<double> expected;
+        std::vector<size_t> lengths;
+        for (const auto& t : texts)
+        {
+            char* end = nullptr;
+            expected.push_back(std::strtod(t.second.c_str(), &end));
+            lengths.push_back(end - t.second.c_str());
+        }
+
+        // Trimming drops zeros only; the text must still read as the fixed text
+        std::vector<std::pair<double, double>> trimmedValues;
+        for (size_t i = 0; i < trimmedTexts.size(); i++)
+        {
+            trimmedValues.emplace_back(std::strtod(fixedTexts[i].c_str(), nullptr), std::strtod(trimmedTexts[i].c_str(), nullptr));
+        }
+
+        if (foreign)
+        {
+            std::setlocale(LC_NUMERIC, locale.c_str());
+        }
+
+        const auto same = [](double a, double b) { return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof(a)) == 0; };
+        std::vector<Mismatch> out;
+        for (size_t i = 0; i < texts.size(); i++)
+        {
+            const std::string& text = texts[i].second;
+            double actual = 0;
+            const size_t length = Format::ReadReal(text.c_str(), actual) - text.c_str();
+            if (!same(expected[i], actual) || length != lengths[i])
+            {
+                out.push_back(Mismatch{ texts[i].first, text + " -> " + Text(expected[i]) + " (" + std::to_string(lengths[i]) + " chars)",
+                    Text(actual) + " (" + std::to_string(length) + " chars)" });
+            }
+        }
+        for (size_t i = 0; i < trimmedValues.size(); i++)
+        {
+            if (!same(trimmedValues[i].first, trimmedValues[i].second))
+            {
+                out.push_back(Mismatch{ "trimmed/" + std::to_string(i), fixedTexts[i], trimmedTexts[i] });
+            }
+        }
+        double back = 0;
+        Format::ReadReal(texts.back().second.c_str(), back);
+        if (!same(value, back) && !std::isnan(value))
+        {
+            out.push_back(Mismatch{ "g17/roundtrip", Text(value), Text(back) });
+        }
+        return out;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Minimization
+    /////////////////////////////////////////////////////////////////////////////
+
+    std::string Minimize(const std::string& input, const std::function<bool(const std::string&)>& fails, size_t maxTests)
+    {
+        // ddmin: try dropping each of n chunks, refine n when nothing can go
+        std::string current = input;
+        size_t n = 2;
+        size_t tests = 0;
+
+        while (current.size() >= 2 && tests < maxTests)
+        {
+            const size_t chunk = (current.size() + n - 1) / n;
+            bool reduced = false;
+
+            for (size_t start = 0; start < current.size() && tests < maxTests; start += chunk)
+            {
+                std::string candidate = current.substr(0, start) + current.substr(std::min(current.size(), start + chunk));
+                tests++;
+                if (!candidate.empty() && fails(candidate))
+                {
+                    current = candidate;
+                    n = std::max<size_t>(n - 1, 2);
+                    reduced = true;
+                    break;
+                }
+            }
+
+            if (!reduced)
+            {
+                if (n >= current.size())
+                {
+                    break;
+                }
+                n = std::min(current.size(), n * 2);
+            }
+        }
+
+        return current;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_diff.h
+// @brief           Differential testing of COT_Utility code paths. Every fast
+//                  path is run next to the reference pugixml/DOM implementation
+//                  on the same input, the results are compared field by field
+//                  under a floating point tolerance policy, and a mismatching
+//                  input is shrunk to a minimal reproducer.
+//
+//                  New fast paths are added to the registries in cot_diff.cpp.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                            reason included
+//          --------------------            ------------------------------------
+#include <functional>                       // function
+#include <map>                              // map
+#include <string>                           // string
+#include <vector>                           // vector
+//
+#include "cot_info.h"                       // COTSchema
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+namespace Diff
+{
+    /// @brief Two reals are equal if they differ by at most absolute + relative * the larger
+    struct Tolerance
+    {
+        double absolute = 0;
+        double relative = 0;
+    };
+
+    /// @brief How results are compared
+    struct Policy
+    {
+        Tolerance                           real;               /// Default for every real field
+        std::map<std::string, Tolerance>    fields;             /// Overrides by field name, e.g. "point.lat"
+        bool                                compareRejected = false;    /// Compare fields even when both paths rejected the input
+
+        /// @brief Tolerance for a field
+        const Tolerance& For(const std::string& field) const;
+
+        /// @brief Exact comparison (NaN equals NaN)
+        static Policy Exact();
+
+        /// @brief Tolerances for text produced by GenerateXMLCOTMessage, which
+        ///        writes reals with 6 significant digits and seconds with 2 decimals
+        static Policy Generator();
+    };
+
+    /// @brief One differing field
+    struct Mismatch
+    {
+        std::string field;
+        std::string expected;       /// Reference value
+        std::string actual;         /// Candidate value
+    };
+
+    /// @brief Compare two schemas field by field
+    std::vector<Mismatch> Compare(const COTSchema& expected, const COTSchema& actual, const Policy& policy);
+
+    /// @brief Result of a parse path
+    struct ParseOutcome
+    {
+        int         result = 0;     /// ParseCOT return value
+        COTSchema   cot;
+    };
+
+    /// @brief A parse path: message bytes in, result and schema out
+    struct ParsePath
+    {
+        std::string                                         name;
+        std::function<ParseOutcome(const std::string&)>     run;
+    };
+
+    /// @brief A generate path: schema in, message bytes out
+    struct GeneratePath
+    {
+        std::string                                         name;
+        std::function<std::string(COTSchema&)>              run;
+        std::map<std::string, Tolerance>                    tolerances;     /// Added to the policy for output the path rounds on purpose
+    };
+
+    /// @brief A patch path (update / acknowledge): received message in, patched message out
+    struct PatchPath
+    {
+        std::string                                         name;
+        std::function<bool(const std::string&, std::string&)> run;     /// Returns the 'modified' flag
+    };
+
+    /// @brief Reference implementations
+    ParsePath ReferenceParse();
+    GeneratePath ReferenceGenerate();
+    PatchPath ReferenceUpdate();
+    PatchPath ReferenceAcknowledge();
+
+    /// @brief Candidate paths checked against the references
+    std::vector<ParsePath> ParseCandidates();
+    std::vector<GeneratePath> GenerateCandidates();
+    std::vector<PatchPath> UpdateCandidates();
+    std::vector<PatchPath> AcknowledgeCandidates();
+
+    /// @brief Compare a parse candidate with the reference on one input
+    std::vector<Mismatch> DiffParse(const ParsePath& candidate, const std::string& input, const Policy& policy);
+
+    /// @brief Check a generate candidate on the schema the reference parser reads
+    ///        from 'input': its output must parse back to that schema, without a
+    ///        "nan" value the input did not have (an element written for a field
+    ///        it does not carry). When 'exact' its bytes must instead equal the
+    ///        reference generator's. The reference
+    ///        generator itself is checked the first way by DiffRoundTrip().
+    std::vector<Mismatch> DiffGenerate(const GeneratePath& candidate, const std::string& input, const Policy& policy, bool exact);
+
+    /// @brief Compare a patch candidate with a reference patch path on one input
+    std::vector<Mismatch> DiffPatch(const PatchPath& reference, const PatchPath& candidate, const std::string& input, const Policy& policy, bool exact);
+
+    /// @brief Reference parse, reference generate, reference parse again; the
+    ///        two parses must agree. Catches fields the generator drops or changes.
+    std::vector<Mismatch> DiffRoundTrip(const std::string& input, const Policy& policy);
+
+    /// @brief Read back the text Format writes for a real: WriteFixed at every
+    ///        decimals setting and "%.17g", plain and with leading space, a '+'
+    ///        and trailing text. Format::ReadReal must read each as strtod does
+    ///        in the "C" locale, whatever the process locale, and "%.17g" must
+    ///        give 'value' back exactly. WriteTrimmed must read as WriteFixed
+    ///        does at every decimals setting, exponents included.
+    std::vector<Mismatch> DiffReal(double value);
+
+    /// @brief Shrink an input while 'fails' still holds (delta debugging on bytes)
+    /// @param input    - [in] - failing input
+    /// @param fails    - [in] - true if an input still shows the problem
+    /// @param maxTests - [in] - give up after this many calls to 'fails'
+    std::string Minimize(const std::string& input, const std::function<bool(const std::string&)>& fails, size_t maxTests = 20000);
+};
@@ -0,0 +1,389 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_diff_main.cpp
+// @brief           Command line front end of the differential tester. Runs every
+//                  registered fast path next to the reference implementation on
+//                  a generated or recorded corpus and reports minimized mismatches.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <clocale>                      // setlocale
+#include <cmath>                        // floor, pow
+#include <cstdlib>                      // strtoull, strtod
+#include <cstring>                      // memcpy
+#include <limits>                       // numeric_limits
+#include <fstream>                      // ofstream
+#include <iostream>                     // cout, cerr
+#include <map>                          // map
+#include <sstream>                      // stringstream
+//
+#include "cot_corpus.h"                 // Corpus generator, ReadFramed
+#include "cot_diff.h"                   // Diff
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    /// @brief One check: a named function that returns the mismatches for an input
+    struct Check
+    {
+        std::string                                                 name;
+        std::function<std::vector<Diff::Mismatch>(const std::string&)> run;
+    };
+
+    /// @brief Totals for one check
+    struct Tally
+    {
+        size_t      inputs = 0;
+        size_t      failures = 0;
+        std::map<std::string, size_t> fields;    /// Mismatches by field name
+    };
+
+    /// @brief Parse "field:abs[:rel]"
+    bool ParseTolerance(const std::string& text, Diff::Policy& policy)
+    {
+        std::stringstream ss(text);
+        std::string field, absolute, relative;
+        if (!std::getline(ss, field, ':') || !std::getline(ss, absolute, ':'))
+        {
+            return false;
+        }
+        std::getline(ss, relative, ':');
+
+        Diff::Tolerance t;
+        t.absolute = std::strtod(absolute.c_str(), nullptr);
+        t.relative = relative.empty() ? 0 : std::strtod(relative.c_str(), nullptr);
+        if (field == "*")
+        {
+            policy.real = t;
+        }
+        else
+        {
+            policy.fields[field] = t;
+        }
+        return true;
+    }
+
+    std::string Printable(const std::string& s, size_t max = 120)
+    {
+        std::string out;
+        for (char c : s.substr(0, max))
+        {
+            out += (c == '\n') ? ' ' : c;
+        }
+        if (s.size() > max)
+        {
+            out += "...";
+        }
+        return out;
+    }
+
+    /// @brief Reals for --numbers: the special values, then in turn random bit
+    ///        patterns, coordinates, values halfway between the decimals
+    ///        WriteFixed rounds to, and very large and very small magnitudes
+    std::vector<double> NumberInputs(uint64_t seed, size_t count)
+    {
+        using Limits = std::numeric_limits<double>;
+        std::vector<double> values = { 0.0, -0.0, 1.0, -1.0, 0.5, 9999999.0, 31.5990919461411, -81.7768698985248,
+            Limits::infinity(), -Limits::infinity(), Limits::quiet_NaN(), Limits::max(), Limits::lowest(),
+            Limits::min(), Limits::denorm_min(), Limits::epsilon(), 1e16, 9007199254740993.0, 0.1, 0.2, 0.3,
+            1.5e20, -1.2e30, 1e300, 1e19, 9.5e18, -4.25e25 };
+
+        Corpus::Random random(seed);
+        for (size_t i = 0; values.size() < count; i++)
+        {
+            double v = 0;
+            switch (i % 4)
+            {
+            case 0:
+            {
+                const uint64_t bits = random.Next();
+                std::memcpy(&v, &bits, sizeof(v));
+                break;
+            }
+            case 1:
+                v = random.Uniform(-180, 180);
+                break;
+            case 2:
+            {
+                const double scale = std::pow(10.0, static_cast<double>(random.Range(0, 9)));
+                v = (std::floor(random.Uniform(-1e5, 1e5) * scale) + 0.5) / scale;
+                break;
+            }
+            default:
+                v = random.Uniform(1, 10) * std::pow(10.0, random.Uniform(-320, 308));
+                break;
+            }
+            values.push_back(v);
+        }
+        values.resize(count);
+        return values;
+    }
+
+    void Usage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " [options]\n"
+            "  --seed=N              corpus PRNG seed (default 1)\n"
+            "  --count=N             messages to generate (default 10000)\n"
+            "  --malformed-rate=P    probability a generated message is broken (default 0.1)\n"
+            "  --garbage-rate=P      probability of a garbage prefix (default 0.05)\n"
+            "  --corpus=PATH         read a framed corpus instead of generating one\n"
+            "  --policy=P            exact | generator: default float tolerances (default exact)\n"
+            "  --tolerance=F:A[:R]   absolute / relative tolerance for field F ('*' for all reals)\n"
+            "  --compare-rejected    compare fields even when both paths reject an input\n"
+            "  --exact               compare generated / patched messages byte for byte\n"
+            "  --roundtrip           also check parse -> generate -> parse on the reference\n"
+            "  --numbers=N           also read back the formatter's text for N reals (Format::ReadReal)\n"
+            "  --locale=NAME         run in this process locale, e.g. de_DE.UTF-8\n"
+            "  --filter=substr       only run checks whose name contains substr\n"
+            "  --out-dir=PATH        write minimized reproducers to PATH\n"
+            "  --max-report=N        mismatches printed per check (default 5)\n"
+            "  --verbose             keep the library's parse diagnostics on stderr\n"
+            "Exit status: 0 no mismatch, 1 mismatch, 2 usage or input error\n";
+    }
+};
+
+int main(int argc, char** argv)
+{
+    Corpus::Config config;
+    config.malformedRate = 0.1;
+    config.garbageRate = 0.05;
+    size_t count = 10000;
+    std::string corpusPath;
+    std::string filter;
+    std::string outDir;
+    size_t maxReport = 5;
+    bool exact = false;
+    bool roundTrip = false;
+    size_t numbers = 0;
+    std::string locale;
+    bool verbose = false;
+    Diff::Policy policy = Diff::Policy::Exact();
+    std::vector<std::string> tolerances;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+        bool ok = true;
+
+             if (key == "--seed")               config.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--count")              count = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--malformed-rate")     config.malformedRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--garbage-rate")       config.garbageRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--corpus")             corpusPath = value;
+        else if (key == "--tolerance")          tolerances.push_back(value);
+        else if (key == "--compare-rejected")   policy.compareRejected = true;
+        else if (key == "--exact")              exact = true;
+        else if (key == "--roundtrip")          roundTrip = true;
+        else if (key == "--numbers")            numbers = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--locale")             locale = value;
+        else if (key == "--filter")             filter = value;
+        else if (key == "--out-dir")            outDir = value;
+        else if (key == "--verbose")            verbose = true;
+        else if (key == "--max-report")         maxReport = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--policy")
+        {
+            const bool keep = policy.compareRejected;
+            if (value == "exact")               policy = Diff::Policy::Exact();
+            else if (value == "generator")      policy = Diff::Policy::Generator();
+            else                                ok = false;
+            policy.compareRejected = keep;
+        }
+        else                                    ok = false;
+
+        if (!ok)
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Applied after --policy so explicit tolerances always win
+    for (const std::string& t : tolerances)
+    {
+        if (!ParseTolerance(t, policy))
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!locale.empty() && std::setlocale(LC_ALL, locale.c_str()) == nullptr)
+    {
+        std::cerr << "locale " << locale << " is not installed\n";
+        return 2;
+    }
+
+    std::vector<std::string> inputs;
+    if (!corpusPath.empty())
+    {
+        if (!Corpus::ReadFramed(corpusPath, inputs))
+        {
+            std::cerr << "cannot read framed corpus " << corpusPath << "\n";
+            return 2;
+        }
+    }
+    else
+    {
+        Corpus::Generator generator(config);
+        for (Corpus::Message& m : generator.Generate(count))
+        {
+            inputs.push_back(std::move(m.xml));
+        }
+    }
+
+    // Every registered path becomes one check
+    std::vector<Check> checks;
+    for (const Diff::ParsePath& p : Diff::ParseCandidates())
+    {
+        checks.push_back(Check{ "parse/" + p.name, [p, &policy](const std::string& in) { return Diff::DiffParse(p, in, policy); } });
+    }
+    for (const Diff::GeneratePath& p : Diff::GenerateCandidates())
+    {
+        checks.push_back(Check{ "generate/" + p.name, [p, &policy, exact](const std::string& in) { return Diff::DiffGenerate(p, in, policy, exact); } });
+    }
+    const Diff::PatchPath update = Diff::ReferenceUpdate();
+    for (const Diff::PatchPath& p : Diff::UpdateCandidates())
+    {
+        checks.push_back(Check{ "update/" + p.name, [update, p, &policy, exact](const std::string& in) { return Diff::DiffPatch(update, p, in, policy, exact); } });
+    }
+    const Diff::PatchPath ack = Diff::ReferenceAcknowledge();
+    for (const Diff::PatchPath& p : Diff::AcknowledgeCandidates())
+    {
+        checks.push_back(Check{ "ack/" + p.name, [ack, p, &policy, exact](const std::string& in) { return Diff::DiffPatch(ack, p, in, policy, exact); } });
+    }
+    if (roundTrip)
+    {
+        checks.push_back(Check{ "roundtrip", [&policy](const std::string& in) { return Diff::DiffRoundTrip(in, policy); } });
+    }
+
+    // Rejected inputs make the library print a diagnostic to cout or cerr each
+    // time; the report gets its own stream so those can be silenced
+    std::ostream report(std::cout.rdbuf());
+    std::streambuf* stdoutBuffer = std::cout.rdbuf();
+    std::streambuf* stderrBuffer = std::cerr.rdbuf();
+    if (!verbose)
+    {
+        std::cout.rdbuf(nullptr);
+        std::cerr.rdbuf(nullptr);
+    }
+
+    report << inputs.size() << " inputs\n";
+
+    bool failed = false;
+    for (const Check& check : checks)
+    {
+        if (!filter.empty() && check.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        Tally tally;
+        size_t reported = 0;
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            tally.inputs++;
+            const std::vector<Diff::Mismatch> mismatches = check.run(inputs[i]);
+            if (mismatches.empty())
+            {
+                continue;
+            }
+
+            tally.failures++;
+            for (const Diff::Mismatch& m : mismatches)
+            {
+                tally.fields[m.field]++;
+            }
+
+            if (reported >= maxReport)
+            {
+                continue;
+            }
+            reported++;
+
+            // Shrink while the first differing field still differs
+            const std::string field = mismatches.front().field;
+            const std::string minimal = Diff::Minimize(inputs[i], [&check, &field](const std::string& candidate)
+            {
+                for (const Diff::Mismatch& m : check.run(candidate))
+                {
+                    if (m.field == field) { return true; }
+                }
+                return false;
+            });
+
+            report << check.name << ": input " << i << " (" << inputs[i].size() << " -> " << minimal.size() << " bytes)\n";
+            for (const Diff::Mismatch& m : check.run(minimal))
+            {
+                report << "    " << m.field << ": expected '" << Printable(m.expected) << "' got '" << Printable(m.actual) << "'\n";
+            }
+            report << "    minimized: " << Printable(minimal, 400) << "\n";
+
+            if (!outDir.empty())
+            {
+                std::string name = check.name;
+                for (char& c : name)
+                {
+                    if (c == '/' || c == '(' || c == ')' || c == '*' || c == ' ') { c = '_'; }
+                }
+                std::ofstream out(outDir + "/" + name + "-" + std::to_string(i) + ".xml", std::ios::binary);
+                out.write(minimal.data(), static_cast<std::streamsize>(minimal.size()));
+            }
+        }
+
+        report << (tally.failures ? "FAIL " : "ok   ") << check.name << ": "
+                  << tally.failures << " / " << tally.inputs << " inputs differ\n";
+        for (const auto& f : tally.fields)
+        {
+            report << "    " << f.first << ": " << f.second << "\n";
+        }
+        failed = failed || tally.failures > 0;
+    }
+
+    // Reals are not messages; each value is its own minimal reproducer
+    if (numbers > 0 && (filter.empty() || std::string("numbers/ReadReal").find(filter) != std::string::npos))
+    {
+        Tally tally;
+        size_t reported = 0;
+        for (double value : NumberInputs(config.seed, numbers))
+        {
+            tally.inputs++;
+            const std::vector<Diff::Mismatch> mismatches = Diff::DiffReal(value);
+            if (mismatches.empty())
+            {
+                continue;
+            }
+
+            tally.failures++;
+            for (const Diff::Mismatch& m : mismatches)
+            {
+                tally.fields[m.field]++;
+                if (reported++ < maxReport)
+                {
+                    report << "numbers/ReadReal: " << m.field << ": expected '" << m.expected << "' got '" << m.actual << "'\n";
+                }
+            }
+        }
+
+        report << (tally.failures ? "FAIL " : "ok   ") << "numbers/ReadReal: " << tally.failures << " / " << tally.inputs << " values differ\n";
+        for (const auto& f : tally.fields)
+        {
+            report << "    " << f.first << ": " << f.second << "\n";
+        }
+        failed = failed || tally.failures > 0;
+    }
+
+    std::cout.rdbuf(stdoutBuffer);
+    std::cout.clear();
+    std::cerr.rdbuf(stderrBuffer);
+    std::cerr.clear();
+
+    return failed ? 1 : 0;
+}
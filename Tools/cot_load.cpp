@@ -0,0 +1,726 @@
+/////////////////////////////////////////////////////////////////////////////////
+// @file            cot_load.cpp
+// @brief           Latency under load. Replays generated CoT at a fixed open-loop
+//                  rate through a transport (in-process queue, loopback UDP or
+//                  TCP) into ParseCOT and a track store, and reports end-to-end
+//                  latency percentiles against offered load.
+//
+//                  Latency is measured from the time each message was scheduled
+//                  to be sent, not the time it was actually sent, so a stalled
+//                  pipeline is charged for every message it held up (coordinated
+//                  omission correction). The uncorrected figures are reported
+//                  next to them for comparison.
+// @author          Chip Brommer
+/////////////////////////////////////////////////////////////////////////////////
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Include files:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <arpa/inet.h>                  // htonl, inet_pton
+#include <netinet/in.h>                 // sockaddr_in
+#include <netinet/tcp.h>                // TCP_NODELAY
+#include <poll.h>                       // poll
+#include <sys/socket.h>                 // socket, send, recv
+#include <unistd.h>                     // close
+//
+#include <atomic>                       // atomic
+#include <cerrno>                       // errno
+#include <chrono>                       // steady_clock
+#include <cstdlib>                      // strtoull, strtod
+#include <cstring>                      // memcpy, strerror
+#include <fstream>                      // ofstream
+#include <iomanip>                      // setw
+#include <iostream>                     // cout, cerr
+#include <memory>                       // unique_ptr
+#include <sstream>                      // stringstream
+#include <thread>                       // thread
+#include <unordered_map>                // unordered_map
+//
+#include "cot_corpus.h"                 // Corpus generator
+#include "cot_metrics.h"                // Buckets, HistogramSnapshot, Gauge
+#include "cot_metrics_http.h"           // HttpServer
+#include "cot_utility.h"                // COT_Utility
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// @brief Sleep most of the way, then yield, so the schedule holds to a few
+    ///        microseconds without starving the consumer on a small machine
+    void WaitUntil(int64_t deadline)
+    {
+        for (;;)
+        {
+            const int64_t left = deadline - Now();
+            if (left <= 0)
+            {
+                return;
+            }
+            if (left > 200000)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(left - 100000));
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /// @brief Every message carries this header ahead of the XML
+    struct Header
+    {
+        uint64_t    seq;            /// Sequence number
+        int64_t     intended;       /// Scheduled send time (ns)
+        int64_t     sent;           /// Actual send time (ns)
+    };
+
+    /// @brief Latency histogram with the registry's bucket layout
+    class Recorder
+    {
+    public:
+        Recorder() { mHist.buckets.assign(Metrics::Buckets::Count, 0); }
+
+        void Record(int64_t ns)
+        {
+            const uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+            mHist.buckets[Metrics::Buckets::Index(v)]++;
+            mHist.count++;
+            mHist.sum += v;
+            if (v > mHist.max) { mHist.max = v; }
+        }
+
+        const Metrics::HistogramSnapshot& Histogram() const { return mHist; }
+
+    private:
+        Metrics::HistogramSnapshot mHist;
+    };
+
+    /// @brief Latest report of every entity, keyed by uid
+    class TrackStore
+    {
+    public:
+        TrackStore() : mTracks("load_tracks", "Entities in the load test track store") {}
+
+        void Update(const COTSchema& cot)
+        {
+            auto it = mStore.find(cot.event.uid);
+            if (it == mStore.end())
+            {
+                mStore.emplace(cot.event.uid, cot);
+                mTracks.Set(static_cast<int64_t>(mStore.size()));
+            }
+            else
+            {
+                it->second = cot;
+            }
+        }
+
+        size_t Size() const { return mStore.size(); }
+
+    private:
+        std::unordered_map<std::string, COTSchema>  mStore;
+        Metrics::Gauge                              mTracks;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Transports
+    /////////////////////////////////////////////////////////////////////////////
+
+    /// @brief One producer thread sends, one consumer thread receives
+    class Transport
+    {
+    public:
+        virtual ~Transport() {}
+
+        /// @brief Set up both ends
+        virtual bool Open(std::string& error) = 0;
+
+        /// @brief Send one message; false if it was dropped
+        virtual bool Send(std::string& message) = 0;
+
+        /// @brief Producer is done; Receive() returns false once drained
+        virtual void Finish() = 0;
+
+        /// @brief Next message, blocking; false when finished and drained
+        virtual bool Receive(std::string& message) = 0;
+    };
+
+    /// @brief In-process single producer / single consumer ring
+    class QueueTransport : public Transport
+    {
+    public:
+        explicit QueueTransport(size_t capacity)
+            : mSlots(capacity), mHead(0), mTail(0), mDone(false),
+              mDepth("load_queue_depth", "Messages waiting in the load test queue") {}
+
+        bool Open(std::string&) override { return true; }
+
+        bool Send(std::string& message) override
+        {
+            const uint64_t tail = mTail.load(std::memory_order_relaxed);
+            while (tail - mHead.load(std::memory_order_acquire) >= mSlots.size())
+            {
+                std::this_thread::yield();
+            }
+            mSlots[tail % mSlots.size()].swap(message);
+            mTail.store(tail + 1, std::memory_order_release);
+            mDepth.Set(static_cast<int64_t>(tail + 1 - mHead.load(std::memory_order_relaxed)));
+            return true;
+        }
+
+        void Finish() override { mDone.store(true, std::memory_order_release); }
+
+        bool Receive(std::string& message) override
+        {
+            const uint64_t head = mHead.load(std::memory_order_relaxed);
+            while (mTail.load(std::memory_order_acquire) == head)
+            {
+                if (mDone.load(std::memory_order_acquire) && mTail.load(std::memory_order_acquire) == head)
+                {
+                    return false;
+                }
+                std::this_thread::yield();
+            }
+            message.swap(mSlots[head % mSlots.size()]);
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::vector<std::string>    mSlots;
+        std::atomic<uint64_t>       mHead;
+        std::atomic<uint64_t>       mTail;
+        std::atomic<bool>           mDone;
+        Metrics::Gauge              mDepth;
+    };
+
+    /// @brief Loopback socket base: owns both descriptors
+    class SocketTransport : public Transport
+    {
+    public:
+        SocketTransport() : mSend(-1), mReceive(-1), mDone(false) {}
+
+        ~SocketTransport() override
+        {
+            if (mSend >= 0) { close(mSend); }
+            if (mReceive >= 0) { close(mReceive); }
+        }
+
+        void Finish() override { mDone.store(true, std::memory_order_release); }
+
+    protected:
+        static sockaddr_in Loopback(uint16_t port)
+        {
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return addr;
+        }
+
+        static bool Fail(std::string& error, const char* what)
+        {
+            error = std::string(what) + ": " + std::strerror(errno);
+            return false;
+        }
+
+        int                 mSend;
+        int                 mReceive;
+        std::atomic<bool>   mDone;
+    };
+
+    /// @brief One datagram per message. Datagrams lost to a full receive buffer are counted as lost.
+    class UdpTransport : public SocketTransport
+    {
+    public:
+        bool Open(std::string& error) override
+        {
+            mReceive = socket(AF_INET, SOCK_DGRAM, 0);
+            mSend = socket(AF_INET, SOCK_DGRAM, 0);
+            if (mReceive < 0 || mSend < 0)
+            {
+                return Fail(error, "socket");
+            }
+
+            int buffer = 8 << 20;
+            setsockopt(mReceive, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+            sockaddr_in addr = Loopback(0);
+            socklen_t len = sizeof(addr);
+            if (bind(mReceive, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+                getsockname(mReceive, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+            {
+                return Fail(error, "bind");
+            }
+            if (connect(mSend, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+            {
+                return Fail(error, "connect");
+            }
+            mBuffer.resize(65536);
+            return true;
+        }
+
+        bool Send(std::string& message) override
+        {
+            return send(mSend, message.data(), message.size(), 0) == static_cast<ssize_t>(message.size());
+        }
+
+        bool Receive(std::string& message) override
+        {
+            for (;;)
+            {
+                // Anything still in flight arrives well within the timeout once the producer stops
+                pollfd p = { mReceive, POLLIN, 0 };
+                const int ready = poll(&p, 1, 50);
+                if (ready > 0)
+                {
+                    const ssize_t n = recv(mReceive, &mBuffer[0], mBuffer.size(), 0);
+                    if (n >= 0)
+                    {
+                        message.assign(mBuffer.data(), static_cast<size_t>(n));
+                        return true;
+                    }
+                }
+                if (ready == 0 && mDone.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+            }
+        }
+
+    private:
+        std::string mBuffer;
+    };
+
+    /// @brief One connection; each message is framed with a 4-byte big-endian length
+    class TcpTransport : public SocketTransport
+    {
+    public:
+        bool Open(std::string& error) override
+        {
+            int listener = socket(AF_INET, SOCK_STREAM, 0);
+            mSend = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener < 0 || mSend < 0)
+            {
+                if (listener >= 0) { close(listener); }
+                return Fail(error, "socket");
+            }
+
+            sockaddr_in addr = Loopback(0);
+            socklen_t len = sizeof(addr);
+            bool ok = bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                      getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == 0 &&
+                      listen(listener, 1) == 0 &&
+                      connect(mSend, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            if (ok)
+            {
+                mReceive = accept(listener, nullptr, nullptr);
+                ok = mReceive >= 0;
+            }
+            if (!ok)
+            {
+                Fail(error, "loopback connection");
+                close(listener);
+                return false;
+            }
+            close(listener);
+
+            int one = 1;
+            setsockopt(mSend, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return true;
+        }
+
+        bool Send(std::string& message) override
+        {
+            const uint32_t length = htonl(static_cast<uint32_t>(message.size()));
+            mFrame.assign(reinterpret_cast<const char*>(&length), sizeof(length));
+            mFrame += message;
+
+            size_t sent = 0;
+            while (sent < mFrame.size())
+            {
+                const ssize_t n = send(mSend, mFrame.data() + sent, mFrame.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        void Finish() override
+        {
+            SocketTransport::Finish();
+            shutdown(mSend, SHUT_WR);
+        }
+
+        bool Receive(std::string& message) override
+        {
+            for (;;)
+            {
+                if (mPending.size() - mOffset >= 4)
+                {
+                    uint32_t length;
+                    std::memcpy(&length, mPending.data() + mOffset, sizeof(length));
+                    length = ntohl(length);
+                    if (mPending.size() - mOffset - 4 >= length)
+                    {
+                        message.assign(mPending, mOffset + 4, length);
+                        mOffset += 4 + length;
+                        return true;
+                    }
+                }
+
+                // Compact before reading more
+                mPending.erase(0, mOffset);
+                mOffset = 0;
+
+                char chunk[65536];
+                const ssize_t n = recv(mReceive, chunk, sizeof(chunk), 0);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                mPending.append(chunk, static_cast<size_t>(n));
+            }
+        }
+
+    private:
+        std::string mFrame;
+        std::string mPending;
+        size_t      mOffset = 0;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    // Run
+    /////////////////////////////////////////////////////////////////////////////
+
+    struct Options
+    {
+        std::vector<double> rates = { 10000 };      /// Offered loads to sweep (msg/s)
+        double              duration = 5;           /// Measured seconds per rate
+        double              warmup = 1;             /// Unmeasured seconds before each run
+        std::string         transport = "queue";    /// queue | udp | tcp
+        size_t              queueDepth = 65536;     /// Slots in the in-process queue
+        double              sloP99 = 1000;          /// p99 bound for the knee (us)
+    };
+
+    struct Row
+    {
+        double      offered = 0;
+        double      achieved = 0;
+        uint64_t    sent = 0;
+        uint64_t    received = 0;
+        uint64_t    rejected = 0;
+        size_t      tracks = 0;
+        Metrics::HistogramSnapshot corrected;
+        Metrics::HistogramSnapshot uncorrected;
+    };
+
+    std::unique_ptr<Transport> MakeTransport(const Options& o)
+    {
+        if (o.transport == "queue") { return std::unique_ptr<Transport>(new QueueTransport(o.queueDepth)); }
+        if (o.transport == "udp")   { return std::unique_ptr<Transport>(new UdpTransport()); }
+        if (o.transport == "tcp")   { return std::unique_ptr<Transport>(new TcpTransport()); }
+        return nullptr;
+    }
+
+    bool RunRate(const Options& o, double rate, const std::vector<std::string>& corpus, Row& row, std::string& error)
+    {
+        std::unique_ptr<Transport> transport = MakeTransport(o);
+        if (!transport || !transport->Open(error))
+        {
+            return false;
+        }
+
+        row.offered = rate;
+        const int64_t start = Now() + 10000000;
+        const int64_t measureFrom = start + static_cast<int64_t>(o.warmup * 1e9);
+        const int64_t end = measureFrom + static_cast<int64_t>(o.duration * 1e9);
+        const double period = 1e9 / rate;
+
+        std::atomic<uint64_t> sentMeasured(0);
+        std::thread producer([&]()
+        {
+            std::string message;
+            for (uint64_t seq = 0; ; seq++)
+            {
+                const int64_t intended = start + static_cast<int64_t>(static_cast<double>(seq) * period);
+                if (intended >= end)
+                {
+                    break;
+                }
+                WaitUntil(intended);
+
+                const std::string& xml = corpus[seq % corpus.size()];
+                Header h = { seq, intended, Now() };
+                message.assign(reinterpret_cast<const char*>(&h), sizeof(h));
+                message += xml;
+                if (transport->Send(message) && intended >= measureFrom)
+                {
+                    sentMeasured.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            transport->Finish();
+        });
+
+        // Consumer: this thread
+        COT_Utility utility;
+        TrackStore store;
+        Recorder corrected, uncorrected;
+        COTSchema cot;
+        std::string message, xml;
+        int64_t last = measureFrom;
+
+        while (transport->Receive(message))
+        {
+            if (message.size() < sizeof(Header))
+            {
+                continue;
+            }
+            Header h;
+            std::memcpy(&h, message.data(), sizeof(h));
+            xml.assign(message, sizeof(h), std::string::npos);
+
+            const bool parsed = utility.ParseCOT(xml, cot) >= 0;
+            if (parsed)
+            {
+                store.Update(cot);
+            }
+
+            const int64_t done = Now();
+            if (h.intended < measureFrom)
+            {
+                continue;
+            }
+            corrected.Record(done - h.intended);
+            uncorrected.Record(done - h.sent);
+            row.received++;
+            row.rejected += parsed ? 0 : 1;
+            last = done;
+        }
+        producer.join();
+
+        row.sent = sentMeasured.load();
+        row.tracks = store.Size();
+        row.corrected = corrected.Histogram();
+        row.uncorrected = uncorrected.Histogram();
+        const double elapsed = static_cast<double>(std::max(last, end) - measureFrom) / 1e9;
+        row.achieved = elapsed > 0 ? static_cast<double>(row.received) / elapsed : 0;
+        return true;
+    }
+
+    double Us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+    /// @brief Keeps up with offered load, loses nothing and meets the p99 bound
+    bool Healthy(const Row& r, const Options& o)
+    {
+        return r.received == r.sent && r.achieved >= 0.95 * r.offered && Us(r.corrected.Percentile(99)) <= o.sloP99;
+    }
+
+    void PrintTable(const std::vector<Row>& rows, const Options& o)
+    {
+        std::cout << "\n" << std::left << std::setw(12) << "offered/s" << std::right
+                  << std::setw(12) << "achieved/s" << std::setw(9) << "lost"
+                  << std::setw(11) << "p50 us" << std::setw(11) << "p99 us" << std::setw(11) << "p99.9 us"
+                  << std::setw(11) << "max us" << std::setw(14) << "raw p99 us" << std::setw(13) << "raw max us" << "\n";
+
+        std::cout << std::fixed;
+        for (const Row& r : rows)
+        {
+            std::cout << std::left << std::setw(12) << std::setprecision(0) << r.offered << std::right
+                      << std::setw(12) << r.achieved
+                      << std::setw(9) << (r.sent - std::min(r.sent, r.received))
+                      << std::setprecision(1)
+                      << std::setw(11) << Us(r.corrected.Percentile(50))
+                      << std::setw(11) << Us(r.corrected.Percentile(99))
+                      << std::setw(11) << Us(r.corrected.Percentile(99.9))
+                      << std::setw(11) << Us(r.corrected.max)
+                      << std::setw(14) << Us(r.uncorrected.Percentile(99))
+                      << std::setw(13) << Us(r.uncorrected.max)
+                      << (Healthy(r, o) ? "" : "  !") << "\n";
+        }
+        std::cout.unsetf(std::ios::fixed);
+
+        // Knee: the highest rate before the first unhealthy one
+        const Row* knee = nullptr;
+        const Row* broken = nullptr;
+        for (const Row& r : rows)
+        {
+            if (!Healthy(r, o)) { broken = &r; break; }
+            knee = &r;
+        }
+        std::cout << "\np99 bound " << o.sloP99 << " us; ";
+        if (broken == nullptr)
+        {
+            std::cout << "every rate met it\n";
+        }
+        else if (knee == nullptr)
+        {
+            std::cout << "the lowest rate already misses it\n";
+        }
+        else
+        {
+            std::cout << "knee between " << knee->offered << " and " << broken->offered << " msg/s\n";
+        }
+    }
+
+    bool WriteJSON(const std::string& path, const std::vector<Row>& rows, const Options& o)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            return false;
+        }
+
+        out << "{\"transport\":\"" << o.transport << "\",\"duration_s\":" << o.duration << ",\"runs\":[";
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            const Row& r = rows[i];
+            out << (i ? "," : "") << "{\"offered\":" << r.offered << ",\"achieved\":" << r.achieved
+                << ",\"sent\":" << r.sent << ",\"received\":" << r.received << ",\"rejected\":" << r.rejected
+                << ",\"tracks\":" << r.tracks
+                << ",\"p50_ns\":" << r.corrected.Percentile(50) << ",\"p99_ns\":" << r.corrected.Percentile(99)
+                << ",\"p999_ns\":" << r.corrected.Percentile(99.9) << ",\"max_ns\":" << r.corrected.max
+                << ",\"raw_p99_ns\":" << r.uncorrected.Percentile(99) << ",\"raw_max_ns\":" << r.uncorrected.max << "}";
+        }
+        out << "]}\n";
+        return true;
+    }
+
+    bool ParseRates(const std::string& text, std::vector<double>& rates)
+    {
+        rates.clear();
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            const double r = std::strtod(item.c_str(), nullptr);
+            if (r <= 0)
+            {
+                return false;
+            }
+            rates.push_back(r);
+        }
+        return !rates.empty();
+    }
+
+    void Usage(const char* name)
+    {
+        std::cerr << "Usage: " << name << " [options]\n"
+            "  --rates=R1,R2,...     offered loads to sweep in msg/s (default 10000)\n"
+            "  --duration=S          measured seconds per rate (default 5)\n"
+            "  --warmup=S            unmeasured seconds before each run (default 1)\n"
+            "  --transport=T         queue | udp | tcp (default queue)\n"
+            "  --queue-depth=N       in-process queue slots (default 65536)\n"
+            "  --slo-p99=US          p99 bound used to find the knee (default 1000)\n"
+            "  --seed=N              corpus PRNG seed (default 1)\n"
+            "  --uids=N              distinct entities (default 500)\n"
+            "  --count=N             distinct messages, replayed in a loop (default 20000)\n"
+            "  --malformed-rate=P    probability a message is broken (default 0)\n"
+            "  --json=PATH           also write the results as JSON\n"
+            "  --metrics-port=N      serve the metrics registry and gauges while running\n";
+    }
+};
+
+int main(int argc, char** argv)
+{
+    Options options;
+    Corpus::Config config;
+    size_t count = 20000;
+    std::string jsonPath;
+    int metricsPort = -1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+        bool ok = true;
+
+             if (key == "--rates")          ok = ParseRates(value, options.rates);
+        else if (key == "--duration")       options.duration = std::strtod(value.c_str(), nullptr);
+        else if (key == "--warmup")         options.warmup = std::strtod(value.c_str(), nullptr);
+        else if (key == "--transport")      options.transport = value;
+        else if (key == "--queue-depth")    options.queueDepth = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--slo-p99")        options.sloP99 = std::strtod(value.c_str(), nullptr);
+        else if (key == "--seed")           config.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "--uids")           config.uids = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (key == "--count")          count = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+        else if (key == "--malformed-rate") config.malformedRate = std::strtod(value.c_str(), nullptr);
+        else if (key == "--json")           jsonPath = value;
+        else if (key == "--metrics-port")   metricsPort = static_cast<int>(std::strtol(value.c_str(), nullptr, 10));
+        else                                ok = false;
+
+        if (!ok || options.duration <= 0 || options.queueDepth == 0 || count == 0 || !MakeTransport(options))
+        {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> corpus;
+    Corpus::Generator generator(config);
+    for (Corpus::Message& m : generator.Generate(count))
+    {
+        corpus.push_back(std::move(m.xml));
+    }
+
+    Metrics::HttpServer server;
+    if (metricsPort >= 0)
+    {
+        if (!server.Start(static_cast<uint16_t>(metricsPort)))
+        {
+            std::cerr << "ERROR: metrics endpoint: " << server.LastError() << "\n";
+            return 2;
+        }
+        std::cout << "metrics on http://127.0.0.1:" << server.Port() << "/metrics" << std::endl;
+    }
+
+    std::vector<Row> rows;
+    for (double rate : options.rates)
+    {
+        // Rejected messages make the library print a diagnostic each
+        std::streambuf* stdoutBuffer = std::cout.rdbuf(nullptr);
+        std::streambuf* stderrBuffer = std::cerr.rdbuf(nullptr);
+
+        Row row;
+        std::string error;
+        const bool ok = RunRate(options, rate, corpus, row, error);
+
+        std::cout.rdbuf(stdoutBuffer);
+        std::cout.clear();
+        std::cerr.rdbuf(stderrBuffer);
+        std::cerr.clear();
+
+        if (!ok)
+        {
+            std::cerr << "ERROR: " << options.transport << ": " << error << "\n";
+            return 2;
+        }
+        rows.push_back(row);
+        std::cout << options.transport << " @ " << rate << " msg/s: " << row.received << " received, "
+                  << row.rejected << " rejected, " << row.tracks << " tracks" << std::endl;
+    }
+
+    PrintTable(rows, options);
+
+    if (!jsonPath.empty() && !WriteJSON(jsonPath, rows, options))
+    {
+        std::cerr << "ERROR: Could not open " << jsonPath << " for writing\n";
+        return 2;
+    }
+    return 0;
+}